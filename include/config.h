@@ -13,14 +13,17 @@
 
 #include "light_ui.h"
 #include "ha_client.h"
+#include "display_driver.h"
+#include "touch_driver.h"
 
 /* ------------------------------------------------------------------ */
 /*  Constants                                                         */
 /* ------------------------------------------------------------------ */
 
-#define CONFIG_MAX_LIGHTS     16
+#define CONFIG_MAX_LIGHTS    256   /* The UI itself has no fixed limit */
 #define CONFIG_PATH_MAX      256
 #define CONFIG_WEB_PASS_MAX  128
+#define CONFIG_MAX_TIMEOUT_S 86400 /* screen_timeout is clamped to a day */
 
 /* ------------------------------------------------------------------ */
 /*  Types                                                             */
@@ -32,6 +35,9 @@ typedef struct {
     char           web_password[CONFIG_WEB_PASS_MAX];      /* plaintext pw  */
     light_config_t lights[CONFIG_MAX_LIGHTS];       /* Light definitions    */
     int            light_count;                     /* Number of lights     */
+    int            screen_timeout;                  /* Idle s, 0 = never    */
+    display_config_t display;                       /* Rotation / mirroring */
+    touch_config_t touch;                           /* Calibration / filter */
 } config_t;
 
 /* ------------------------------------------------------------------ */
@@ -44,7 +50,11 @@ typedef struct {
  * Validates:
  *   - Each entity_id is non-empty and matches <domain>.<name> format
  *   - Each label is non-empty and ≤ 31 characters
- *   - Light count ≤ 16
+ *   - Light count ≤ CONFIG_MAX_LIGHTS
+ *   - screen_timeout (optional) is ≥ 0 seconds (clamped to
+ *     CONFIG_MAX_TIMEOUT_S)
+ *   - rotation (optional) is 0, 90, 180 or 270
+ *   - touch_calibration (optional) has exactly 6 integers
  *
  * @param path  Path to JSON config file
  * @param out   Destination config struct
@@ -55,7 +65,8 @@ int config_load(const char *path, config_t *out);
 /**
  * Save configuration as valid JSON to a file.
  *
- * Preserves light ordering.
+ * Preserves light ordering. The file is replaced atomically (written
+ * to "<path>.tmp", then renamed), so readers never see a partial file.
  *
  * @param path  Path to write JSON config file
  * @param cfg   Configuration to save
@@ -63,6 +74,16 @@ int config_load(const char *path, config_t *out);
  */
 int config_save(const char *path, const config_t *cfg);
 
+/**
+ * Take / release the config file lock.
+ *
+ * Every thread that loads the file, changes part of it and saves it
+ * back (web UI save, touch calibration) holds the lock across the
+ * whole cycle, so neither loses the other's changes.
+ */
+void config_lock(void);
+void config_unlock(void);
+
 /**
  * Set the config file path used by config_reload.
  *
@@ -74,11 +95,12 @@ int config_save(const char *path, const config_t *cfg);
 void config_set_path(const char *path);
 
 /**
- * Re-read the config file and signal Light_UI to rebuild the tile grid.
+ * Re-read the config file and hand the new light list to Light_UI.
  *
- * Uses the path previously set via config_set_path.
- * On success, destroys the current UI and re-initialises with the
- * new light list. On failure, the current UI is left unchanged.
+ * Uses the path previously set via config_set_path. Safe to call off
+ * the LVGL thread: the light list goes through light_ui_update's
+ * command queue and the screen timeout is stored atomically. On
+ * failure, the current UI is left unchanged.
  *
  * @return 0 on success, -1 on error
  */
@@ -87,7 +109,8 @@ int config_reload(void);
 /**
  * Get a pointer to the current loaded configuration.
  *
- * Returns NULL if no config has been loaded via config_reload.
+ * Returns NULL if no config has been loaded via config_reload. Not
+ * synchronised: only for the thread that calls config_reload.
  *
  * @return Pointer to current config, or NULL
  */
@@ -23,15 +23,15 @@
 /**
  * Start the config server on the given port in a background thread.
  *
- * The server runs independently of the LVGL main loop. It uses the
- * provided config pointer for reading current settings and calls
+ * The server runs independently of the LVGL main loop. It keeps its
+ * own copy of the config for serving current settings and calls
  * config_save / config_reload when settings are updated via the web UI.
  *
  * @param port  TCP port to listen on (e.g. 8080)
- * @param cfg   Pointer to the current application config
+ * @param cfg   Current application config (copied)
  * @return 0 on success, -1 on failure
  */
-int config_server_start(int port, config_t *cfg);
+int config_server_start(int port, const config_t *cfg);
 
 /**
  * Stop the config server and join the background thread.
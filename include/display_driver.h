@@ -18,26 +18,110 @@
 
 #include "lvgl.h"
 
-/** Screen dimensions */
+/** Physical panel dimensions (native landscape orientation). Override
+ *  at build time (make RES=800x480) for other framebuffer displays; the
+ *  SPI backend drives a 480×320 ILI9486 only. */
+#ifndef DISP_HOR_RES
 #define DISP_HOR_RES 480
+#endif
+#ifndef DISP_VER_RES
 #define DISP_VER_RES 320
+#endif
+
+/* ------------------------------------------------------------------ */
+/*  Types                                                             */
+/* ------------------------------------------------------------------ */
+
+/** How pixels reach the panel. */
+typedef enum {
+    DISPLAY_BACKEND_FBDEV = 0,   /* Kernel fbtft framebuffer (default) */
+    DISPLAY_BACKEND_SPI          /* Direct ILI9486 over spidev         */
+} display_backend_t;
+
+/** Display orientation and output settings (loaded from config file). */
+typedef struct {
+    int  rotation;    /* Clockwise rotation: 0, 90, 180 or 270         */
+    bool mirror_h;    /* Mirror the image left-right                   */
+    bool mirror_v;    /* Mirror the image top-bottom                   */
+    char hdmi_fb[32]; /* Secondary framebuffer to mirror to, "" = off  */
+    display_backend_t backend;
+    char spi_device[64];   /* spidev node, "file:<path>" or "mem"    */
+    uint32_t spi_speed_hz; /* SPI clock, 0 = 24 MHz                  */
+    int spi_regwidth;      /* 8, or 16 for shift-register HATs       */
+} display_config_t;
+
+/* ------------------------------------------------------------------ */
+/*  Public API                                                        */
+/* ------------------------------------------------------------------ */
 
 /**
  * Initialise the ILI9486 display hardware and register with LVGL 9.x.
  *
- * Opens /dev/spidev0.0 at 24 MHz, configures GPIO pins DC=25, RST=27, BL=18,
- * runs the ILI9486 init sequence, and registers the display with LVGL via
+ * The default backend mmaps the fbtft framebuffer (/dev/fb1 or /dev/fb0).
+ * With cfg->backend == DISPLAY_BACKEND_SPI the panel is driven directly:
+ * opens cfg->spi_device (/dev/spidev0.0 at 24 MHz by default), claims
+ * GPIO DC=25, RST=27, BL=18, runs the ILI9486 init sequence and sends
+ * each flushed area as a windowed partial update (see ili9486.h).
+ * Either way the display is registered with LVGL via
  * lv_display_create() + lv_display_set_flush_cb().
  *
+ * With 90° or 270° rotation the LVGL display is created in portrait
+ * (DISP_VER_RES × DISP_HOR_RES); the flush callback maps every area onto
+ * the physical panel.
+ *
+ * If cfg->hdmi_fb names a second framebuffer, every flushed area is also
+ * scaled and format-converted into it (a damage-only replacement for
+ * fbcp). Failure to open it is logged and otherwise ignored.
+ *
+ * @param cfg  Orientation settings, or NULL for the native orientation
  * @return 0 on success, -1 on failure
  */
-int display_driver_init(void);
+int display_driver_init(const display_config_t *cfg);
+
+/**
+ * Get the logical (post-rotation) horizontal resolution seen by LVGL.
+ *
+ * @return Width in pixels
+ */
+int32_t display_driver_get_hor_res(void);
+
+/**
+ * Get the logical (post-rotation) vertical resolution seen by LVGL.
+ *
+ * @return Height in pixels
+ */
+int32_t display_driver_get_ver_res(void);
+
+/**
+ * Map a physical panel coordinate to the logical LVGL coordinate.
+ *
+ * Applies the inverse of the flush transform, so touch input stays
+ * aligned with what is drawn under any rotation or mirroring.
+ *
+ * @param x  In: physical x (0..DISP_HOR_RES-1); out: logical x
+ * @param y  In: physical y (0..DISP_VER_RES-1); out: logical y
+ */
+void display_driver_phys_to_logical(int16_t *x, int16_t *y);
+
+/**
+ * Blank or unblank the panel.
+ *
+ * Uses FBIOBLANK on the framebuffer and, where present, the sysfs
+ * backlight (/sys/class/backlight/<dev>/bl_power); the SPI backend puts
+ * the panel to sleep and switches off the BL line. Pixel memory is left
+ * untouched, so unblanking shows the last frame immediately. Blanking
+ * also saves the boot splash if the screen changed since the last save.
+ *
+ * @param blank  true to power the panel down, false to power it up
+ * @return 0 if at least one mechanism succeeded, -1 otherwise
+ */
+int display_driver_set_blank(bool blank);
 
 /**
  * De-initialise the display driver.
  *
- * Closes the SPI file descriptor, unexports GPIO pins, and turns off
- * the backlight.
+ * Unmaps the framebuffer, or for the SPI backend closes the SPI device
+ * and releases the GPIO lines.
  */
 void display_driver_deinit(void);
 
@@ -0,0 +1,47 @@
+/**
+ * event_loop.h — Deadline-driven sleep for the LVGL main loop
+ *
+ * The main thread blocks in epoll on two descriptors:
+ *   - a timerfd armed for LVGL's next timer deadline
+ *     (the return value of lv_timer_handler)
+ *   - an eventfd that any thread — or a signal handler — can poke via
+ *     event_loop_wake() when it has work for the LVGL thread
+ *
+ * So the process sleeps for as long as LVGL allows, yet reacts to a
+ * touch or a shutdown request immediately.
+ */
+
+#ifndef EVENT_LOOP_H
+#define EVENT_LOOP_H
+
+#include <stdint.h>
+
+/**
+ * Create the epoll set, timerfd and eventfd.
+ *
+ * @return 0 on success, -1 on failure
+ */
+int event_loop_init(void);
+
+/**
+ * Sleep until the timeout expires or event_loop_wake() is called.
+ *
+ * Returns early (without error) when interrupted by a signal.
+ *
+ * @param timeout_ms  Milliseconds to sleep; 0 only drains pending wakes,
+ *                    LV_NO_TIMER_READY sleeps until woken
+ */
+void event_loop_wait(uint32_t timeout_ms);
+
+/**
+ * Wake the main loop. Safe from any thread and from signal handlers
+ * (a single write() to the eventfd).
+ */
+void event_loop_wake(void);
+
+/**
+ * Close all descriptors.
+ */
+void event_loop_deinit(void);
+
+#endif /* EVENT_LOOP_H */
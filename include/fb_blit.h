@@ -0,0 +1,98 @@
+/**
+ * fb_blit.h — Framebuffer pixel copies for the flush path
+ *
+ * Places rendered areas into a linear framebuffer with the configured
+ * rotation and mirroring, and swaps red/blue for BGR-ordered
+ * framebuffers. Free of LVGL, so display_driver.c and the host
+ * benchmark (make flush-bench) run the very same code.
+ *
+ * Unrotated areas are row memcpys; rows reversed (180°, left-right
+ * mirror) are per-row pixel copies; 90°/270° areas are cache-blocked
+ * FB_BLIT_TILE×FB_BLIT_TILE transposes, with 8×8 NEON register
+ * transposes for RGB565 when built with NEON.
+ */
+
+#ifndef FB_BLIT_H
+#define FB_BLIT_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/* ------------------------------------------------------------------ */
+/*  Constants                                                         */
+/* ------------------------------------------------------------------ */
+
+#define FB_BLIT_TILE 16   /* Tile edge for blocked rotation copies (px) */
+
+/* ------------------------------------------------------------------ */
+/*  Types                                                             */
+/* ------------------------------------------------------------------ */
+
+/**
+ * Logical → framebuffer mapping. The framebuffer address of logical
+ * pixel (x, y) is fb + base + x * step_x + y * step_y.
+ */
+typedef struct {
+    uint8_t  *fb;            /* Framebuffer base (may be NULL)         */
+    uint32_t  px_bytes;      /* 2, 3 or 4                              */
+    ptrdiff_t base;
+    ptrdiff_t step_x;
+    ptrdiff_t step_y;
+    int32_t   log_w;         /* Logical (rotated) size                 */
+    int32_t   log_h;
+    bool      neon;          /* Use the NEON transpose (if built in)   */
+} fb_blit_t;
+
+/* ------------------------------------------------------------------ */
+/*  Public API                                                        */
+/* ------------------------------------------------------------------ */
+
+/**
+ * Compute the logical size and the logical → framebuffer mapping.
+ *
+ * Mirroring is applied to the logical image first, then the clockwise
+ * rotation. Each physical coordinate is ±x ±y + const of the logical
+ * one, so the whole transform collapses into three byte offsets.
+ *
+ * @param b            Mapping to fill in
+ * @param fb           Framebuffer base
+ * @param line_length  Framebuffer bytes per scanline
+ * @param px_bytes     Bytes per pixel (2, 3 or 4)
+ * @param pw, ph       Physical panel size in pixels
+ * @param rotation     Clockwise rotation: 0, 90, 180 or 270
+ * @param mirror_h     Mirror left-right
+ * @param mirror_v     Mirror top-bottom
+ */
+void fb_blit_setup(fb_blit_t *b, uint8_t *fb, uint32_t line_length,
+                   uint32_t px_bytes, int32_t pw, int32_t ph, int rotation,
+                   bool mirror_h, bool mirror_v);
+
+/**
+ * Copy a rendered area into the framebuffer with b's transform.
+ *
+ * @param b       Mapping from fb_blit_setup()
+ * @param px      Rendered pixels for the area (row-major, w×h)
+ * @param x1, y1  Top-left logical pixel (inclusive)
+ * @param x2, y2  Bottom-right logical pixel (inclusive)
+ */
+void fb_blit_area(const fb_blit_t *b, const uint8_t *px, int32_t x1,
+                  int32_t y1, int32_t x2, int32_t y2);
+
+/**
+ * Swap red and blue in place, for BGR-ordered framebuffers.
+ *
+ * @param px        Pixels to convert (scratch memory)
+ * @param count     Number of pixels
+ * @param px_bytes  Bytes per pixel (2, 3 or 4)
+ */
+void fb_blit_swap_rb(uint8_t *px, uint32_t count, uint32_t px_bytes);
+
+/**
+ * Whether the NEON transpose was built in (__ARM_NEON).
+ *
+ * @return true if fb_blit_t.neon can take effect
+ */
+bool fb_blit_have_neon(void);
+
+#endif /* FB_BLIT_H */
@@ -2,8 +2,9 @@
  * ha_client.h — Home Assistant REST API client using libcurl
  *
  * Communicates with Home Assistant to fetch light states and toggle lights.
- * Maintains a single reusable CURL handle for connection reuse.
- * All HTTP calls are synchronous (blocking).
+ * Maintains reusable CURL handles for connection reuse. ha_get_state
+ * is synchronous (blocking); polling and toggles run on the client's
+ * own thread (ha_poll_start), so ha_toggle_light only queues.
  *
  * Error handling:
  *   - libcurl connection errors: logged to stderr, last known states retained
@@ -53,30 +54,53 @@ int ha_client_init(const char *base_url, const char *token);
 light_state_t ha_get_state(const char *entity_id);
 
 /**
- * Toggle a light by sending the opposite service call.
+ * Queue a toggle of a light. Any thread; does not block.
  *
- * Fetches current state, then POSTs to turn_on or turn_off.
- * On failure: returns -1; optimistic state reverts on next poll.
+ * The poll thread sends it as soon as it is between requests: it
+ * fetches the current state, then POSTs to turn_on or turn_off.
+ * A failed request is only logged; the optimistic state reverts on the
+ * next poll.
  *
  * @param entity_id  HA entity ID
- * @return 0 on success, -1 on failure
+ * @return 0 if queued, -1 if the poll thread is not running or the
+ *         queue is full
  */
 int ha_toggle_light(const char *entity_id);
 
 /**
- * Poll all configured lights and update the UI.
+ * Start polling lights on a background thread: at once, then every
+ * interval_ms, and again as soon as the list changes.
+ *
+ * Each poll fetches every light's state and reports it through
+ * light_ui_set_state. On connection error, retains last known tile
+ * states (skips the UI update for that entity). If the server cannot
+ * be reached at all the poll stops early and reports it through
+ * light_ui_set_offline(true); any answer reports it back online.
+ *
+ * Call after ha_client_init. ha_client_cleanup stops the thread.
+ *
+ * @param lights       Array of light configurations (copied)
+ * @param count        Number of lights
+ * @param interval_ms  Time between polls
+ * @return 0 on success, -1 on failure
+ */
+int ha_poll_start(const light_config_t *lights, int count,
+                  unsigned interval_ms);
+
+/**
+ * Replace the list of lights to poll. Any thread.
  *
- * For each light, fetches state via ha_get_state and calls
- * light_ui_set_state. On connection error, retains last known
- * tile states (skips ui update for that entity).
+ * Wakes the poll thread, so lights just added get their state without
+ * waiting for the next interval.
  *
- * @param lights  Array of light configurations
+ * @param lights  Array of light configurations (copied)
  * @param count   Number of lights
  */
-void ha_poll_all(const light_config_t *lights, int count);
+void ha_poll_set_lights(const light_config_t *lights, int count);
 
 /**
- * Free the CURL handle and associated resources.
+ * Stop the poll thread and free the CURL handles and associated
+ * resources.
  */
 void ha_client_cleanup(void);
 
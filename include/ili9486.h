@@ -0,0 +1,175 @@
+/**
+ * ili9486.h — Direct ILI9486 panel protocol over a pluggable transport
+ *
+ * Drives the panel without fbtft: every flushed area becomes one
+ * CASET/RASET address window followed by a RAMWR of just that area's
+ * pixels, streamed in chunks no larger than the transport's transfer
+ * limit (spidev's bufsiz).
+ *
+ * The byte stream goes through an ili9486_transport_t, so the same
+ * encoder can target:
+ *   - spidev   : /dev/spidev0.0 plus DC/RST/BL lines via the GPIO
+ *                character device (the real panel)
+ *   - file sink: every transfer appended to a file
+ *   - mem sink : every transfer kept in a memory buffer
+ *
+ * The sinks record each transfer as a 5-byte header — one byte DC
+ * (0 = command, 1 = data) and a little-endian uint32 length — followed
+ * by the payload, so command encoding and chunk boundaries can be
+ * checked and benchmarked off-device.
+ *
+ * Supported wiring: the ILI9486 on 4-wire SPI with a separate DC line.
+ * By default commands and parameters are single bytes, as for a
+ * controller in its native serial mode (fbtft regwidth=8). The
+ * Waveshare 3.5" (A) and PiScreen HATs put a 16-bit shift register in
+ * front of the controller, which fbtft drives with regwidth=16; set
+ * reg16 for those and every command and parameter byte goes out as a
+ * 16-bit word. Pixels are big-endian RGB565 words either way. Only the
+ * byte stream has been checked (make check-ili9486), not the modules.
+ */
+
+#ifndef ILI9486_H
+#define ILI9486_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/* ------------------------------------------------------------------ */
+/*  Constants                                                         */
+/* ------------------------------------------------------------------ */
+
+#define ILI9486_MAX_ARGS 16   /* Longest parameter list of a command */
+
+/* ------------------------------------------------------------------ */
+/*  Types                                                             */
+/* ------------------------------------------------------------------ */
+
+typedef struct ili9486_transport ili9486_transport_t;
+
+/**
+ * Byte transport to the panel. Implementations embed this as their
+ * first member; optional hooks may be NULL.
+ */
+struct ili9486_transport {
+    /** Send one transfer with DC low (command) or high (data). */
+    int  (*write)(ili9486_transport_t *t, bool data, const uint8_t *buf,
+                  size_t len);
+    /** Pulse the hardware reset line (optional). */
+    void (*reset)(ili9486_transport_t *t);
+    /** Switch the backlight (optional). */
+    void (*backlight)(ili9486_transport_t *t, bool on);
+    /** Release all resources, including t itself. */
+    void (*close)(ili9486_transport_t *t);
+
+    size_t   max_xfer;      /* Largest single transfer in bytes       */
+    bool     reg16;         /* Commands/parameters as 16-bit words    */
+    uint64_t xfer_count;    /* Transfers sent since open              */
+    uint64_t byte_count;    /* Payload bytes sent since open          */
+
+    /* Last address window sent on this transport, so an unchanged
+     * window is not resent; -1 = unknown (after open, init or error) */
+    int32_t  win_x1, win_y1, win_x2, win_y2;
+};
+
+/* ------------------------------------------------------------------ */
+/*  Transports                                                        */
+/* ------------------------------------------------------------------ */
+
+/**
+ * Open a transport from a device spec.
+ *
+ *   "mem"          memory sink (see ili9486_mem_sink_data)
+ *   "file:<path>"  file sink, truncated on open
+ *   anything else  spidev device node, e.g. "/dev/spidev0.0"
+ *
+ * @param spec      Device spec as above
+ * @param speed_hz  SPI clock (spidev only; 0 = 24 MHz)
+ * @return Transport, or NULL on failure (logged)
+ */
+ili9486_transport_t *ili9486_transport_open(const char *spec,
+                                            uint32_t speed_hz);
+
+/**
+ * Get the bytes recorded by a memory sink so far.
+ *
+ * Recording stops for good (but counters keep running) at the first
+ * transfer that does not fit, so the recording never has gaps;
+ * ili9486_mem_sink_clear() starts it again.
+ *
+ * @param t    Transport returned for the "mem" spec
+ * @param len  Receives the recorded length in bytes
+ * @return Recorded stream, or NULL if t is not a memory sink
+ */
+const uint8_t *ili9486_mem_sink_data(ili9486_transport_t *t, size_t *len);
+
+/**
+ * Discard everything a memory sink has recorded.
+ *
+ * @param t  Transport returned for the "mem" spec
+ */
+void ili9486_mem_sink_clear(ili9486_transport_t *t);
+
+/* ------------------------------------------------------------------ */
+/*  Panel protocol                                                    */
+/* ------------------------------------------------------------------ */
+
+/**
+ * Compute MADCTL for an orientation relative to the 480×320 landscape
+ * layout, so the controller does rotation and mirroring in hardware.
+ *
+ * @param rotation  Clockwise rotation: 0, 90, 180 or 270
+ * @param mirror_h  Mirror left-right
+ * @param mirror_v  Mirror top-bottom
+ * @return MADCTL register value (BGR order included)
+ */
+uint8_t ili9486_madctl(int rotation, bool mirror_h, bool mirror_v);
+
+/**
+ * Reset the panel and run the init sequence (RGB565, given MADCTL,
+ * display on, backlight on).
+ *
+ * @param t       Transport
+ * @param madctl  Value from ili9486_madctl()
+ * @return 0 on success, -1 on a transport error
+ */
+int ili9486_init(ili9486_transport_t *t, uint8_t madctl);
+
+/**
+ * Write one rectangle of RGB565 pixels.
+ *
+ * The pixels are byte-swapped IN PLACE to the panel's big-endian order,
+ * so px must be scratch memory (e.g. the LVGL draw buffer). The address
+ * window is only resent when it differs from the previous call on the
+ * same transport.
+ *
+ * @param t   Transport
+ * @param x1  Left column (inclusive)
+ * @param y1  Top row (inclusive)
+ * @param x2  Right column (inclusive)
+ * @param y2  Bottom row (inclusive)
+ * @param px  (x2-x1+1)*(y2-y1+1) little-endian RGB565 pixels
+ * @return 0 on success, -1 on a transport error
+ */
+int ili9486_write_area(ili9486_transport_t *t, int32_t x1, int32_t y1,
+                       int32_t x2, int32_t y2, uint8_t *px);
+
+/**
+ * Put the panel to sleep (display off, backlight off) or wake it.
+ *
+ * Panel RAM is retained, so waking shows the last frame.
+ *
+ * @param t      Transport
+ * @param sleep  true to sleep, false to wake
+ * @return 0 on success, -1 on a transport error
+ */
+int ili9486_sleep(ili9486_transport_t *t, bool sleep);
+
+/**
+ * Close a transport (any kind).
+ *
+ * @param t  Transport, may be NULL
+ */
+void ili9486_close(ili9486_transport_t *t);
+
+#endif /* ILI9486_H */
@@ -1,12 +1,20 @@
 /**
  * light_ui.h — Light tile grid UI for LVGL 9.x
  *
- * Renders a paginated 2×2 grid of light tiles on a 480×320 display.
- * Each tile shows a light's label, icon, and ON/OFF/UNKNOWN state
- * with corresponding colour scheme.
+ * Renders paginated light tiles: a 2×2, 3×2 or 3×3 grid or a compact
+ * list, chosen at build time (make LAYOUT=...). Each tile shows a
+ * light's label, icon, and ON/OFF/UNKNOWN state with corresponding
+ * colour scheme.
  *
  * Uses ONLY LVGL 9.x APIs.
  *
+ * Threads: light_ui_init, light_ui_process, light_ui_destroy and the
+ * getters belong to the LVGL thread. The setters (light_ui_update,
+ * light_ui_set_state, light_ui_set_offline, light_ui_set_page and
+ * light_ui_set_toggle_cb) may be called from any thread: they only
+ * queue a command on a lock-free queue and wake the main loop, and
+ * light_ui_process applies the commands in order once per frame.
+ *
  * Requirements: 3.1, 3.2, 3.3, 3.4, 3.5, 3.6
  */
 
@@ -14,14 +22,40 @@
 #define LIGHT_UI_H
 
 #include "lvgl.h"
+#include <stdbool.h>
 #include <stdint.h>
 
 /* ------------------------------------------------------------------ */
 /*  Constants                                                         */
 /* ------------------------------------------------------------------ */
 
-#define LIGHT_MAX_COUNT   16   /* Maximum number of lights (4 pages)  */
-#define LIGHT_PER_PAGE     4   /* 2×2 grid per page                   */
+/* Layouts, selected with -DLIGHT_UI_LAYOUT (the Makefile's LAYOUT) */
+#define LIGHT_UI_LAYOUT_2X2   0   /* 2 columns × 2 rows (default)      */
+#define LIGHT_UI_LAYOUT_3X2   1   /* 3 columns × 2 rows                */
+#define LIGHT_UI_LAYOUT_3X3   2   /* 3 columns × 3 rows                */
+#define LIGHT_UI_LAYOUT_LIST  3   /* One column of 5 short rows        */
+
+#ifndef LIGHT_UI_LAYOUT
+#define LIGHT_UI_LAYOUT LIGHT_UI_LAYOUT_2X2
+#endif
+
+#if LIGHT_UI_LAYOUT == LIGHT_UI_LAYOUT_2X2
+#define LIGHT_UI_COLS      2
+#define LIGHT_UI_ROWS      2
+#elif LIGHT_UI_LAYOUT == LIGHT_UI_LAYOUT_3X2
+#define LIGHT_UI_COLS      3
+#define LIGHT_UI_ROWS      2
+#elif LIGHT_UI_LAYOUT == LIGHT_UI_LAYOUT_3X3
+#define LIGHT_UI_COLS      3
+#define LIGHT_UI_ROWS      3
+#elif LIGHT_UI_LAYOUT == LIGHT_UI_LAYOUT_LIST
+#define LIGHT_UI_COLS      1
+#define LIGHT_UI_ROWS      5
+#else
+#error "light_ui.h: unknown LIGHT_UI_LAYOUT"
+#endif
+
+#define LIGHT_PER_PAGE     (LIGHT_UI_COLS * LIGHT_UI_ROWS)
 
 /* ------------------------------------------------------------------ */
 /*  Types                                                             */
@@ -46,6 +80,7 @@ typedef struct {
     light_state_t state;          /* Current confirmed state           */
     light_state_t optimistic;     /* State shown after tap, pre-confirm*/
     uint32_t      last_updated_ms;/* Timestamp of last successful poll */
+    uint32_t      unknown_since_ms;/* When it last became UNKNOWN     */
 } light_runtime_t;
 
 /** Callback invoked when a tile is tapped. */
@@ -60,26 +95,64 @@ typedef void (*light_toggle_cb_t)(const char *entity_id,
  * Initialise the light UI with a list of lights.
  *
  * Creates a full-screen container with horizontally arranged pages,
- * each holding a 2×2 grid of tiles. All tiles start in UNKNOWN state.
+ * each holding LIGHT_PER_PAGE tiles. All tiles start in UNKNOWN state.
+ * Only the current page and its neighbours have LVGL objects, so any
+ * number of lights costs the same LVGL heap.
  *
- * @param lights  Array of light configurations
- * @param count   Number of lights (clamped to LIGHT_MAX_COUNT)
+ * @param lights  Array of light configurations (copied)
+ * @param count   Number of lights
  */
 void light_ui_init(const light_config_t *lights, int count);
 
 /**
- * Update a tile's visual state.
+ * Apply a new light list to the running UI. Any thread.
  *
- * Called from the HA poll callback to reconcile tile appearance
- * with the confirmed state from Home Assistant.
+ * Lights are matched by entity_id: runtime state follows its entity to
+ * its new position, and only the live tiles whose light changed are
+ * rebound. The current page is kept (clamped to the new page count).
+ * Falls back to a full rebuild when switching to or from the setup
+ * screen.
  *
- * @param index  Tile index (0-based)
- * @param state  New confirmed state
+ * @param lights  Array of light configurations (copied before return)
+ * @param count   Number of lights
+ */
+void light_ui_update(const light_config_t *lights, int count);
+
+/**
+ * Apply every queued command. Call once per main loop iteration on
+ * the LVGL thread, before lv_timer_handler().
+ */
+void light_ui_process(void);
+
+/**
+ * Update a light's visual state. Any thread.
+ *
+ * Called from the HA poll thread to reconcile tile appearance with the
+ * confirmed state from Home Assistant. The light is looked up by
+ * entity when the change is applied, so it lands on the right tile
+ * even if a light_ui_update reordered the list in the meantime; an
+ * entity no longer shown is ignored.
+ *
+ * @param entity_id  HA entity ID of the light
+ * @param state      New confirmed state
+ */
+void light_ui_set_state(const char *entity_id, light_state_t state);
+
+/**
+ * Report whether Home Assistant is reachable. Any thread.
+ *
+ * While offline a single indicator is shown on the screen and UNKNOWN
+ * tiles show a static stale mark instead of an animated spinner, so
+ * nothing redraws while waiting for the server.
+ *
+ * @param offline  true after a connection failure, false once a
+ *                 request succeeds again
  */
-void light_ui_set_state(int index, light_state_t state);
+void light_ui_set_offline(bool offline);
 
 /**
- * Register a callback invoked when the user taps a tile.
+ * Register a callback invoked when the user taps a tile. Any thread;
+ * the callback itself runs on the LVGL thread.
  *
  * @param cb  Toggle callback function
  */
@@ -88,7 +161,8 @@ void light_ui_set_toggle_cb(light_toggle_cb_t cb);
 /**
  * Destroy the light UI and free all resources.
  *
- * Removes the screen object and resets internal state.
+ * Removes the screen object and resets internal state. Commands still
+ * queued are discarded.
  */
 void light_ui_destroy(void);
 
@@ -117,8 +191,12 @@ const light_runtime_t *light_ui_get_runtime(int index);
 /**
  * Get the LVGL object for a tile.
  *
+ * Tile objects are pooled and rebound as pages move, so the pointer is
+ * only valid until the next page change.
+ *
  * @param index  Tile index (0-based)
  * @return Pointer to the tile's lv_obj, or NULL if index is out of range
+ *         or its page currently has no live objects
  */
 lv_obj_t *light_ui_get_tile_obj(int index);
 
@@ -130,7 +208,7 @@ lv_obj_t *light_ui_get_tile_obj(int index);
 lv_obj_t *light_ui_get_container(void);
 
 /**
- * Navigate to a specific page with animation.
+ * Navigate to a specific page with animation. Any thread.
  *
  * Clamps the page index to [0, page_count - 1]. Animates the
  * page container to show the target page and updates indicator dots.
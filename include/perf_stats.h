@@ -0,0 +1,98 @@
+/**
+ * perf_stats.h — Lightweight on-device performance counters
+ *
+ * Fixed-bucket histograms that the display, touch and UI modules record
+ * into so frame costs can be compared between builds on real hardware
+ * without attaching a profiler. All metrics are dumped to stderr (and
+ * reset) on SIGUSR1 and once more at shutdown:
+ *
+ *   sudo systemctl kill -s USR1 ha-pi && journalctl -u ha-pi -n 20
+ *
+ * Recording is cheap (one clock read and a few adds) and is only done
+ * from the LVGL thread, so no locking is needed.
+ */
+
+#ifndef PERF_STATS_H
+#define PERF_STATS_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/* ------------------------------------------------------------------ */
+/*  Types                                                             */
+/* ------------------------------------------------------------------ */
+
+/** Metrics tracked by the histogram table. */
+typedef enum {
+    PERF_FLUSH_US = 0,      /* One disp_flush_cb call (µs)            */
+    PERF_FRAME_FLUSH_US,    /* All flushes of one refresh cycle (µs)  */
+    PERF_TOUCH_TO_FLUSH_US, /* Finger down → tap result flushed (µs)  */
+    PERF_RENDER_US,         /* One refresh cycle that drew (µs)       */
+    PERF_STATE_RENDER_US,   /* Refresh cycle showing a state change   */
+    PERF_FRAME_PX,          /* Pixels redrawn in one refresh cycle    */
+    PERF_METRIC_COUNT
+} perf_metric_t;
+
+/* ------------------------------------------------------------------ */
+/*  Public API                                                        */
+/* ------------------------------------------------------------------ */
+
+/**
+ * Monotonic microsecond clock used for all timings.
+ *
+ * @return Microseconds since an arbitrary fixed point
+ */
+uint64_t perf_now_us(void);
+
+/**
+ * Add one sample to a metric's histogram.
+ *
+ * @param metric  Metric to record into
+ * @param value   Sample value in the metric's unit
+ */
+void perf_record(perf_metric_t metric, uint32_t value);
+
+/**
+ * Start an end-to-end latency measurement from an input timestamp.
+ *
+ * The next perf_input_flushed() records the time since input_us into
+ * PERF_TOUCH_TO_FLUSH_US. A newer mark replaces a pending one.
+ *
+ * @param input_us  Input event time on the perf_now_us() clock
+ */
+void perf_input_mark(uint64_t input_us);
+
+/**
+ * Complete a pending latency measurement. Called by the display driver
+ * when the last area of a refresh has been written out.
+ */
+void perf_input_flushed(void);
+
+/**
+ * Flag a UI state change. The next refresh cycle to start is also
+ * recorded into PERF_STATE_RENDER_US. Repeated marks before that
+ * refresh collapse into one.
+ */
+void perf_state_mark(void);
+
+/**
+ * Start timing a refresh cycle. Called by the display driver on
+ * LV_EVENT_REFR_START.
+ */
+void perf_frame_start(void);
+
+/**
+ * Finish timing a refresh cycle (LV_EVENT_REFR_READY). Cycles that
+ * drew nothing are not recorded.
+ *
+ * @param drawn  true if the cycle flushed at least one area
+ */
+void perf_frame_done(bool drawn);
+
+/**
+ * Log every non-empty metric (count, mean, p50/p90/p99, max) to stderr
+ * and reset all histograms.
+ */
+void perf_report(void);
+
+#endif /* PERF_STATS_H */
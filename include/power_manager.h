@@ -0,0 +1,56 @@
+/**
+ * power_manager.h — Idle blanking for the display
+ *
+ * Sits on top of the display and touch drivers. After a configurable
+ * period with no touch input the panel is blanked (FBIOBLANK plus the
+ * sysfs backlight) and LVGL rendering is suspended. The first touch
+ * wakes the panel and is swallowed, so waking the screen never toggles
+ * a light by accident.
+ */
+
+#ifndef POWER_MANAGER_H
+#define POWER_MANAGER_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/**
+ * Start the idle controller.
+ *
+ * Must be called after display_driver_init() and touch_driver_init().
+ * Creates an LVGL timer that watches the display's inactivity time.
+ *
+ * @param timeout_s  Seconds of inactivity before blanking, 0 = never
+ */
+void power_manager_init(uint32_t timeout_s);
+
+/**
+ * Change the inactivity timeout.
+ *
+ * Only stores the value, so it is safe to call from any thread; the
+ * idle timer picks it up on its next tick.
+ *
+ * @param timeout_s  Seconds of inactivity before blanking, 0 = never
+ */
+void power_manager_set_timeout(uint32_t timeout_s);
+
+/**
+ * Whether the panel is currently blanked.
+ *
+ * @return true while blanked
+ */
+bool power_manager_is_blanked(void);
+
+/**
+ * Unblank the panel and resume rendering (no-op if awake).
+ *
+ * Must be called from the LVGL thread.
+ */
+void power_manager_wake(void);
+
+/**
+ * Stop the idle timer and make sure the panel is left unblanked.
+ */
+void power_manager_deinit(void);
+
+#endif /* POWER_MANAGER_H */
@@ -0,0 +1,54 @@
+/**
+ * touch_calibrate.h — On-screen 3-point touchscreen calibration
+ *
+ * Shows a crosshair at three known panel positions on LVGL's top layer,
+ * records the raw touch coordinates for each tap and solves the 2×3
+ * affine matrix mapping raw coordinates to panel pixels. Handles any
+ * digitizer rotation, mirroring, scale and offset.
+ */
+
+#ifndef TOUCH_CALIBRATE_H
+#define TOUCH_CALIBRATE_H
+
+#include <stdint.h>
+
+#include "touch_driver.h"
+
+/**
+ * Called once a calibration succeeds. The matrix is already active in
+ * the touch driver; the callback only needs to persist it.
+ *
+ * @param calib   Q16 matrix (layout as in touch_config_t)
+ * @param device  Controller the taps came from (touch_config_t.device)
+ */
+typedef void (*touch_calibrate_done_cb_t)(const int32_t calib[6],
+                                          const char *device);
+
+/**
+ * Start the calibration routine on top of the current screen.
+ *
+ * Must be called from the LVGL thread after display and touch init.
+ *
+ * @param done_cb  Completion callback, may be NULL
+ * @return 0 on success, -1 if the overlay could not be created
+ */
+int touch_calibrate_start(touch_calibrate_done_cb_t done_cb);
+
+/**
+ * Solve the Q16 raw → panel matrix from three point pairs.
+ *
+ * Rejects taps that cover under 15 % of the targets' share of
+ * the surface (relative to dev's axis ranges), and matrices that map
+ * the digitizer's corners far outside the panel.
+ *
+ * @param raw    Raw controller coordinates of the three taps
+ * @param panel  Panel pixel coordinates of the three targets
+ * @param dev    Axis ranges of the controller the taps came from
+ * @param calib  Receives the Q16 matrix
+ * @return 0 on success, -1 if the taps are too close or (nearly)
+ *         collinear, -2 if the matrix would map off the panel
+ */
+int touch_calibrate_solve(const int32_t raw[3][2], const int32_t panel[3][2],
+                          const touch_device_info_t *dev, int32_t calib[6]);
+
+#endif /* TOUCH_CALIBRATE_H */
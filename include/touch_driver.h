@@ -2,7 +2,8 @@
  * touch_driver.h — Touchscreen driver for LVGL 9.x
  *
  * Reads touch events from the Linux input subsystem (/dev/input/eventX).
- * Auto-detects the touchscreen device by scanning for ABS_X capability.
+ * Auto-detects touchscreen devices by scanning for ABS_X capability and
+ * follows hotplug, merging several devices into one LVGL pointer.
  * Works with kernel-managed touch controllers (e.g. XPT2046 via fbtft/LCD-show).
  *
  * Uses ONLY LVGL 9.x APIs (no v8 functions).
@@ -15,16 +16,160 @@
 
 #include "lvgl.h"
 
+/* ------------------------------------------------------------------ */
+/*  Types                                                             */
+/* ------------------------------------------------------------------ */
+
+#define TOUCH_DEVICE_ID_MAX 96   /* "vvvv:pppp <EVIOCGNAME>" */
+
+/**
+ * Touch settings (loaded from config file).
+ *
+ * calib maps raw controller coordinates to physical panel pixels in Q16
+ * fixed point:
+ *   x = (calib[0]*raw_x + calib[1]*raw_y + calib[2]) >> 16
+ *   y = (calib[3]*raw_x + calib[4]*raw_y + calib[5]) >> 16
+ *
+ * It only applies to the controller named by device; every other
+ * touchscreen keeps the default derived from its own axis ranges.
+ */
+typedef struct {
+    int32_t calib[6];
+    bool    calibrated;   /* calib is valid; else derived from axis ranges */
+    bool    filter;       /* Median-of-3 jitter filter on raw samples     */
+    char    device[TOUCH_DEVICE_ID_MAX];  /* calib's controller, "" = first found */
+} touch_config_t;
+
+/** Identity and axis ranges of the controller a sample came from. */
+typedef struct {
+    char    id[TOUCH_DEVICE_ID_MAX];   /* Vendor:product and name */
+    int32_t abs_x_min, abs_x_max;
+    int32_t abs_y_min, abs_y_max;
+} touch_device_info_t;
+
+/** Input source options (from the command line). */
+typedef struct {
+    const char *record_path;   /* Record the raw evdev stream, NULL = off  */
+    const char *replay_path;   /* Replay a recording instead of a device   */
+    double      replay_speed;  /* Replay speed factor, <= 0 means 1.0      */
+} touch_options_t;
+
 /**
  * Initialise the touchscreen and register with LVGL 9.x.
  *
- * Scans /dev/input/event* for a device with ABS_X capability,
- * starts an event reading thread, and registers the input device
- * via lv_indev_create() + lv_indev_set_type(LV_INDEV_TYPE_POINTER).
+ * Opens every /dev/input/event* device with ABS_X capability, starts
+ * an event reading thread that also watches /dev/input for devices
+ * being added or re-enumerated, and registers the input device via
+ * lv_indev_create() + lv_indev_set_type(LV_INDEV_TYPE_POINTER).
+ * Succeeds with no touchscreen present as long as hotplug can be
+ * watched. event_loop_init() must have been called first.
  *
+ * With opts->record_path the first device's events are also written to
+ * that file (a device is then required). With opts->replay_path no
+ * device is opened: the recording is played back into LVGL instead.
+ *
+ * @param opts  Record / replay options, or NULL for plain device input
+ * @param cfg   Calibration / filter settings, or NULL for defaults
  * @return 0 on success, -1 on failure
  */
-int touch_driver_init(void);
+int touch_driver_init(const touch_options_t *opts,
+                      const touch_config_t *cfg);
+
+/**
+ * Raw (uncalibrated, filtered) controller coordinates of the sample
+ * LVGL last processed. Used by the calibration routine.
+ *
+ * @param raw_x  Receives the raw X value
+ * @param raw_y  Receives the raw Y value
+ */
+void touch_driver_get_raw(int32_t *raw_x, int32_t *raw_y);
+
+/**
+ * Describe the controller that produced the sample LVGL last processed,
+ * so raw coordinates can be judged against its axis ranges and a
+ * calibration tied to it.
+ *
+ * @param info  Receives the device's identity and axis ranges
+ * @return true on success, false if that device has gone away
+ */
+bool touch_driver_get_source(touch_device_info_t *info);
+
+/**
+ * Replace the raw → panel matrix. Takes effect from the next sample.
+ * Must be called from the LVGL thread.
+ *
+ * @param calib   Q16 matrix, layout as in touch_config_t
+ * @param device  Controller it applies to (touch_device_info_t.id)
+ */
+void touch_driver_set_calibration(const int32_t calib[6], const char *device);
+
+/**
+ * Feed new touch input to LVGL.
+ *
+ * The input device runs in LV_INDEV_MODE_EVENT, so LVGL never polls it;
+ * the main loop calls this after every wake (the touch thread wakes it
+ * via event_loop_wake()). Must be called from the LVGL thread.
+ *
+ * @return true while the pointer is held down — the caller should keep
+ *         waking at frame rate so long-press and drag timing advance
+ */
+bool touch_driver_process(void);
+
+/**
+ * Kernel timestamp of the finger-down that started the press LVGL is
+ * currently processing (or last processed).
+ *
+ * Valid inside LVGL input event callbacks such as LV_EVENT_CLICKED, and
+ * on the same monotonic clock as perf_now_us().
+ *
+ * @return Microseconds, or 0 if unknown (the device could not be
+ *         switched to monotonic timestamps)
+ */
+uint64_t touch_driver_press_time_us(void);
+
+/**
+ * Wake filter, called on the LVGL thread when a new press starts.
+ *
+ * Returning true swallows the press: LVGL sees the pointer as released
+ * until the finger lifts.
+ */
+typedef bool (*touch_wake_filter_t)(void);
+
+/**
+ * Install (or clear, with NULL) the press filter used for wake-on-touch.
+ *
+ * @param filter  Filter callback, or NULL to deliver every press
+ */
+void touch_driver_set_wake_filter(touch_wake_filter_t filter);
+
+/**
+ * Swipe callback, called on the LVGL thread as soon as a press crosses
+ * the swipe thresholds — before the finger lifts.
+ *
+ * @param dir  LV_DIR_LEFT / LV_DIR_RIGHT / LV_DIR_TOP / LV_DIR_BOTTOM,
+ *             the direction the finger moved
+ */
+typedef void (*touch_gesture_cb_t)(lv_dir_t dir);
+
+/**
+ * Install (or clear, with NULL) the swipe callback.
+ *
+ * Swipes are recognised in the touch thread from every controller
+ * sample and its kernel timestamp, instead of from the positions LVGL
+ * happens to read. Once a swipe is delivered the rest of the press is
+ * hidden from LVGL (no click or scroll on release).
+ *
+ * @param cb  Callback, or NULL to disable swipe delivery
+ */
+void touch_driver_set_gesture_cb(touch_gesture_cb_t cb);
+
+/**
+ * The installed swipe callback, so a caller that clears it for a while
+ * (touch calibration) can put it back.
+ *
+ * @return Current callback, or NULL
+ */
+touch_gesture_cb_t touch_driver_get_gesture_cb(void);
 
 /**
  * De-initialise the touch driver.
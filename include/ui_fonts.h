@@ -0,0 +1,31 @@
+/**
+ * ui_fonts.h — Fonts used by the UI
+ *
+ * By default these are LVGL's built-in Montserrat 16/24/32, which carry
+ * all of printable ASCII plus every LV_SYMBOL_* glyph. A SUBSET_FONTS=1
+ * build uses the tables that `make fonts` generates into src/fonts/
+ * instead (tools/gen_fonts.py): only the glyphs the UI strings and the
+ * configured lights need, with LV_FONT_DEFAULT as the fallback for any
+ * other glyph (e.g. a label added later from the web config).
+ */
+
+#ifndef UI_FONTS_H
+#define UI_FONTS_H
+
+#include "lvgl.h"
+
+#ifdef UI_SUBSET_FONTS
+LV_FONT_DECLARE(ui_subset_16)
+LV_FONT_DECLARE(ui_subset_24)
+LV_FONT_DECLARE(ui_subset_32)
+
+#define UI_FONT_16 (&ui_subset_16)
+#define UI_FONT_24 (&ui_subset_24)
+#define UI_FONT_32 (&ui_subset_32)
+#else
+#define UI_FONT_16 (&lv_font_montserrat_16)
+#define UI_FONT_24 (&lv_font_montserrat_24)
+#define UI_FONT_32 (&lv_font_montserrat_32)
+#endif
+
+#endif /* UI_FONTS_H */
@@ -2,23 +2,38 @@
  * lv_conf.h — Minimal LVGL 9.x configuration
  *
  * Targets: Raspberry Pi 3B+ with ILI9486 480×320 SPI display.
- * Only memory, colour depth, fonts, and tick config are set here.
+ * Only memory, colour depth, fonts, snapshot and tick config are set here.
  * No v8-era widget enable flags or LV_HOR_RES_MAX / LV_VER_RES_MAX.
  */
 
 #ifndef LV_CONF_H
 #define LV_CONF_H
 
-/* Colour depth: 16-bit (RGB565) matches ILI9486 native format */
+/* Colour depth: 16-bit (RGB565) matches ILI9486 native format.
+ * This is only the default — display_driver.c switches the display to
+ * the framebuffer's own format at runtime, so keep the software
+ * renderer able to draw the 24/32 bpp formats an HDMI fb0 uses. */
 #define LV_COLOR_DEPTH 16
+#define LV_DRAW_SW_SUPPORT_RGB565   1
+#define LV_DRAW_SW_SUPPORT_RGB888   1
+#define LV_DRAW_SW_SUPPORT_XRGB8888 1
 
 /* Memory pool for LVGL internal allocations */
 #define LV_MEM_SIZE (128 * 1024)
 
-/* Fonts — Montserrat 16 for body text, 24 for labels, 32 for icons / headings */
+/* Fonts — Montserrat 16 for body text, 24 for labels, 32 for icons / headings.
+ * A SUBSET_FONTS=1 build replaces them with the subset tables from
+ * `make fonts` (include/ui_fonts.h); the default font stays as their
+ * fallback */
+#ifndef UI_SUBSET_FONTS
 #define LV_FONT_MONTSERRAT_16 1
 #define LV_FONT_MONTSERRAT_24 1
 #define LV_FONT_MONTSERRAT_32 1
+#endif
+
+/* Page snapshots for slide animations (light_ui.c). The buffers are
+ * allocated with malloc, not from LV_MEM_SIZE */
+#define LV_USE_SNAPSHOT 1
 
 /* Tick source — LVGL 9.x uses lv_tick_set_cb() instead of LV_TICK_CUSTOM.
  * We call lv_tick_set_cb() in main.c after lv_init(). */
@@ -95,6 +95,7 @@ if [ ! -f "$CONFIG_PATH" ]; then
   "ha_url": "",
   "ha_token": "",
   "web_password": "happy",
+  "screen_timeout": 300,
   "lights": []
 }
 CONF
@@ -10,6 +10,14 @@
  *   "ha_url": "http://192.168.1.100:8123",
  *   "ha_token": "eyJ...",
  *   "web_password": "yourpassword",
+ *   "screen_timeout": 300,
+ *   "rotation": 0, "mirror_h": false, "mirror_v": false,
+ *   "hdmi_mirror": "/dev/fb0",
+ *   "display_backend": "spi", "spi_device": "/dev/spidev0.0",
+ *   "spi_speed_hz": 24000000, "spi_regwidth": 8,
+ *   "touch_calibration": [0, 7682, 0, -5121, 0, 20905984],
+ *   "touch_device": "0000:1ea6 ADS7846 Touchscreen",
+ *   "touch_filter": true,
  *   "lights": [
  *     { "entity_id": "light.living_room", "label": "Living Room", "icon": "bulb" }
  *   ]
@@ -19,10 +27,15 @@
  */
 
 #include "config.h"
+#include "power_manager.h"
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <ctype.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <sys/stat.h>
 
 /* ------------------------------------------------------------------ */
 /*  Internal state                                                    */
@@ -35,6 +48,9 @@ static char s_config_path[CONFIG_PATH_MAX] = {0};
 static config_t s_current_config;
 static int       s_config_loaded = 0;
 
+/** Serialises load → modify → save cycles (see config_lock). */
+static pthread_mutex_t s_file_lock = PTHREAD_MUTEX_INITIALIZER;
+
 /* ------------------------------------------------------------------ */
 /*  JSON parsing helpers                                              */
 /* ------------------------------------------------------------------ */
@@ -47,6 +63,31 @@ static const char *skip_ws(const char *p)
     return p;
 }
 
+/**
+ * Find the value of a key in a JSON object.
+ *
+ * Searches for "key" followed by a colon.
+ *
+ * @param json  JSON string to search
+ * @param key   Key name (without quotes)
+ * @return Pointer to the first non-whitespace char of the value, or
+ *         NULL if the key is not found
+ */
+static const char *json_find_value(const char *json, const char *key)
+{
+    char search[128];
+    snprintf(search, sizeof(search), "\"%s\"", key);
+
+    const char *pos = strstr(json, search);
+    if (!pos)
+        return NULL;
+
+    pos = skip_ws(pos + strlen(search));
+    if (*pos != ':')
+        return NULL;
+    return skip_ws(pos + 1);
+}
+
 /**
  * Extract a JSON string value for a given key from a JSON object.
  *
@@ -62,22 +103,8 @@ static const char *skip_ws(const char *p)
 static int json_get_string(const char *json, const char *key,
                            char *out_buf, size_t buf_size)
 {
-    char search[128];
-    snprintf(search, sizeof(search), "\"%s\"", key);
-
-    const char *pos = strstr(json, search);
-    if (!pos)
-        return -1;
-
-    pos += strlen(search);
-    pos = skip_ws(pos);
-
-    if (*pos != ':')
-        return -1;
-    pos++;
-    pos = skip_ws(pos);
-
-    if (*pos != '"')
+    const char *pos = json_find_value(json, key);
+    if (!pos || *pos != '"')
         return -1;
     pos++; /* skip opening quote */
 
@@ -93,26 +120,104 @@ static int json_get_string(const char *json, const char *key,
 }
 
 /**
- * Find the start of the "lights" JSON array.
+ * Extract a JSON integer value for a given key from a JSON object.
  *
- * @param json  Full JSON string
- * @return Pointer to the '[' character, or NULL if not found
+ * Searches for "key" : <number>. Leaves out_val untouched if the key
+ * is missing or not followed by a number.
+ *
+ * @param json     JSON string to search
+ * @param key      Key name (without quotes)
+ * @param out_val  Receives the parsed value
+ * @return 0 on success, -1 if key not found or not a number
  */
-static const char *find_lights_array(const char *json)
+static int json_get_int(const char *json, const char *key, int *out_val)
 {
-    const char *pos = strstr(json, "\"lights\"");
+    const char *pos = json_find_value(json, key);
     if (!pos)
-        return NULL;
+        return -1;
 
-    pos += 8; /* skip "lights" */
-    pos = skip_ws(pos);
+    char *end = NULL;
+    long val = strtol(pos, &end, 10);
+    if (end == pos)
+        return -1;
 
-    if (*pos != ':')
-        return NULL;
-    pos++;
-    pos = skip_ws(pos);
+    *out_val = (int)val;
+    return 0;
+}
+
+/**
+ * Extract a JSON boolean for a given key (true/false, or 1/0).
+ *
+ * @param json     JSON string to search
+ * @param key      Key name (without quotes)
+ * @param out_val  Receives the parsed value (untouched if missing)
+ * @return 0 on success, -1 if key not found or not a boolean
+ */
+static int json_get_bool(const char *json, const char *key, bool *out_val)
+{
+    const char *pos = json_find_value(json, key);
+    if (!pos)
+        return -1;
+
+    if (strncmp(pos, "true", 4) == 0 || *pos == '1') {
+        *out_val = true;
+        return 0;
+    }
+    if (strncmp(pos, "false", 5) == 0 || *pos == '0') {
+        *out_val = false;
+        return 0;
+    }
+    return -1;
+}
+
+/**
+ * Extract a JSON array of integers for a given key.
+ *
+ * @param json     JSON string to search
+ * @param key      Key name (without quotes)
+ * @param out      Receives up to max values
+ * @param max      Capacity of out
+ * @return Number of values in the array, or -1 if the key is missing or
+ *         the array is malformed (may exceed max; extra values are
+ *         counted but not stored)
+ */
+static int json_get_int_array(const char *json, const char *key,
+                              int32_t *out, int max)
+{
+    const char *pos = json_find_value(json, key);
+    if (!pos || *pos != '[')
+        return -1;
+    pos = skip_ws(pos + 1);
 
-    if (*pos != '[')
+    int n = 0;
+    while (*pos != ']') {
+        char *end = NULL;
+        long val = strtol(pos, &end, 10);
+        if (end == pos)
+            return -1;
+        if (n < max)
+            out[n] = (int32_t)val;
+        n++;
+
+        pos = skip_ws(end);
+        if (*pos == ',')
+            pos = skip_ws(pos + 1);
+        else if (*pos != ']')
+            return -1;
+    }
+    return n;
+}
+
+/**
+ * Find the start of the "lights" JSON array.
+ *
+ * @param json  Full JSON string
+ * @return Pointer to the '[' character, or NULL if not found
+ */
+static const char *find_lights_array(const char *json)
+{
+    const char *pos = json_find_value(json, "lights");
+    if (!pos || *pos != '[')
         return NULL;
 
     return pos;
@@ -295,6 +400,80 @@ int config_load(const char *path, config_t *out)
     json_get_string(json, "web_password", out->web_password,
                     sizeof(out->web_password));
 
+    /* screen_timeout is optional — default 0 keeps the panel always on */
+    json_get_int(json, "screen_timeout", &out->screen_timeout);
+    if (out->screen_timeout < 0) {
+        fprintf(stderr, "config: invalid screen_timeout %d (must be >= 0)\n",
+                out->screen_timeout);
+        free(json);
+        return -1;
+    }
+    if (out->screen_timeout > CONFIG_MAX_TIMEOUT_S) {
+        fprintf(stderr, "config: screen_timeout %d clamped to %d s\n",
+                out->screen_timeout, CONFIG_MAX_TIMEOUT_S);
+        out->screen_timeout = CONFIG_MAX_TIMEOUT_S;
+    }
+
+    /* Display orientation (optional — default is the native landscape) */
+    json_get_int(json, "rotation", &out->display.rotation);
+    json_get_bool(json, "mirror_h", &out->display.mirror_h);
+    json_get_bool(json, "mirror_v", &out->display.mirror_v);
+    json_get_string(json, "hdmi_mirror", out->display.hdmi_fb,
+                    sizeof(out->display.hdmi_fb));
+    if (out->display.rotation % 90 != 0 || out->display.rotation < 0 ||
+        out->display.rotation > 270) {
+        fprintf(stderr, "config: invalid rotation %d (must be 0, 90, 180 "
+                "or 270)\n", out->display.rotation);
+        free(json);
+        return -1;
+    }
+
+    /* Display backend (optional — default is the fbtft framebuffer) */
+    char backend[16] = "";
+    json_get_string(json, "display_backend", backend, sizeof(backend));
+    if (backend[0] == '\0' || strcmp(backend, "fbdev") == 0) {
+        out->display.backend = DISPLAY_BACKEND_FBDEV;
+    } else if (strcmp(backend, "spi") == 0) {
+        out->display.backend = DISPLAY_BACKEND_SPI;
+    } else {
+        fprintf(stderr, "config: invalid display_backend '%s' (must be "
+                "\"fbdev\" or \"spi\")\n", backend);
+        free(json);
+        return -1;
+    }
+    json_get_string(json, "spi_device", out->display.spi_device,
+                    sizeof(out->display.spi_device));
+    int spi_speed = 0;
+    json_get_int(json, "spi_speed_hz", &spi_speed);
+    if (spi_speed < 0) {
+        fprintf(stderr, "config: invalid spi_speed_hz %d\n", spi_speed);
+        free(json);
+        return -1;
+    }
+    out->display.spi_speed_hz = (uint32_t)spi_speed;
+    out->display.spi_regwidth = 8;
+    json_get_int(json, "spi_regwidth", &out->display.spi_regwidth);
+    if (out->display.spi_regwidth != 8 && out->display.spi_regwidth != 16) {
+        fprintf(stderr, "config: invalid spi_regwidth %d (must be 8 or "
+                "16)\n", out->display.spi_regwidth);
+        free(json);
+        return -1;
+    }
+
+    /* Touch calibration (optional — saved by ha_lights --calibrate) */
+    int n = json_get_int_array(json, "touch_calibration",
+                               out->touch.calib, 6);
+    if (n == 6) {
+        out->touch.calibrated = true;
+    } else if (n != -1) {
+        fprintf(stderr, "config: touch_calibration must have 6 integers\n");
+        free(json);
+        return -1;
+    }
+    json_get_string(json, "touch_device", out->touch.device,
+                    sizeof(out->touch.device));
+    json_get_bool(json, "touch_filter", &out->touch.filter);
+
     /* Parse lights array (optional — empty config still starts the UI) */
     const char *arr = find_lights_array(json);
     if (!arr) {
@@ -396,12 +575,24 @@ int config_save(const char *path, const config_t *cfg)
     if (!path || !cfg)
         return -1;
 
-    FILE *f = fopen(path, "w");
+    /* Written to a temporary file and renamed, so a crash or a second
+     * writer never leaves a truncated config behind. The file holds the
+     * HA token: keep the old file's mode, else owner-only */
+    char tmp_path[CONFIG_PATH_MAX + 8];
+    snprintf(tmp_path, sizeof(tmp_path), "%s.tmp", path);
+
+    struct stat st;
+    mode_t mode = stat(path, &st) == 0 ? (st.st_mode & 0777) : 0600;
+    int fd = open(tmp_path, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, mode);
+    FILE *f = fd >= 0 ? fdopen(fd, "w") : NULL;
     if (!f) {
-        fprintf(stderr, "config: cannot open '%s' for writing: ", path);
+        fprintf(stderr, "config: cannot open '%s' for writing: ", tmp_path);
         perror("");
+        if (fd >= 0)
+            close(fd);
         return -1;
     }
+    fchmod(fd, mode);   /* open() applied the umask */
 
     /* Helper: write a JSON-escaped string to file */
     #define WRITE_ESCAPED(file, str) do { \
@@ -429,6 +620,30 @@ int config_save(const char *path, const config_t *cfg)
     WRITE_ESCAPED(f, cfg->web_password);
     fprintf(f, ",\n");
 
+    fprintf(f, "  \"screen_timeout\": %d,\n", cfg->screen_timeout);
+    fprintf(f, "  \"rotation\": %d,\n", cfg->display.rotation);
+    fprintf(f, "  \"mirror_h\": %s,\n", cfg->display.mirror_h ? "true" : "false");
+    fprintf(f, "  \"mirror_v\": %s,\n", cfg->display.mirror_v ? "true" : "false");
+    fprintf(f, "  \"hdmi_mirror\": ");
+    WRITE_ESCAPED(f, cfg->display.hdmi_fb);
+    fprintf(f, ",\n");
+    fprintf(f, "  \"display_backend\": \"%s\",\n",
+            cfg->display.backend == DISPLAY_BACKEND_SPI ? "spi" : "fbdev");
+    fprintf(f, "  \"spi_device\": ");
+    WRITE_ESCAPED(f, cfg->display.spi_device);
+    fprintf(f, ",\n");
+    fprintf(f, "  \"spi_speed_hz\": %u,\n", cfg->display.spi_speed_hz);
+    fprintf(f, "  \"spi_regwidth\": %d,\n", cfg->display.spi_regwidth);
+    if (cfg->touch.calibrated) {
+        const int32_t *m = cfg->touch.calib;
+        fprintf(f, "  \"touch_calibration\": [%d, %d, %d, %d, %d, %d],\n",
+                m[0], m[1], m[2], m[3], m[4], m[5]);
+        fprintf(f, "  \"touch_device\": ");
+        WRITE_ESCAPED(f, cfg->touch.device);
+        fprintf(f, ",\n");
+    }
+    fprintf(f, "  \"touch_filter\": %s,\n", cfg->touch.filter ? "true" : "false");
+
     fprintf(f, "  \"lights\": [\n");
 
     for (int i = 0; i < cfg->light_count; i++) {
@@ -450,10 +665,27 @@ int config_save(const char *path, const config_t *cfg)
 
     #undef WRITE_ESCAPED
 
-    fclose(f);
+    int ok = fflush(f) == 0 && fsync(fd) == 0;
+    ok = (fclose(f) == 0) && ok;
+    if (!ok || rename(tmp_path, path) != 0) {
+        fprintf(stderr, "config: failed to save '%s': ", path);
+        perror("");
+        unlink(tmp_path);
+        return -1;
+    }
     return 0;
 }
 
+void config_lock(void)
+{
+    pthread_mutex_lock(&s_file_lock);
+}
+
+void config_unlock(void)
+{
+    pthread_mutex_unlock(&s_file_lock);
+}
+
 void config_set_path(const char *path)
 {
     if (path)
@@ -467,19 +699,30 @@ int config_reload(void)
         return -1;
     }
 
-    config_t new_cfg;
-    if (config_load(s_config_path, &new_cfg) != 0) {
+    /* config_t is large (CONFIG_MAX_LIGHTS lights): keep it off the
+     * web server thread's stack */
+    config_t *new_cfg = malloc(sizeof(*new_cfg));
+    if (!new_cfg) {
+        fprintf(stderr, "config: reload failed, out of memory\n");
+        return -1;
+    }
+    if (config_load(s_config_path, new_cfg) != 0) {
         fprintf(stderr, "config: reload failed, keeping current config\n");
+        free(new_cfg);
         return -1;
     }
 
-    /* Destroy current UI and rebuild with new config */
-    light_ui_destroy();
-    light_ui_init(new_cfg.lights, new_cfg.light_count);
+    /* Apply only what changed to the running UI (queued for the LVGL
+     * thread, so this may run on the web server thread) */
+    light_ui_update(new_cfg->lights, new_cfg->light_count);
+    ha_poll_set_lights(new_cfg->lights, new_cfg->light_count);
+
+    power_manager_set_timeout((uint32_t)new_cfg->screen_timeout);
 
     /* Update stored config */
-    s_current_config = new_cfg;
+    s_current_config = *new_cfg;
     s_config_loaded = 1;
+    free(new_cfg);
 
     return 0;
 }
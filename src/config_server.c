@@ -53,6 +53,11 @@ static pthread_mutex_t s_session_lock = PTHREAD_MUTEX_INITIALIZER;
 static struct mg_mgr   s_mgr;
 static pthread_t       s_thread;
 static volatile int    s_running;
+/* The server thread's own copy of the config: nothing here is shared
+ * with the LVGL thread, which only hears about changes through the
+ * light_ui command queue (config_reload → light_ui_update). Heap
+ * allocated, like every config_t here: it holds CONFIG_MAX_LIGHTS
+ * lights, too big to copy around or keep on the stack */
 static config_t       *s_cfg;
 static char            s_config_file_path[CONFIG_PATH_MAX];
 
@@ -452,30 +457,41 @@ static void json_escape(char *dst, size_t dst_size, const char *src)
 static void serve_config_json(struct mg_connection *c)
 {
     char url_esc[256], token_esc[1024];
-    char body[4096];
+    char *body;
+    size_t body_size;
     int off, i;
 
     json_escape(url_esc, sizeof(url_esc), s_cfg->ha.base_url);
     json_escape(token_esc, sizeof(token_esc), s_cfg->ha.token);
 
-    off = snprintf(body, sizeof(body),
+    /* Sized for the light list: each entry escapes to at most
+     * 128 + 64 + 16 characters plus its keys and punctuation */
+    body_size = 2048 + (size_t)s_cfg->light_count * 256;
+    body = malloc(body_size);
+    if (!body) {
+        mg_http_reply(c, 500, "", "Out of memory\n");
+        return;
+    }
+
+    off = snprintf(body, body_size,
         "{\"ha_url\":\"%s\",\"ha_token\":\"%s\",\"lights\":[",
         url_esc, token_esc);
 
-    for (i = 0; i < s_cfg->light_count && (size_t)off < sizeof(body) - 200; i++) {
+    for (i = 0; i < s_cfg->light_count; i++) {
         char eid[128], lbl[64], ico[16];
         json_escape(eid, sizeof(eid), s_cfg->lights[i].entity_id);
         json_escape(lbl, sizeof(lbl), s_cfg->lights[i].label);
         json_escape(ico, sizeof(ico), s_cfg->lights[i].icon);
-        off += snprintf(body + off, sizeof(body) - (size_t)off,
+        off += snprintf(body + off, body_size - (size_t)off,
             "%s{\"entity_id\":\"%s\",\"label\":\"%s\",\"icon\":\"%s\"}",
             i > 0 ? "," : "", eid, lbl, ico);
     }
 
-    off += snprintf(body + off, sizeof(body) - (size_t)off, "]}");
+    snprintf(body + off, body_size - (size_t)off, "]}");
 
     mg_http_reply(c, 200,
         "Content-Type: application/json\r\n", "%s", body);
+    free(body);
 }
 
 /* ------------------------------------------------------------------ */
@@ -512,67 +528,87 @@ static int json_extract_str(const char *json, int json_len,
 
 static int handle_config_update(struct mg_http_message *hm)
 {
-    config_t new_cfg;
     const char *json = hm->body.buf;
     int json_len = (int)hm->body.len;
     char tmp[512];
     int i, count;
     char path[64];
 
-    memset(&new_cfg, 0, sizeof(new_cfg));
+    config_t *new_cfg = calloc(1, sizeof(*new_cfg));
+    config_t *on_disk = malloc(sizeof(*on_disk));
+    if (!new_cfg || !on_disk) {
+        fprintf(stderr, "config_server: out of memory\n");
+        free(new_cfg);
+        free(on_disk);
+        return -1;
+    }
+
+    /* Keep file-only settings that the web UI does not edit, as they
+     * are on disk now (the main thread saves touch calibration there) */
+    config_lock();
+    const config_t *keep = s_cfg;
+    if (config_load(s_config_file_path, on_disk) == 0)
+        keep = on_disk;
 
     /* Copy existing password (not editable via web UI) */
-    snprintf(new_cfg.web_password, sizeof(new_cfg.web_password),
-             "%s", s_cfg->web_password);
+    snprintf(new_cfg->web_password, sizeof(new_cfg->web_password),
+             "%s", keep->web_password);
+
+    new_cfg->screen_timeout = keep->screen_timeout;
+    new_cfg->display = keep->display;
+    new_cfg->touch = keep->touch;
+    free(on_disk);
 
     /* Extract ha_url */
-    if (json_extract_str(json, json_len, "$.ha_url", tmp, sizeof(new_cfg.ha.base_url)) > 0)
-        snprintf(new_cfg.ha.base_url, sizeof(new_cfg.ha.base_url), "%s", tmp);
+    if (json_extract_str(json, json_len, "$.ha_url", tmp, sizeof(new_cfg->ha.base_url)) > 0)
+        snprintf(new_cfg->ha.base_url, sizeof(new_cfg->ha.base_url), "%s", tmp);
 
     /* Extract ha_token */
-    if (json_extract_str(json, json_len, "$.ha_token", tmp, sizeof(new_cfg.ha.token)) > 0)
-        snprintf(new_cfg.ha.token, sizeof(new_cfg.ha.token), "%s", tmp);
+    if (json_extract_str(json, json_len, "$.ha_token", tmp, sizeof(new_cfg->ha.token)) > 0)
+        snprintf(new_cfg->ha.token, sizeof(new_cfg->ha.token), "%s", tmp);
 
     /* Extract lights array */
     count = 0;
     for (i = 0; i < CONFIG_MAX_LIGHTS; i++) {
         snprintf(path, sizeof(path), "$.lights[%d].entity_id", i);
-        if (json_extract_str(json, json_len, path, tmp, sizeof(new_cfg.lights[0].entity_id)) <= 0)
+        if (json_extract_str(json, json_len, path, tmp, sizeof(new_cfg->lights[0].entity_id)) <= 0)
             break;
-        snprintf(new_cfg.lights[count].entity_id,
-                 sizeof(new_cfg.lights[count].entity_id), "%s", tmp);
+        snprintf(new_cfg->lights[count].entity_id,
+                 sizeof(new_cfg->lights[count].entity_id), "%s", tmp);
 
         snprintf(path, sizeof(path), "$.lights[%d].label", i);
-        if (json_extract_str(json, json_len, path, tmp, sizeof(new_cfg.lights[0].label)) > 0)
-            snprintf(new_cfg.lights[count].label,
-                     sizeof(new_cfg.lights[count].label), "%s", tmp);
+        if (json_extract_str(json, json_len, path, tmp, sizeof(new_cfg->lights[0].label)) > 0)
+            snprintf(new_cfg->lights[count].label,
+                     sizeof(new_cfg->lights[count].label), "%s", tmp);
 
         snprintf(path, sizeof(path), "$.lights[%d].icon", i);
-        if (json_extract_str(json, json_len, path, tmp, sizeof(new_cfg.lights[0].icon)) > 0)
-            snprintf(new_cfg.lights[count].icon,
-                     sizeof(new_cfg.lights[count].icon), "%s", tmp);
+        if (json_extract_str(json, json_len, path, tmp, sizeof(new_cfg->lights[0].icon)) > 0)
+            snprintf(new_cfg->lights[count].icon,
+                     sizeof(new_cfg->lights[count].icon), "%s", tmp);
 
         count++;
     }
-    new_cfg.light_count = count;
+    new_cfg->light_count = count;
 
     /* Save to disk and trigger live reload */
-    if (config_save(s_config_file_path, &new_cfg) != 0) {
+    int saved = config_save(s_config_file_path, new_cfg);
+    config_unlock();
+    if (saved != 0) {
         fprintf(stderr, "config_server: failed to save config\n");
+        free(new_cfg);
         return -1;
     }
 
     if (config_reload() != 0) {
         fprintf(stderr, "config_server: failed to reload config\n");
+        free(new_cfg);
         return -1;
     }
 
-    /* Update our local pointer to reflect the reloaded config */
-    {
-        const config_t *reloaded = config_get_current();
-        if (reloaded)
-            *s_cfg = *reloaded;
-    }
+    /* The reload queued the new light list for the LVGL thread (which
+     * it wakes); what was saved is now our own copy */
+    free(s_cfg);
+    s_cfg = new_cfg;
 
     return 0;
 }
@@ -804,7 +840,7 @@ static void *server_thread(void *arg)
 /*  Public API                                                        */
 /* ------------------------------------------------------------------ */
 
-int config_server_start(int port, config_t *cfg)
+int config_server_start(int port, const config_t *cfg)
 {
     char listen_addr[32];
     struct mg_connection *nc;
@@ -814,7 +850,12 @@ int config_server_start(int port, config_t *cfg)
         return -1;
     }
 
-    s_cfg = cfg;
+    s_cfg = malloc(sizeof(*s_cfg));
+    if (!s_cfg) {
+        fprintf(stderr, "config_server: out of memory\n");
+        return -1;
+    }
+    *s_cfg = *cfg;
 
     mg_mgr_init(&s_mgr);
 
@@ -823,6 +864,8 @@ int config_server_start(int port, config_t *cfg)
     if (!nc) {
         fprintf(stderr, "config_server: failed to listen on port %d\n", port);
         mg_mgr_free(&s_mgr);
+        free(s_cfg);
+        s_cfg = NULL;
         return -1;
     }
 
@@ -835,6 +878,8 @@ int config_server_start(int port, config_t *cfg)
         fprintf(stderr, "config_server: failed to create thread\n");
         s_running = 0;
         mg_mgr_free(&s_mgr);
+        free(s_cfg);
+        s_cfg = NULL;
         return -1;
     }
 
@@ -850,6 +895,8 @@ void config_server_stop(void)
     s_running = 0;
     pthread_join(s_thread, NULL);
     mg_mgr_free(&s_mgr);
+    free(s_cfg);
+    s_cfg = NULL;
 
     fprintf(stderr, "config_server: stopped\n");
 }
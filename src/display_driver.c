@@ -12,17 +12,58 @@
  * Framebuffer search order: /dev/fb1, /dev/fb0
  * (fb1 is typical for SPI displays when HDMI is fb0)
  *
+ * LVGL renders straight into the framebuffer's own pixel format
+ * (RGB565, RGB888 or XRGB8888, picked from FBIOGET_VSCREENINFO), so the
+ * flush is a plain row copy with no per-pixel conversion. BGR-ordered
+ * framebuffers only need a red/blue swap in place before the copy.
+ *
+ * Rotation / mirroring: LVGL renders the logical (rotated) screen and
+ * disp_flush_cb maps each area onto the physical panel. Unrotated
+ * areas are row memcpys; 90°/270° areas are copied as cache-blocked
+ * tile transposes (8×8 NEON register transposes for RGB565 on ARM), so
+ * both source reads and framebuffer writes stay within a few cache
+ * lines per tile. The copies live in fb_blit.c, without LVGL, so the
+ * host benchmark (make flush-bench) times the same code.
+ *
+ * HDMI mirror: optionally every flushed area is also written to a
+ * second framebuffer (usually HDMI fb0), upright, centred and scaled by
+ * precomputed nearest-neighbour row/column maps (an exact integer factor
+ * when the screen fits, e.g. 3× on 1080p). Each source pixel is
+ * converted to the mirror's format once and replicated; only damaged
+ * areas are ever touched, unlike fbcp's continuous full-screen copy.
+ *
+ * SPI backend: instead of the framebuffer, LVGL areas can go straight
+ * to the panel through ili9486.c — one address window per area and only
+ * that area's pixels on the wire, without fbtft's page-granular refresh
+ * or its extra kernel copy. Rotation and mirroring are done by the
+ * controller (MADCTL), so areas are sent exactly as rendered.
+ *
+ * Boot splash: the visible framebuffer is saved RLE-compressed to
+ * SPLASH_PATH at shutdown, when the display blanks and every
+ * SPLASH_SAVE_MS, each time only if the screen changed since the last
+ * save. The long interval covers a crash (Restart=on-failure) on a
+ * panel that never blanks without the SD card wear of frequent saves.
+ * display_driver_init blits it back into the framebuffer before any
+ * LVGL display exists, so a (re)started service shows the last
+ * dashboard within milliseconds instead of black or the console.
+ *
  * Requirements: 1.1, 1.2, 1.3, 1.4
  */
 
 #include "display_driver.h"
+#include "perf_stats.h"
+#include "ili9486.h"
+#include "fb_blit.h"
 
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <unistd.h>
 #include <fcntl.h>
+#include <stdint.h>
+#include <stddef.h>
 #include <errno.h>
+#include <dirent.h>
 #include <sys/ioctl.h>
 #include <sys/mman.h>
 #include <linux/fb.h>
@@ -33,9 +74,15 @@
 /*  Configuration                                                     */
 /* ------------------------------------------------------------------ */
 
-/* Draw buffer: 10 lines at a time */
+/* Draw buffer: 10 lines at a time, sized for the render format */
 #define DRAW_BUF_LINES 10
-#define DRAW_BUF_SIZE  (DISP_HOR_RES * DRAW_BUF_LINES * sizeof(lv_color16_t))
+#define DRAW_BUF_SIZE  (DISP_HOR_RES * DRAW_BUF_LINES * fb_px_bytes)
+
+/* Cached last frame shown at startup */
+#define SPLASH_PATH     "/var/tmp/ha_lights_splash.bin"
+#define SPLASH_MAGIC    0x53504148u   /* "HAPS" little-endian          */
+#define SPLASH_VERSION  1
+#define SPLASH_SAVE_MS  (20 * 60 * 1000) /* Periodic save while changing */
 
 /* ------------------------------------------------------------------ */
 /*  Module-level state                                                */
@@ -46,10 +93,39 @@ static uint8_t *fb_map = NULL;       /* mmap'd framebuffer memory     */
 static size_t fb_size = 0;           /* Total framebuffer size        */
 static uint32_t fb_line_length = 0;  /* Bytes per scanline            */
 static uint32_t fb_bpp = 16;         /* Bits per pixel                */
+static uint32_t fb_xres = 0;         /* Visible width in pixels       */
+static uint32_t fb_yres = 0;         /* Visible height in pixels      */
+static uint32_t fb_px_bytes = 2;     /* Bytes per pixel               */
+static bool fb_swap_rb = false;      /* Framebuffer is BGR-ordered    */
+static lv_color_format_t fb_cf = LV_COLOR_FORMAT_RGB565; /* Render fmt */
 
 static lv_display_t *disp = NULL;    /* LVGL display handle           */
 static uint8_t *draw_buf = NULL;     /* LVGL draw buffer              */
 static int tty_fd = -1;             /* TTY fd for console blanking    */
+static uint64_t frame_flush_us = 0;  /* Flush time within this refresh */
+static bool     frame_drawn = false; /* This refresh flushed something */
+static uint32_t frame_px = 0;        /* Pixels flushed in this refresh */
+
+static ili9486_transport_t *spi_xport = NULL; /* SPI backend, or NULL */
+
+/* HDMI mirror (secondary framebuffer) */
+static int sec_fd = -1;
+static uint8_t *sec_map = NULL;
+static size_t sec_size = 0;
+static uint32_t sec_line_length = 0;
+static uint32_t sec_px_bytes = 0;
+static struct fb_var_screeninfo sec_vinfo;
+static int32_t *sec_xmap = NULL;     /* Logical col → first mirror col */
+static int32_t *sec_ymap = NULL;     /* Logical row → first mirror row */
+static uint8_t *sec_row = NULL;      /* One converted, scaled row      */
+
+/* Orientation: logical size and the logical → framebuffer mapping */
+static display_config_t disp_cfg = { 0 };
+static int32_t   log_hor_res = DISP_HOR_RES;
+static int32_t   log_ver_res = DISP_VER_RES;
+static fb_blit_t blit;
+static lv_timer_t *splash_timer = NULL; /* Periodic splash save       */
+static bool fb_dirty = false;        /* Flushed since last splash save */
 
 /* ------------------------------------------------------------------ */
 /*  Console blanking                                                  */
@@ -94,6 +170,31 @@ static void restore_console(void)
 /*  Framebuffer helpers                                               */
 /* ------------------------------------------------------------------ */
 
+/**
+ * Pick the LVGL render format matching the framebuffer's pixel layout.
+ *
+ * LVGL's RGB565 / RGB888 / XRGB8888 formats are little-endian with blue
+ * in the low bits, which is the usual fbdev layout (red.offset 11 or
+ * 16). A framebuffer with red in the low bits is flagged for an in-place
+ * red/blue swap at flush time instead.
+ *
+ * Returns 0 on success, -1 if the depth is not supported.
+ */
+static int fb_pick_format(const struct fb_var_screeninfo *vinfo)
+{
+    switch (vinfo->bits_per_pixel) {
+    case 16: fb_cf = LV_COLOR_FORMAT_RGB565;   break;
+    case 24: fb_cf = LV_COLOR_FORMAT_RGB888;   break;
+    case 32: fb_cf = LV_COLOR_FORMAT_XRGB8888; break;
+    default:
+        return -1;
+    }
+
+    fb_px_bytes = vinfo->bits_per_pixel / 8;
+    fb_swap_rb = (vinfo->red.offset == 0 && vinfo->blue.offset > 0);
+    return 0;
+}
+
 /**
  * Try to open a framebuffer device and mmap it.
  * Returns 0 on success, -1 on failure.
@@ -120,11 +221,32 @@ static int fb_open(const char *dev)
     }
 
     fb_bpp = vinfo.bits_per_pixel;
+    fb_xres = vinfo.xres;
+    fb_yres = vinfo.yres;
     fb_line_length = finfo.line_length;
     fb_size = (size_t)finfo.smem_len;
 
-    fprintf(stderr, "display_driver: %s — %dx%d, %d bpp, line_length=%u\n",
-            dev, vinfo.xres, vinfo.yres, fb_bpp, fb_line_length);
+    fprintf(stderr, "display_driver: %s — %dx%d, %d bpp%s, line_length=%u\n",
+            dev, vinfo.xres, vinfo.yres, fb_bpp,
+            (vinfo.red.offset == 0 && vinfo.blue.offset > 0) ? " (BGR)" : "",
+            fb_line_length);
+
+    if (fb_pick_format(&vinfo) != 0) {
+        fprintf(stderr, "display_driver: %s — unsupported depth %d bpp\n",
+                dev, fb_bpp);
+        close(fb_fd);
+        fb_fd = -1;
+        return -1;
+    }
+
+    /* The flush writes DISP_HOR_RES × DISP_VER_RES pixels (RES=...) */
+    if (fb_xres < DISP_HOR_RES || fb_yres < DISP_VER_RES) {
+        fprintf(stderr, "display_driver: %s — smaller than the %dx%d "
+                "build resolution\n", dev, DISP_HOR_RES, DISP_VER_RES);
+        close(fb_fd);
+        fb_fd = -1;
+        return -1;
+    }
 
     /* mmap the framebuffer */
     fb_map = (uint8_t *)mmap(NULL, fb_size, PROT_READ | PROT_WRITE,
@@ -137,83 +259,561 @@ static int fb_open(const char *dev)
         return -1;
     }
 
-    /* Clear to black */
-    memset(fb_map, 0, fb_size);
+    return 0;
+}
+
+/* ------------------------------------------------------------------ */
+/*  Boot splash (cached last frame)                                   */
+/* ------------------------------------------------------------------ */
+
+/** On-disk splash header, followed by payload_len bytes of RLE data. */
+typedef struct {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t bpp;
+    uint32_t xres;
+    uint32_t yres;
+    uint32_t payload_len;
+} splash_header_t;
+
+/**
+ * PackBits-style RLE over whole pixels, one scanline at a time.
+ *
+ * Control byte c: bit 7 set → run of (c & 0x7F) + 1 copies of the next
+ * pixel; clear → (c + 1) literal pixels follow. Flat tile and screen
+ * backgrounds make a dashboard frame compress to a few percent.
+ *
+ * @return Bytes written to out
+ */
+static size_t rle_encode_row(const uint8_t *px, uint32_t n, uint32_t bpp_bytes,
+                             uint8_t *out)
+{
+    size_t o = 0;
+    uint32_t i = 0;
+
+    while (i < n) {
+        /* Measure the run starting at i */
+        uint32_t run = 1;
+        while (i + run < n && run < 128 &&
+               memcmp(px + (i + run) * bpp_bytes, px + i * bpp_bytes,
+                      bpp_bytes) == 0)
+            run++;
+
+        if (run >= 2) {
+            out[o++] = (uint8_t)(0x80 | (run - 1));
+            memcpy(out + o, px + i * bpp_bytes, bpp_bytes);
+            o += bpp_bytes;
+            i += run;
+            continue;
+        }
+
+        /* Literal stretch until the next run of 2+ (or 128 pixels) */
+        uint32_t lit = 1;
+        while (i + lit < n && lit < 128 &&
+               !(i + lit + 1 < n &&
+                 memcmp(px + (i + lit) * bpp_bytes,
+                        px + (i + lit + 1) * bpp_bytes, bpp_bytes) == 0))
+            lit++;
+
+        out[o++] = (uint8_t)(lit - 1);
+        memcpy(out + o, px + i * bpp_bytes, (size_t)lit * bpp_bytes);
+        o += (size_t)lit * bpp_bytes;
+        i += lit;
+    }
+
+    return o;
+}
+
+/**
+ * Decode one scanline of RLE data.
+ *
+ * @return Bytes consumed from in, or 0 if the data is malformed
+ */
+static size_t rle_decode_row(const uint8_t *in, size_t in_len, uint8_t *px,
+                             uint32_t n, uint32_t bpp_bytes)
+{
+    size_t p = 0;
+    uint32_t i = 0;
+
+    while (i < n) {
+        if (p >= in_len) return 0;
+        uint8_t c = in[p++];
+        uint32_t count = (uint32_t)(c & 0x7F) + 1;
+        if (i + count > n) return 0;
+
+        if (c & 0x80) {
+            if (p + bpp_bytes > in_len) return 0;
+            for (uint32_t k = 0; k < count; k++)
+                memcpy(px + (i + k) * bpp_bytes, in + p, bpp_bytes);
+            p += bpp_bytes;
+        } else {
+            size_t bytes = (size_t)count * bpp_bytes;
+            if (p + bytes > in_len) return 0;
+            memcpy(px + i * bpp_bytes, in + p, bytes);
+            p += bytes;
+        }
+        i += count;
+    }
+
+    return p;
+}
+
+/**
+ * Save the visible framebuffer to SPLASH_PATH.
+ *
+ * Written to a temporary file and renamed, so a crash mid-save never
+ * leaves a truncated splash behind.
+ */
+static void splash_save(void)
+{
+    if (!fb_map || fb_xres == 0 || fb_yres == 0) return;
+
+    uint32_t row_bytes = fb_xres * fb_px_bytes;
+    size_t max_row = row_bytes + (fb_xres + 127) / 128;
+    uint8_t *buf = (uint8_t *)malloc(max_row * fb_yres);
+    if (!buf) return;
+
+    size_t len = 0;
+    for (uint32_t y = 0; y < fb_yres; y++)
+        len += rle_encode_row(fb_map + (size_t)y * fb_line_length, fb_xres,
+                              fb_px_bytes, buf + len);
+
+    splash_header_t hdr = {
+        .magic = SPLASH_MAGIC, .version = SPLASH_VERSION,
+        .bpp = (uint16_t)fb_bpp, .xres = fb_xres, .yres = fb_yres,
+        .payload_len = (uint32_t)len,
+    };
+
+    const char *tmp_path = SPLASH_PATH ".tmp";
+    FILE *f = fopen(tmp_path, "wb");
+    if (!f) {
+        free(buf);
+        return;
+    }
+    int ok = fwrite(&hdr, sizeof(hdr), 1, f) == 1 &&
+             fwrite(buf, 1, len, f) == len;
+    ok = (fclose(f) == 0) && ok;
+    free(buf);
+
+    if (!ok || rename(tmp_path, SPLASH_PATH) != 0) {
+        fprintf(stderr, "display_driver: failed to save splash to %s\n",
+                SPLASH_PATH);
+        unlink(tmp_path);
+        return;
+    }
+
+    fb_dirty = false;
+}
+
+/**
+ * Blit the cached splash into the framebuffer.
+ *
+ * The splash is only used if it was saved from a framebuffer with the
+ * same geometry and depth. Returns 0 if the splash was shown.
+ */
+static int splash_show(void)
+{
+    FILE *f = fopen(SPLASH_PATH, "rb");
+    if (!f) return -1;
+
+    splash_header_t hdr;
+    uint8_t *buf = NULL;
+    int rc = -1;
+
+    if (fread(&hdr, sizeof(hdr), 1, f) != 1 ||
+        hdr.magic != SPLASH_MAGIC || hdr.version != SPLASH_VERSION ||
+        hdr.bpp != fb_bpp || hdr.xres != fb_xres || hdr.yres != fb_yres)
+        goto out;
+
+    buf = (uint8_t *)malloc(hdr.payload_len);
+    if (!buf || fread(buf, 1, hdr.payload_len, f) != hdr.payload_len)
+        goto out;
+
+    size_t p = 0;
+    for (uint32_t y = 0; y < fb_yres; y++) {
+        size_t used = rle_decode_row(buf + p, hdr.payload_len - p,
+                                     fb_map + (size_t)y * fb_line_length,
+                                     fb_xres, fb_px_bytes);
+        if (used == 0)
+            goto out;
+        p += used;
+    }
+    rc = 0;
+
+out:
+    free(buf);
+    fclose(f);
+    return rc;
+}
+
+/** LVGL timer — refresh the splash if the screen changed. */
+static void splash_timer_cb(lv_timer_t *timer)
+{
+    (void)timer;
+    if (fb_dirty)
+        splash_save();
+}
+
+/* ------------------------------------------------------------------ */
+/*  HDMI mirror                                                       */
+/* ------------------------------------------------------------------ */
+
+/** Release the secondary framebuffer and its scaling tables. */
+static void sec_close(void)
+{
+    if (sec_map) {
+        munmap(sec_map, sec_size);
+        sec_map = NULL;
+    }
+    if (sec_fd >= 0) {
+        close(sec_fd);
+        sec_fd = -1;
+    }
+    free(sec_xmap);
+    free(sec_ymap);
+    free(sec_row);
+    sec_xmap = sec_ymap = NULL;
+    sec_row = NULL;
+}
+
+/**
+ * Build the nearest-neighbour map for one axis.
+ *
+ * map[i] is the first output pixel for source pixel i, map[n] the end,
+ * so source pixel i covers [map[i], map[i+1]). Downscaling leaves some
+ * spans empty, which drops those source pixels.
+ */
+static int32_t *sec_build_map(int32_t n, int32_t out_len, int32_t offset)
+{
+    int32_t *map = (int32_t *)malloc(sizeof(int32_t) * (size_t)(n + 1));
+    if (!map) return NULL;
+
+    for (int32_t i = 0; i <= n; i++)
+        map[i] = offset + (int32_t)((int64_t)i * out_len / n);
+    return map;
+}
+
+/**
+ * Open the mirror framebuffer and precompute its scaling maps.
+ *
+ * Must run after fb_blit_setup() (needs the logical size) and
+ * fb_pick_format (needs the render format). Returns 0 on success.
+ */
+static int sec_open(const char *dev)
+{
+    struct fb_fix_screeninfo finfo;
+
+    sec_fd = open(dev, O_RDWR);
+    if (sec_fd < 0) {
+        fprintf(stderr, "display_driver: cannot open mirror %s: %s\n",
+                dev, strerror(errno));
+        return -1;
+    }
+
+    if (ioctl(sec_fd, FBIOGET_VSCREENINFO, &sec_vinfo) < 0 ||
+        ioctl(sec_fd, FBIOGET_FSCREENINFO, &finfo) < 0 ||
+        (sec_vinfo.bits_per_pixel != 16 && sec_vinfo.bits_per_pixel != 24 &&
+         sec_vinfo.bits_per_pixel != 32)) {
+        fprintf(stderr, "display_driver: unsupported mirror %s\n", dev);
+        sec_close();
+        return -1;
+    }
 
+    sec_px_bytes = sec_vinfo.bits_per_pixel / 8;
+    sec_line_length = finfo.line_length;
+    sec_size = (size_t)finfo.smem_len;
+
+    sec_map = (uint8_t *)mmap(NULL, sec_size, PROT_READ | PROT_WRITE,
+                              MAP_SHARED, sec_fd, 0);
+    if (sec_map == MAP_FAILED) {
+        sec_map = NULL;
+        fprintf(stderr, "display_driver: mirror mmap failed: %s\n",
+                strerror(errno));
+        sec_close();
+        return -1;
+    }
+
+    /* Largest integer scale that fits; plain aspect-preserving
+     * nearest-neighbour fit only if the mirror is smaller than us */
+    int32_t xres = (int32_t)sec_vinfo.xres, yres = (int32_t)sec_vinfo.yres;
+    int32_t k = xres / log_hor_res < yres / log_ver_res
+                ? xres / log_hor_res : yres / log_ver_res;
+    int32_t out_w, out_h;
+    if (k >= 1) {
+        out_w = log_hor_res * k;
+        out_h = log_ver_res * k;
+    } else if ((int64_t)xres * log_ver_res <= (int64_t)yres * log_hor_res) {
+        out_w = xres;
+        out_h = (int32_t)((int64_t)log_ver_res * xres / log_hor_res);
+    } else {
+        out_h = yres;
+        out_w = (int32_t)((int64_t)log_hor_res * yres / log_ver_res);
+    }
+
+    sec_xmap = sec_build_map(log_hor_res, out_w, (xres - out_w) / 2);
+    sec_ymap = sec_build_map(log_ver_res, out_h, (yres - out_h) / 2);
+    sec_row = (uint8_t *)malloc((size_t)xres * sec_px_bytes);
+    if (!sec_xmap || !sec_ymap || !sec_row) {
+        sec_close();
+        return -1;
+    }
+
+    memset(sec_map, 0, sec_size);
+
+    fprintf(stderr, "display_driver: mirroring to %s — %dx%d, %u bpp, "
+            "scaled to %dx%d\n", dev, xres, yres,
+            sec_vinfo.bits_per_pixel, out_w, out_h);
     return 0;
 }
 
+/** Pack 8-bit RGB into the mirror framebuffer's pixel layout. */
+static inline uint32_t sec_pack(uint32_t r, uint32_t g, uint32_t b)
+{
+    const struct fb_var_screeninfo *v = &sec_vinfo;
+    uint32_t px = ((r >> (8 - v->red.length)) << v->red.offset)
+                | ((g >> (8 - v->green.length)) << v->green.offset)
+                | ((b >> (8 - v->blue.length)) << v->blue.offset);
+    if (v->transp.length)
+        px |= ((1u << v->transp.length) - 1) << v->transp.offset;
+    return px;
+}
+
+/** Convert one rendered pixel (render format fb_cf) for the mirror. */
+static inline uint32_t sec_convert(const uint8_t *src)
+{
+    if (fb_px_bytes == 2) {
+        uint16_t c = (uint16_t)(src[0] | (src[1] << 8));
+        uint32_t r = (c >> 11) & 0x1F, g = (c >> 5) & 0x3F, b = c & 0x1F;
+        return sec_pack((r << 3) | (r >> 2), (g << 2) | (g >> 4),
+                        (b << 3) | (b >> 2));
+    }
+    /* RGB888 / XRGB8888: little-endian B, G, R[, X] */
+    return sec_pack(src[2], src[1], src[0]);
+}
+
+/**
+ * Scale and convert one rendered area into the mirror framebuffer.
+ *
+ * Each logical row is converted once into sec_row (each pixel
+ * replicated across its column span), then copied to every mirror row
+ * that logical row covers.
+ */
+static void sec_mirror_area(const uint8_t *px_map, const lv_area_t *area)
+{
+    int32_t w = area->x2 - area->x1 + 1;
+    int32_t dx0 = sec_xmap[area->x1];
+    int32_t dx1 = sec_xmap[area->x2 + 1];
+    if (dx1 <= dx0) return;
+
+    for (int32_t ly = area->y1; ly <= area->y2; ly++) {
+        int32_t dy0 = sec_ymap[ly], dy1 = sec_ymap[ly + 1];
+        if (dy1 <= dy0) continue;   /* Row dropped by downscaling */
+
+        const uint8_t *src = px_map + (size_t)(ly - area->y1) * w * fb_px_bytes;
+        uint8_t *out = sec_row;
+
+        for (int32_t lx = area->x1; lx <= area->x2; lx++, src += fb_px_bytes) {
+            int32_t span = sec_xmap[lx + 1] - sec_xmap[lx];
+            if (span <= 0) continue;
+
+            uint32_t v = sec_convert(src);
+            for (int32_t k = 0; k < span; k++, out += sec_px_bytes) {
+                if (sec_px_bytes == 4)
+                    *(uint32_t *)out = v;
+                else if (sec_px_bytes == 2)
+                    *(uint16_t *)out = (uint16_t)v;
+                else {
+                    out[0] = (uint8_t)v;
+                    out[1] = (uint8_t)(v >> 8);
+                    out[2] = (uint8_t)(v >> 16);
+                }
+            }
+        }
+
+        size_t bytes = (size_t)(dx1 - dx0) * sec_px_bytes;
+        for (int32_t dy = dy0; dy < dy1; dy++)
+            memcpy(sec_map + (size_t)dy * sec_line_length
+                   + (size_t)dx0 * sec_px_bytes, sec_row, bytes);
+    }
+}
+
 /* ------------------------------------------------------------------ */
 /*  LVGL flush callback                                               */
 /* ------------------------------------------------------------------ */
 
+/**
+ * Time whole refresh cycles (render + flush) for perf_stats.
+ */
+static void disp_refr_event_cb(lv_event_t *e)
+{
+    if (lv_event_get_code(e) == LV_EVENT_REFR_START) {
+        frame_drawn = false;
+        perf_frame_start();
+    } else {
+        perf_frame_done(frame_drawn);
+    }
+}
+
 /**
  * LVGL 9.x flush callback — framebuffer version.
  *
- * Copies rendered pixels from LVGL's draw buffer directly into the
- * mmap'd framebuffer memory. Handles both 16-bit (RGB565) and 32-bit
- * (ARGB8888) framebuffers.
+ * LVGL has already rendered in the framebuffer's pixel format, so the
+ * area only needs placing into the mmap'd framebuffer (rotated and
+ * mirrored as configured — see fb_blit_area). Flush time is recorded per
+ * call and per refresh cycle, and so is the redrawn pixel area, which
+ * in partial render mode is exactly what was invalidated (perf_stats).
  */
 static void disp_flush_cb(lv_display_t *display, const lv_area_t *area,
                            uint8_t *px_map)
 {
-    int32_t x1 = area->x1;
-    int32_t y1 = area->y1;
-    int32_t x2 = area->x2;
-    int32_t y2 = area->y2;
-    int32_t w  = x2 - x1 + 1;
-
-    if (fb_map && fb_bpp == 16) {
-        /* 16-bit RGB565 — direct copy, line by line */
-        uint32_t src_stride = (uint32_t)(w * 2);
-        for (int32_t y = y1; y <= y2; y++) {
-            uint32_t fb_offset = (uint32_t)y * fb_line_length + (uint32_t)x1 * 2;
-            uint32_t src_offset = (uint32_t)(y - y1) * src_stride;
-            memcpy(fb_map + fb_offset, px_map + src_offset, src_stride);
-        }
-    } else if (fb_map && fb_bpp == 32) {
-        /* 32-bit ARGB — convert from RGB565 */
-        uint16_t *src = (uint16_t *)px_map;
-        for (int32_t y = y1; y <= y2; y++) {
-            uint32_t *dst = (uint32_t *)(fb_map + (uint32_t)y * fb_line_length
-                            + (uint32_t)x1 * 4);
-            for (int32_t x = 0; x < w; x++) {
-                uint16_t c = src[(y - y1) * w + x];
-                uint8_t r = (uint8_t)(((c >> 11) & 0x1F) << 3);
-                uint8_t g = (uint8_t)(((c >> 5)  & 0x3F) << 2);
-                uint8_t b = (uint8_t)((c & 0x1F) << 3);
-                dst[x] = (0xFF000000u) | ((uint32_t)r << 16)
-                          | ((uint32_t)g << 8) | b;
-            }
+    uint64_t t0 = perf_now_us();
+
+    /* Mirror first: it reads the untouched, unrotated render output */
+    if (sec_map)
+        sec_mirror_area(px_map, area);
+
+    if (spi_xport) {
+        static bool write_logged = false;
+
+        if (ili9486_write_area(spi_xport, area->x1, area->y1, area->x2,
+                               area->y2, px_map) != 0) {
+            /* Once per spell: every area fails while the panel is gone */
+            if (!write_logged)
+                fprintf(stderr, "display_driver: panel write failed, "
+                        "dropping areas until it recovers\n");
+            write_logged = true;
+        } else if (write_logged) {
+            fprintf(stderr, "display_driver: panel writes recovered\n");
+            write_logged = false;
         }
+    } else if (fb_map) {
+        if (fb_swap_rb)
+            fb_blit_swap_rb(px_map, lv_area_get_size(area), fb_px_bytes);
+
+        fb_blit_area(&blit, px_map, area->x1, area->y1, area->x2, area->y2);
+    }
+
+    uint32_t dt = (uint32_t)(perf_now_us() - t0);
+    perf_record(PERF_FLUSH_US, dt);
+    frame_flush_us += dt;
+    frame_px += lv_area_get_size(area);
+    fb_dirty = true;
+    frame_drawn = true;
+    if (lv_display_flush_is_last(display)) {
+        perf_record(PERF_FRAME_FLUSH_US, (uint32_t)frame_flush_us);
+        frame_flush_us = 0;
+        perf_record(PERF_FRAME_PX, frame_px);
+        frame_px = 0;
+        perf_input_flushed();
     }
 
     lv_display_flush_ready(display);
 }
 
 /* ------------------------------------------------------------------ */
-/*  Public API                                                        */
+/*  Backlight                                                         */
 /* ------------------------------------------------------------------ */
 
-int display_driver_init(void)
+/**
+ * Write an FB_BLANK_* level to every sysfs backlight's bl_power.
+ * Returns the number of backlights updated.
+ */
+static int backlight_set_power(int level)
 {
-    /* Try framebuffer devices in order of preference */
-    const char *fb_devices[] = { "/dev/fb1", "/dev/fb0", NULL };
+    DIR *dir = opendir("/sys/class/backlight");
+    if (!dir) return 0;
 
-    for (int i = 0; fb_devices[i]; i++) {
-        if (fb_open(fb_devices[i]) == 0) {
-            fprintf(stderr, "display_driver_init: using %s\n", fb_devices[i]);
-            break;
-        }
+    struct dirent *ent;
+    int updated = 0;
+
+    while ((ent = readdir(dir)) != NULL) {
+        if (ent->d_name[0] == '.')
+            continue;
+
+        char path[300];
+        snprintf(path, sizeof(path), "/sys/class/backlight/%s/bl_power",
+                 ent->d_name);
+
+        FILE *f = fopen(path, "w");
+        if (!f) continue;
+        if (fprintf(f, "%d\n", level) > 0)
+            updated++;
+        fclose(f);
     }
 
-    if (fb_fd < 0) {
-        fprintf(stderr, "display_driver_init: no framebuffer found\n");
-        return -1;
+    closedir(dir);
+    return updated;
+}
+
+/* ------------------------------------------------------------------ */
+/*  Public API                                                        */
+/* ------------------------------------------------------------------ */
+
+int display_driver_init(const display_config_t *cfg)
+{
+    if (cfg) {
+        disp_cfg = *cfg;
+        if (disp_cfg.rotation != 0 && disp_cfg.rotation != 90 &&
+            disp_cfg.rotation != 180 && disp_cfg.rotation != 270) {
+            fprintf(stderr, "display_driver_init: invalid rotation %d, "
+                    "using 0\n", disp_cfg.rotation);
+            disp_cfg.rotation = 0;
+        }
     }
 
-    /* Stop the kernel console from writing over our framebuffer */
-    disable_console();
+    const char *fb_dev = NULL;
+
+    if (disp_cfg.backend == DISPLAY_BACKEND_SPI) {
+        if (DISP_HOR_RES != 480 || DISP_VER_RES != 320) {
+            fprintf(stderr, "display_driver_init: the SPI backend needs a "
+                    "480x320 build, this one is %dx%d\n",
+                    DISP_HOR_RES, DISP_VER_RES);
+            return -1;
+        }
+
+        /* Direct panel access: RGB565, orientation done by MADCTL */
+        spi_xport = ili9486_transport_open(disp_cfg.spi_device,
+                                           disp_cfg.spi_speed_hz);
+        if (spi_xport)
+            spi_xport->reg16 = disp_cfg.spi_regwidth == 16;
+        if (!spi_xport ||
+            ili9486_init(spi_xport, ili9486_madctl(disp_cfg.rotation,
+                                                   disp_cfg.mirror_h,
+                                                   disp_cfg.mirror_v)) != 0) {
+            fprintf(stderr, "display_driver_init: SPI panel init failed\n");
+            display_driver_deinit();
+            return -1;
+        }
+        fb_cf = LV_COLOR_FORMAT_RGB565;
+        fb_px_bytes = 2;
+    } else {
+        /* Try framebuffer devices in order of preference */
+        const char *fb_devices[] = { "/dev/fb1", "/dev/fb0", NULL };
+
+        for (int i = 0; fb_devices[i]; i++) {
+            if (fb_open(fb_devices[i]) == 0) {
+                fb_dev = fb_devices[i];
+                fprintf(stderr, "display_driver_init: using %s\n", fb_dev);
+                break;
+            }
+        }
+
+        if (fb_fd < 0) {
+            fprintf(stderr, "display_driver_init: no framebuffer found\n");
+            return -1;
+        }
+
+        /* Stop the kernel console from writing over our framebuffer */
+        disable_console();
+
+        /* Show the last frame straight away — before any LVGL display
+         * exists — or clear to black if there is no usable splash */
+        if (splash_show() == 0)
+            fprintf(stderr, "display_driver_init: restored splash from %s\n",
+                    SPLASH_PATH);
+        else
+            memset(fb_map, 0, fb_size);
+    }
 
     /* --- LVGL display registration (9.x API only) ----------------- */
 
@@ -224,25 +824,132 @@ int display_driver_init(void)
         return -1;
     }
 
-    disp = lv_display_create(DISP_HOR_RES, DISP_VER_RES);
+    fb_blit_setup(&blit, fb_map, fb_line_length, fb_px_bytes, DISP_HOR_RES,
+                  DISP_VER_RES, disp_cfg.rotation, disp_cfg.mirror_h,
+                  disp_cfg.mirror_v);
+    log_hor_res = blit.log_w;
+    log_ver_res = blit.log_h;
+
+    /* Optional HDMI mirror — never onto the panel's own framebuffer */
+    if (disp_cfg.hdmi_fb[0] != '\0') {
+        if (fb_dev && strcmp(disp_cfg.hdmi_fb, fb_dev) == 0)
+            fprintf(stderr, "display_driver_init: %s is the main display, "
+                    "not mirroring\n", disp_cfg.hdmi_fb);
+        else
+            sec_open(disp_cfg.hdmi_fb);
+    }
+
+    disp = lv_display_create(log_hor_res, log_ver_res);
     if (!disp) {
         fprintf(stderr, "display_driver_init: lv_display_create failed\n");
         display_driver_deinit();
         return -1;
     }
 
+    /* Render natively in the framebuffer format — must be set before
+     * the buffers so LVGL sizes its stride for the right pixel width */
+    lv_display_set_color_format(disp, fb_cf);
     lv_display_set_buffers(disp, draw_buf, NULL, DRAW_BUF_SIZE,
                            LV_DISPLAY_RENDER_MODE_PARTIAL);
     lv_display_set_flush_cb(disp, disp_flush_cb);
-
-    fprintf(stderr, "display_driver_init: %dx%d framebuffer ready\n",
-            DISP_HOR_RES, DISP_VER_RES);
+    lv_display_add_event_cb(disp, disp_refr_event_cb, LV_EVENT_REFR_START,
+                            NULL);
+    lv_display_add_event_cb(disp, disp_refr_event_cb, LV_EVENT_REFR_READY,
+                            NULL);
+
+    /* The splash is read back from the framebuffer — fbdev only */
+    if (fb_map)
+        splash_timer = lv_timer_create(splash_timer_cb, SPLASH_SAVE_MS, NULL);
+
+    fprintf(stderr, "display_driver_init: %dx%d %s ready "
+            "(%u bpp native render%s, rotation %d%s%s, %s rotate)\n",
+            log_hor_res, log_ver_res, spi_xport ? "SPI panel" : "framebuffer",
+            fb_px_bytes * 8,
+            fb_swap_rb ? ", R/B swapped" : "", disp_cfg.rotation,
+            disp_cfg.mirror_h ? ", mirror-h" : "",
+            disp_cfg.mirror_v ? ", mirror-v" : "",
+            blit.neon ? "NEON" : "scalar");
     return 0;
 }
 
+int display_driver_set_blank(bool blank)
+{
+    int level = blank ? FB_BLANK_POWERDOWN : FB_BLANK_UNBLANK;
+    int ok = 0;
+
+    /* Idle: a good time to keep the last frame for the next start */
+    if (blank && fb_dirty)
+        splash_save();
+
+    if (fb_fd >= 0) {
+        if (ioctl(fb_fd, FBIOBLANK, level) == 0)
+            ok = 1;
+        else
+            fprintf(stderr, "display_driver: FBIOBLANK failed: %s\n",
+                    strerror(errno));
+    }
+
+    if (spi_xport && ili9486_sleep(spi_xport, blank) == 0)
+        ok = 1;
+
+    if (sec_fd >= 0)
+        ioctl(sec_fd, FBIOBLANK, level);
+
+    if (backlight_set_power(level) > 0)
+        ok = 1;
+
+    return ok ? 0 : -1;
+}
+
+int32_t display_driver_get_hor_res(void)
+{
+    return log_hor_res;
+}
+
+int32_t display_driver_get_ver_res(void)
+{
+    return log_ver_res;
+}
+
+void display_driver_phys_to_logical(int16_t *x, int16_t *y)
+{
+    int32_t px = *x, py = *y;
+    int32_t mx, my;
+
+    /* Undo the rotation ... */
+    switch (disp_cfg.rotation) {
+    case 90:  mx = py;                    my = DISP_HOR_RES - 1 - px; break;
+    case 180: mx = DISP_HOR_RES - 1 - px; my = DISP_VER_RES - 1 - py; break;
+    case 270: mx = DISP_VER_RES - 1 - py; my = px;                    break;
+    default:  mx = px;                    my = py;                    break;
+    }
+
+    /* ... then the mirroring */
+    if (disp_cfg.mirror_h) mx = log_hor_res - 1 - mx;
+    if (disp_cfg.mirror_v) my = log_ver_res - 1 - my;
+
+    *x = (int16_t)mx;
+    *y = (int16_t)my;
+}
+
 void display_driver_deinit(void)
 {
+    if (splash_timer) {
+        lv_timer_delete(splash_timer);
+        splash_timer = NULL;
+    }
+
+    /* Keep the final frame for the next start */
+    if (fb_dirty)
+        splash_save();
+
     restore_console();
+    sec_close();
+
+    if (spi_xport) {
+        ili9486_close(spi_xport);
+        spi_xport = NULL;
+    }
 
     if (fb_map) {
         munmap(fb_map, fb_size);
@@ -0,0 +1,114 @@
+/**
+ * event_loop.c — Deadline-driven sleep for the LVGL main loop
+ *
+ * lv_timer_handler() returns the time until the next LVGL timer is due.
+ * LVGL pauses its refresh timer when nothing is invalidated and its
+ * animation timer when no animation runs, so that deadline is only at
+ * display rate while something is actually changing; otherwise it is
+ * the next app timer (HA poll, idle check, splash save).
+ *
+ * The timerfd gives the deadline nanosecond resolution; the eventfd
+ * carries wakeups from the touch thread, the config server and signals.
+ */
+
+#include "event_loop.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/timerfd.h>
+
+#include "lvgl.h"
+
+/* ------------------------------------------------------------------ */
+/*  Module-level state                                                */
+/* ------------------------------------------------------------------ */
+
+static int epoll_fd = -1;
+static int timer_fd = -1;
+static int wake_fd  = -1;
+
+/* ------------------------------------------------------------------ */
+/*  Internal helpers                                                  */
+/* ------------------------------------------------------------------ */
+
+/** Read and discard a counter descriptor's value (non-blocking). */
+static void drain(int fd)
+{
+    uint64_t v;
+    while (read(fd, &v, sizeof(v)) == (ssize_t)sizeof(v))
+        ;
+}
+
+static int add_fd(int fd)
+{
+    struct epoll_event ev;
+    memset(&ev, 0, sizeof(ev));
+    ev.events = EPOLLIN;
+    ev.data.fd = fd;
+    return epoll_ctl(epoll_fd, EPOLL_CTL_ADD, fd, &ev);
+}
+
+/* ------------------------------------------------------------------ */
+/*  Public API                                                        */
+/* ------------------------------------------------------------------ */
+
+int event_loop_init(void)
+{
+    epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+    timer_fd = timerfd_create(CLOCK_MONOTONIC, TFD_NONBLOCK | TFD_CLOEXEC);
+    wake_fd  = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+
+    if (epoll_fd < 0 || timer_fd < 0 || wake_fd < 0 ||
+        add_fd(timer_fd) != 0 || add_fd(wake_fd) != 0) {
+        fprintf(stderr, "event_loop_init: %s\n", strerror(errno));
+        event_loop_deinit();
+        return -1;
+    }
+    return 0;
+}
+
+void event_loop_wait(uint32_t timeout_ms)
+{
+    struct itimerspec its;
+    memset(&its, 0, sizeof(its));
+
+    /* An all-zero it_value disarms the timer: wait for a wake only */
+    if (timeout_ms != LV_NO_TIMER_READY) {
+        if (timeout_ms == 0) {
+            drain(wake_fd);
+            return;
+        }
+        its.it_value.tv_sec  = timeout_ms / 1000;
+        its.it_value.tv_nsec = (long)(timeout_ms % 1000) * 1000000L;
+    }
+    timerfd_settime(timer_fd, 0, &its, NULL);
+
+    struct epoll_event evs[2];
+    int n = epoll_wait(epoll_fd, evs, 2, -1);
+    if (n < 0 && errno != EINTR)
+        fprintf(stderr, "event_loop: epoll_wait: %s\n", strerror(errno));
+
+    for (int i = 0; i < n; i++)
+        drain(evs[i].data.fd);
+}
+
+void event_loop_wake(void)
+{
+    if (wake_fd >= 0) {
+        uint64_t one = 1;
+        ssize_t r = write(wake_fd, &one, sizeof(one));
+        (void)r;   /* Counter saturation still leaves it readable */
+    }
+}
+
+void event_loop_deinit(void)
+{
+    if (epoll_fd >= 0) close(epoll_fd);
+    if (timer_fd >= 0) close(timer_fd);
+    if (wake_fd >= 0)  close(wake_fd);
+    epoll_fd = timer_fd = wake_fd = -1;
+}
@@ -0,0 +1,254 @@
+/**
+ * fb_blit.c — Framebuffer pixel copies for the flush path
+ *
+ * The rotation / mirroring and red/blue swap copies behind
+ * display_driver.c's flush callback, kept free of LVGL so
+ * tools/flush_bench.c times exactly what ships.
+ */
+
+#include "fb_blit.h"
+
+#include <string.h>
+
+/* NEON transpose for rotated flushes: always on AArch64; on 32-bit
+ * ARM only when built with -mfpu=neon* (the Makefile's NEON=1) */
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define FB_BLIT_NEON 1
+#endif
+
+/* ------------------------------------------------------------------ */
+/*  Internal helpers                                                  */
+/* ------------------------------------------------------------------ */
+
+/**
+ * Copy a w×h logical rectangle pixel by pixel with the transform.
+ *
+ * @param src   Top-left source pixel
+ * @param sstr  Source stride in bytes
+ * @param dst   Framebuffer address of the top-left pixel
+ */
+static void blit_rect(const fb_blit_t *b, const uint8_t *src, size_t sstr,
+                      uint8_t *dst, int32_t w, int32_t h)
+{
+    ptrdiff_t step_x = b->step_x;
+
+    for (int32_t j = 0; j < h; j++) {
+        const uint8_t *s = src + (size_t)j * sstr;
+        uint8_t *d = dst + j * b->step_y;
+
+        switch (b->px_bytes) {
+        case 2:
+            for (int32_t i = 0; i < w; i++)
+                *(uint16_t *)(d + i * step_x) = ((const uint16_t *)s)[i];
+            break;
+        case 4:
+            for (int32_t i = 0; i < w; i++)
+                *(uint32_t *)(d + i * step_x) = ((const uint32_t *)s)[i];
+            break;
+        default:
+            for (int32_t i = 0; i < w; i++)
+                memcpy(d + i * step_x, s + i * 3, 3);
+            break;
+        }
+    }
+}
+
+#ifdef FB_BLIT_NEON
+/**
+ * Transpose one 8×8 block of RGB565 pixels in NEON registers.
+ *
+ * Logical column i of the block becomes 8 consecutive framebuffer
+ * pixels at dst + i * step_x, running forwards when step_y is +2 and
+ * backwards when it is -2.
+ */
+static void transpose8x8_u16(const fb_blit_t *b, const uint16_t *src,
+                             size_t sstr_px, uint8_t *dst)
+{
+    uint16x8_t r0 = vld1q_u16(src + 0 * sstr_px);
+    uint16x8_t r1 = vld1q_u16(src + 1 * sstr_px);
+    uint16x8_t r2 = vld1q_u16(src + 2 * sstr_px);
+    uint16x8_t r3 = vld1q_u16(src + 3 * sstr_px);
+    uint16x8_t r4 = vld1q_u16(src + 4 * sstr_px);
+    uint16x8_t r5 = vld1q_u16(src + 5 * sstr_px);
+    uint16x8_t r6 = vld1q_u16(src + 6 * sstr_px);
+    uint16x8_t r7 = vld1q_u16(src + 7 * sstr_px);
+
+    /* 16-bit, then 32-bit, then 64-bit interleaves */
+    uint16x8x2_t t01 = vtrnq_u16(r0, r1);
+    uint16x8x2_t t23 = vtrnq_u16(r2, r3);
+    uint16x8x2_t t45 = vtrnq_u16(r4, r5);
+    uint16x8x2_t t67 = vtrnq_u16(r6, r7);
+
+    uint32x4x2_t u02 = vtrnq_u32(vreinterpretq_u32_u16(t01.val[0]),
+                                 vreinterpretq_u32_u16(t23.val[0]));
+    uint32x4x2_t u13 = vtrnq_u32(vreinterpretq_u32_u16(t01.val[1]),
+                                 vreinterpretq_u32_u16(t23.val[1]));
+    uint32x4x2_t u46 = vtrnq_u32(vreinterpretq_u32_u16(t45.val[0]),
+                                 vreinterpretq_u32_u16(t67.val[0]));
+    uint32x4x2_t u57 = vtrnq_u32(vreinterpretq_u32_u16(t45.val[1]),
+                                 vreinterpretq_u32_u16(t67.val[1]));
+
+    uint16x8_t c[8];
+#define JOIN(lo, hi, half) vcombine_u16(                                  \
+        vget_##half##_u16(vreinterpretq_u16_u32(lo)),                      \
+        vget_##half##_u16(vreinterpretq_u16_u32(hi)))
+    c[0] = JOIN(u02.val[0], u46.val[0], low);
+    c[1] = JOIN(u13.val[0], u57.val[0], low);
+    c[2] = JOIN(u02.val[1], u46.val[1], low);
+    c[3] = JOIN(u13.val[1], u57.val[1], low);
+    c[4] = JOIN(u02.val[0], u46.val[0], high);
+    c[5] = JOIN(u13.val[0], u57.val[0], high);
+    c[6] = JOIN(u02.val[1], u46.val[1], high);
+    c[7] = JOIN(u13.val[1], u57.val[1], high);
+#undef JOIN
+
+    if (b->step_y > 0) {
+        for (int i = 0; i < 8; i++)
+            vst1q_u16((uint16_t *)(dst + i * b->step_x), c[i]);
+    } else {
+        for (int i = 0; i < 8; i++) {
+            uint16x8_t v = vrev64q_u16(c[i]);
+            v = vcombine_u16(vget_high_u16(v), vget_low_u16(v));
+            vst1q_u16((uint16_t *)(dst + i * b->step_x - 14), v);
+        }
+    }
+}
+#endif
+
+/* ------------------------------------------------------------------ */
+/*  Public API                                                        */
+/* ------------------------------------------------------------------ */
+
+void fb_blit_setup(fb_blit_t *b, uint8_t *fb, uint32_t line_length,
+                   uint32_t px_bytes, int32_t pw, int32_t ph, int rotation,
+                   bool mirror_h, bool mirror_v)
+{
+    bool swap = (rotation == 90 || rotation == 270);
+
+    b->fb = fb;
+    b->px_bytes = px_bytes;
+    b->log_w = swap ? ph : pw;
+    b->log_h = swap ? pw : ph;
+    b->neon = fb_blit_have_neon();
+
+    /* Mirrored logical coordinate: m = s * l + o */
+    int32_t sx = mirror_h ? -1 : 1;
+    int32_t ox = mirror_h ? b->log_w - 1 : 0;
+    int32_t sy = mirror_v ? -1 : 1;
+    int32_t oy = mirror_v ? b->log_h - 1 : 0;
+
+    /* Physical px = ax*lx + bx*ly + cx, py = ay*lx + by*ly + cy */
+    int32_t ax = 0, bx = 0, cx = 0, ay = 0, by = 0, cy = 0;
+    switch (rotation) {
+    case 90:   /* px = pw-1-my, py = mx */
+        bx = -sy; cx = pw - 1 - oy;
+        ay = sx;  cy = ox;
+        break;
+    case 180:  /* px = pw-1-mx, py = ph-1-my */
+        ax = -sx; cx = pw - 1 - ox;
+        by = -sy; cy = ph - 1 - oy;
+        break;
+    case 270:  /* px = my, py = ph-1-mx */
+        bx = sy;  cx = oy;
+        ay = -sx; cy = ph - 1 - ox;
+        break;
+    default:   /* px = mx, py = my */
+        ax = sx;  cx = ox;
+        by = sy;  cy = oy;
+        break;
+    }
+
+    ptrdiff_t line = (ptrdiff_t)line_length;
+    ptrdiff_t px = (ptrdiff_t)px_bytes;
+    b->step_x = ay * line + ax * px;
+    b->step_y = by * line + bx * px;
+    b->base   = cy * line + cx * px;
+}
+
+void fb_blit_area(const fb_blit_t *b, const uint8_t *px, int32_t x1,
+                  int32_t y1, int32_t x2, int32_t y2)
+{
+    int32_t w = x2 - x1 + 1;
+    int32_t h = y2 - y1 + 1;
+    size_t sstr = (size_t)w * b->px_bytes;
+    uint8_t *dst = b->fb + b->base + x1 * b->step_x + y1 * b->step_y;
+
+    /* Same row direction as the panel: plain row copies */
+    if (b->step_x == (ptrdiff_t)b->px_bytes) {
+        for (int32_t j = 0; j < h; j++)
+            memcpy(dst + j * b->step_y, px + (size_t)j * sstr, sstr);
+        return;
+    }
+
+    /* Rows reversed (180° / mirrored): rows are still contiguous, so
+     * tiling buys nothing */
+    if (b->step_x == -(ptrdiff_t)b->px_bytes) {
+        blit_rect(b, px, sstr, dst, w, h);
+        return;
+    }
+
+    /* 90° / 270°: blocked transpose, FB_BLIT_TILE×FB_BLIT_TILE at a time */
+    for (int32_t by = 0; by < h; by += FB_BLIT_TILE) {
+        int32_t th = (h - by < FB_BLIT_TILE) ? h - by : FB_BLIT_TILE;
+
+        for (int32_t bx = 0; bx < w; bx += FB_BLIT_TILE) {
+            int32_t tw = (w - bx < FB_BLIT_TILE) ? w - bx : FB_BLIT_TILE;
+            const uint8_t *s = px + (size_t)by * sstr
+                               + (size_t)bx * b->px_bytes;
+            uint8_t *d = dst + bx * b->step_x + by * b->step_y;
+
+#ifdef FB_BLIT_NEON
+            if (b->neon && b->px_bytes == 2) {
+                int32_t tw8 = tw & ~7, th8 = th & ~7;
+                for (int32_t j = 0; j < th8; j += 8)
+                    for (int32_t i = 0; i < tw8; i += 8)
+                        transpose8x8_u16(b, (const uint16_t *)(s + (size_t)j * sstr) + i,
+                                         (size_t)w, d + i * b->step_x
+                                         + j * b->step_y);
+                /* Right and bottom edges that don't fill an 8×8 block */
+                if (tw8 < tw)
+                    blit_rect(b, s + (size_t)tw8 * 2, sstr,
+                              d + tw8 * b->step_x, tw - tw8, th8);
+                if (th8 < th)
+                    blit_rect(b, s + (size_t)th8 * sstr, sstr,
+                              d + th8 * b->step_y, tw, th - th8);
+                continue;
+            }
+#endif
+            blit_rect(b, s, sstr, d, tw, th);
+        }
+    }
+}
+
+void fb_blit_swap_rb(uint8_t *px, uint32_t count, uint32_t px_bytes)
+{
+    if (px_bytes == 2) {
+        uint16_t *p = (uint16_t *)px;
+        for (uint32_t i = 0; i < count; i++) {
+            uint16_t c = p[i];
+            p[i] = (uint16_t)((c & 0x07E0) | (c >> 11) | (c << 11));
+        }
+    } else if (px_bytes == 3) {
+        for (uint32_t i = 0; i < count; i++, px += 3) {
+            uint8_t t = px[0];
+            px[0] = px[2];
+            px[2] = t;
+        }
+    } else {
+        uint32_t *p = (uint32_t *)px;
+        for (uint32_t i = 0; i < count; i++) {
+            uint32_t c = p[i];
+            p[i] = (c & 0xFF00FF00u) | ((c >> 16) & 0xFFu) | ((c & 0xFFu) << 16);
+        }
+    }
+}
+
+bool fb_blit_have_neon(void)
+{
+#ifdef FB_BLIT_NEON
+    return true;
+#else
+    return false;
+#endif
+}
@@ -2,7 +2,18 @@
  * ha_client.c — Home Assistant REST API client using libcurl
  *
  * Implements state fetching, light toggling, and polling via the HA REST API.
- * Uses a single reusable CURL handle for connection reuse.
+ * Uses a reusable CURL handle for connection reuse: one for the
+ * caller's requests and one for the poll thread.
+ *
+ * Polling runs on its own thread, so a poll of many lights, or one
+ * waiting on an unreachable server, never holds up the LVGL thread.
+ * Results reach the UI through light_ui_set_state / _set_offline,
+ * which only queue a command. The thread polls its own copy of the
+ * light list (ha_poll_set_lights).
+ *
+ * Toggles go the same way: ha_toggle_light only queues the entity and
+ * wakes the poll thread, which sends it before the next light of a
+ * running poll. A tap never waits on the HA round trip.
  *
  * Error handling (Req 11.1–11.4):
  *   - Connection errors: logged to stderr, last known states retained
@@ -17,9 +28,12 @@
 #include "light_ui.h"
 
 #include <curl/curl.h>
+#include <pthread.h>
+#include <stdatomic.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <time.h>
 
 /* ------------------------------------------------------------------ */
 /*  Internal state                                                    */
@@ -40,6 +54,26 @@ static struct curl_slist *s_headers = NULL;
 /** Stored base URL. */
 static char s_base_url[256] = {0};
 
+/* Poll thread. The light list and its flags are shared with any thread
+ * under s_poll_lock; the CURL handle belongs to the thread */
+static CURL           *s_poll_curl = NULL;
+static pthread_t       s_poll_thread;
+static bool            s_poll_running = false;  /* Thread started       */
+static unsigned        s_poll_interval_ms = 0;
+static pthread_mutex_t s_poll_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t  s_poll_cond;
+static light_config_t *s_poll_lights = NULL;    /* malloc'd copy        */
+static int             s_poll_count = 0;
+static bool            s_poll_now = false;      /* List changed: poll   */
+static atomic_bool     s_poll_stop = false;     /* Set under the lock   */
+
+/** Toggles waiting for the poll thread (a ring, under s_poll_lock). */
+#define HA_TOGGLE_QUEUE_LEN   8
+
+static char            s_toggle_q[HA_TOGGLE_QUEUE_LEN][64]; /* Entity IDs */
+static int             s_toggle_head = 0;       /* Oldest entry         */
+static int             s_toggle_count = 0;
+
 /** Buffer for accumulating HTTP response body. */
 typedef struct {
     char   data[HA_RESPONSE_BUF_SIZE];
@@ -146,12 +180,14 @@ static light_state_t state_str_to_enum(const char *state_str)
 /**
  * Perform a GET request and store the response body.
  *
+ * @param curl Handle to use (s_curl, or s_poll_curl on the poll thread)
  * @param url  Full URL to GET
  * @param resp Response buffer (cleared before use)
  * @param http_code  Output: HTTP status code (0 on connection error)
  * @return 0 on success (HTTP request completed), -1 on connection error
  */
-static int ha_http_get(const char *url, response_buf_t *resp, long *http_code)
+static int ha_http_get(CURL *curl, const char *url, response_buf_t *resp,
+                       long *http_code)
 {
     CURLcode res;
 
@@ -159,14 +195,15 @@ static int ha_http_get(const char *url, response_buf_t *resp, long *http_code)
     resp->data[0] = '\0';
     *http_code = 0;
 
-    curl_easy_setopt(s_curl, CURLOPT_URL, url);
-    curl_easy_setopt(s_curl, CURLOPT_HTTPGET, 1L);
-    curl_easy_setopt(s_curl, CURLOPT_POST, 0L);
-    curl_easy_setopt(s_curl, CURLOPT_POSTFIELDS, NULL);
-    curl_easy_setopt(s_curl, CURLOPT_WRITEFUNCTION, write_cb);
-    curl_easy_setopt(s_curl, CURLOPT_WRITEDATA, resp);
+    /* Clear the body first: setting CURLOPT_POSTFIELDS, even to NULL,
+     * selects POST again, so HTTPGET must come last */
+    curl_easy_setopt(curl, CURLOPT_URL, url);
+    curl_easy_setopt(curl, CURLOPT_POSTFIELDS, NULL);
+    curl_easy_setopt(curl, CURLOPT_HTTPGET, 1L);
+    curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, write_cb);
+    curl_easy_setopt(curl, CURLOPT_WRITEDATA, resp);
 
-    res = curl_easy_perform(s_curl);
+    res = curl_easy_perform(curl);
     if (res != CURLE_OK) {
         /* Req 11.1: log connection error to stderr */
         fprintf(stderr, "ha_client: GET %s failed: %s\n",
@@ -174,20 +211,21 @@ static int ha_http_get(const char *url, response_buf_t *resp, long *http_code)
         return -1;
     }
 
-    curl_easy_getinfo(s_curl, CURLINFO_RESPONSE_CODE, http_code);
+    curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, http_code);
     return 0;
 }
 
 /**
  * Perform a POST request with a JSON body.
  *
+ * @param curl      Handle to use
  * @param url       Full URL to POST
  * @param json_body JSON request body
  * @param resp      Response buffer (cleared before use)
  * @param http_code Output: HTTP status code (0 on connection error)
  * @return 0 on success (HTTP request completed), -1 on connection error
  */
-static int ha_http_post(const char *url, const char *json_body,
+static int ha_http_post(CURL *curl, const char *url, const char *json_body,
                         response_buf_t *resp, long *http_code)
 {
     CURLcode res;
@@ -196,80 +234,68 @@ static int ha_http_post(const char *url, const char *json_body,
     resp->data[0] = '\0';
     *http_code = 0;
 
-    curl_easy_setopt(s_curl, CURLOPT_URL, url);
-    curl_easy_setopt(s_curl, CURLOPT_POST, 1L);
-    curl_easy_setopt(s_curl, CURLOPT_POSTFIELDS, json_body);
-    curl_easy_setopt(s_curl, CURLOPT_WRITEFUNCTION, write_cb);
-    curl_easy_setopt(s_curl, CURLOPT_WRITEDATA, resp);
+    curl_easy_setopt(curl, CURLOPT_URL, url);
+    curl_easy_setopt(curl, CURLOPT_POST, 1L);
+    curl_easy_setopt(curl, CURLOPT_POSTFIELDS, json_body);
+    curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, write_cb);
+    curl_easy_setopt(curl, CURLOPT_WRITEDATA, resp);
 
-    res = curl_easy_perform(s_curl);
+    res = curl_easy_perform(curl);
     if (res != CURLE_OK) {
         fprintf(stderr, "ha_client: POST %s failed: %s\n",
                 url, curl_easy_strerror(res));
         return -1;
     }
 
-    curl_easy_getinfo(s_curl, CURLINFO_RESPONSE_CODE, http_code);
+    curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, http_code);
     return 0;
 }
 
-/* ------------------------------------------------------------------ */
-/*  Public API                                                        */
-/* ------------------------------------------------------------------ */
-
-int ha_client_init(const char *base_url, const char *token)
+/**
+ * Create a CURL handle with the auth headers and timeouts set.
+ *
+ * @return The handle, or NULL on failure (logged)
+ */
+static CURL *open_handle(void)
 {
-    char auth_header[600];
-
-    if (!base_url || !token) {
-        fprintf(stderr, "ha_client: base_url and token must not be NULL\n");
-        return -1;
-    }
-
-    /* Store base URL (strip trailing slash if present) */
-    snprintf(s_base_url, sizeof(s_base_url), "%s", base_url);
-    size_t len = strlen(s_base_url);
-    if (len > 0 && s_base_url[len - 1] == '/')
-        s_base_url[len - 1] = '\0';
-
-    /* Create reusable CURL handle (Req 6.6) */
-    s_curl = curl_easy_init();
-    if (!s_curl) {
+    CURL *curl = curl_easy_init();
+    if (!curl) {
         fprintf(stderr, "ha_client: curl_easy_init() failed\n");
-        return -1;
+        return NULL;
     }
 
-    /* Build Authorization header (Req 6.5) */
-    snprintf(auth_header, sizeof(auth_header), "Authorization: Bearer %s", token);
-
-    /* Set headers: Authorization + Content-Type for POST requests */
-    s_headers = curl_slist_append(NULL, auth_header);
-    s_headers = curl_slist_append(s_headers, "Content-Type: application/json");
-
-    curl_easy_setopt(s_curl, CURLOPT_HTTPHEADER, s_headers);
+    curl_easy_setopt(curl, CURLOPT_HTTPHEADER, s_headers);
 
     /* Connection timeout: 5 seconds to avoid blocking the UI too long */
-    curl_easy_setopt(s_curl, CURLOPT_CONNECTTIMEOUT, 5L);
-    curl_easy_setopt(s_curl, CURLOPT_TIMEOUT, 10L);
-
-    return 0;
+    curl_easy_setopt(curl, CURLOPT_CONNECTTIMEOUT, 5L);
+    curl_easy_setopt(curl, CURLOPT_TIMEOUT, 10L);
+    curl_easy_setopt(curl, CURLOPT_NOSIGNAL, 1L);
+    return curl;
 }
 
-light_state_t ha_get_state(const char *entity_id)
+/* ------------------------------------------------------------------ */
+/*  State and toggle requests                                         */
+/* ------------------------------------------------------------------ */
+
+/**
+ * GET one entity's state.
+ *
+ * @param curl       Handle to use (s_curl, or s_poll_curl on the poll thread)
+ * @param entity_id  HA entity ID
+ * @return LIGHT_STATE_ON, LIGHT_STATE_OFF, or LIGHT_STATE_UNKNOWN
+ */
+static light_state_t fetch_state(CURL *curl, const char *entity_id)
 {
     char url[HA_URL_BUF_SIZE];
     response_buf_t resp;
     long http_code = 0;
     char state_str[32] = {0};
 
-    if (!s_curl || !entity_id)
-        return LIGHT_STATE_UNKNOWN;
-
     /* Build URL: GET /api/states/<entity_id> (Req 6.2) */
     snprintf(url, sizeof(url), "%s/api/states/%s", s_base_url, entity_id);
 
     /* Perform GET request */
-    if (ha_http_get(url, &resp, &http_code) != 0) {
+    if (ha_http_get(curl, url, &resp, &http_code) != 0) {
         /* Req 11.1: connection error — return UNKNOWN, caller retains
          * last known state by not calling light_ui_set_state */
         return LIGHT_STATE_UNKNOWN;
@@ -292,7 +318,15 @@ light_state_t ha_get_state(const char *entity_id)
     return state_str_to_enum(state_str);
 }
 
-int ha_toggle_light(const char *entity_id)
+/**
+ * Toggle one light: fetch its state, then POST the opposite service.
+ * Runs on the poll thread (run_toggles).
+ *
+ * @param curl       Handle to use
+ * @param entity_id  HA entity ID
+ * @return 0 on success, -1 on failure (logged)
+ */
+static int send_toggle(CURL *curl, const char *entity_id)
 {
     char url[HA_URL_BUF_SIZE];
     char body[128];
@@ -300,11 +334,8 @@ int ha_toggle_light(const char *entity_id)
     long http_code = 0;
     light_state_t current;
 
-    if (!s_curl || !entity_id)
-        return -1;
-
     /* Fetch current state to decide which service to call (Req 5.3) */
-    current = ha_get_state(entity_id);
+    current = fetch_state(curl, entity_id);
 
     /* Determine service endpoint:
      *   ON  → turn_off
@@ -337,7 +368,7 @@ int ha_toggle_light(const char *entity_id)
     snprintf(body, sizeof(body), "{\"entity_id\": \"%s\"}", entity_id);
 
     /* Perform POST request */
-    if (ha_http_post(url, body, &resp, &http_code) != 0) {
+    if (ha_http_post(curl, url, body, &resp, &http_code) != 0) {
         /* Req 11.3: toggle failure — optimistic state reverts on next poll */
         fprintf(stderr, "ha_client: toggle failed for %s (connection error)\n",
                 entity_id);
@@ -353,10 +384,44 @@ int ha_toggle_light(const char *entity_id)
     return 0;
 }
 
-void ha_poll_all(const light_config_t *lights, int count)
+/**
+ * Send every queued toggle, oldest first. Poll thread only, without
+ * s_poll_lock held.
+ */
+static void run_toggles(void)
 {
-    if (!s_curl || !lights || count <= 0)
-        return;
+    char entity_id[sizeof(s_toggle_q[0])];
+
+    for (;;) {
+        pthread_mutex_lock(&s_poll_lock);
+        if (s_toggle_count == 0 || atomic_load(&s_poll_stop)) {
+            pthread_mutex_unlock(&s_poll_lock);
+            return;
+        }
+        memcpy(entity_id, s_toggle_q[s_toggle_head], sizeof(entity_id));
+        s_toggle_head = (s_toggle_head + 1) % HA_TOGGLE_QUEUE_LEN;
+        s_toggle_count--;
+        pthread_mutex_unlock(&s_poll_lock);
+
+        send_toggle(s_poll_curl, entity_id);
+    }
+}
+
+/* ------------------------------------------------------------------ */
+/*  Poll thread                                                       */
+/* ------------------------------------------------------------------ */
+
+/**
+ * Poll each light once and report to the UI.
+ *
+ * On connection error, retains last known tile states (skips the UI
+ * update for that entity). If the server cannot be reached at all the
+ * poll stops early and reports it through light_ui_set_offline(true);
+ * any answer reports it back online.
+ */
+static void poll_lights(const light_config_t *lights, int count)
+{
+    bool reached = false;
 
     for (int i = 0; i < count; i++) {
         char url[HA_URL_BUF_SIZE];
@@ -364,23 +429,37 @@ void ha_poll_all(const light_config_t *lights, int count)
         long http_code = 0;
         char state_str[32] = {0};
 
+        /* A tap waits for at most one light's request */
+        run_toggles();
+
+        /* ha_client_cleanup is waiting */
+        if (atomic_load(&s_poll_stop))
+            return;
+
         /* Build URL for this entity */
         snprintf(url, sizeof(url), "%s/api/states/%s",
                  s_base_url, lights[i].entity_id);
 
         /* Perform GET request */
-        if (ha_http_get(url, &resp, &http_code) != 0) {
+        if (ha_http_get(s_poll_curl, url, &resp, &http_code) != 0) {
             /* Req 11.1: connection error — retain last known state.
              * Skip light_ui_set_state so tile keeps its current appearance.
-             * Req 11.4: automatic retry on next poll interval. */
+             * Req 11.4: automatic retry on next poll interval. The rest
+             * of this poll would only wait on the same dead server, so
+             * stop here unless it answered for an earlier light. */
+            if (!reached) {
+                light_ui_set_offline(true);
+                return;
+            }
             continue;
         }
+        reached = true;
 
         /* Req 11.2: HTTP 4xx/5xx → set entity to UNKNOWN */
         if (http_code >= 400) {
             fprintf(stderr, "ha_client: poll %s returned HTTP %ld\n",
                     lights[i].entity_id, http_code);
-            light_ui_set_state(i, LIGHT_STATE_UNKNOWN);
+            light_ui_set_state(lights[i].entity_id, LIGHT_STATE_UNKNOWN);
             continue;
         }
 
@@ -388,17 +467,247 @@ void ha_poll_all(const light_config_t *lights, int count)
         if (parse_state_field(resp.data, state_str, sizeof(state_str)) != 0) {
             fprintf(stderr, "ha_client: no \"state\" field for %s\n",
                     lights[i].entity_id);
-            light_ui_set_state(i, LIGHT_STATE_UNKNOWN);
+            light_ui_set_state(lights[i].entity_id, LIGHT_STATE_UNKNOWN);
             continue;
         }
 
-        light_state_t state = state_str_to_enum(state_str);
-        light_ui_set_state(i, state);
+        light_ui_set_state(lights[i].entity_id,
+                           state_str_to_enum(state_str));
     }
+
+    if (reached)
+        light_ui_set_offline(false);
+}
+
+/**
+ * Poll thread: poll at once, then every s_poll_interval_ms, or early
+ * when the light list changes. Queued toggles are sent as soon as they
+ * arrive, without restarting the interval.
+ */
+static void *poll_thread_fn(void *arg)
+{
+    light_config_t *lights = NULL;
+    int cap = 0;
+    bool due = true;   /* Interval elapsed: poll */
+    struct timespec deadline;
+
+    (void)arg;
+    pthread_mutex_lock(&s_poll_lock);
+    while (!atomic_load(&s_poll_stop)) {
+        if (due || s_poll_now) {
+            /* Poll a copy, so the list can change while the poll runs */
+            int count = s_poll_count;
+            if (count > cap) {
+                light_config_t *grown =
+                    realloc(lights, (size_t)count * sizeof(*lights));
+                if (grown) {
+                    lights = grown;
+                    cap = count;
+                } else {
+                    fprintf(stderr, "ha_client: out of memory, polling %d of "
+                            "%d lights\n", cap, count);
+                    count = cap;
+                }
+            }
+            if (count > 0)
+                memcpy(lights, s_poll_lights, (size_t)count * sizeof(*lights));
+            s_poll_now = false;
+            pthread_mutex_unlock(&s_poll_lock);
+
+            poll_lights(lights, count);
+
+            clock_gettime(CLOCK_MONOTONIC, &deadline);
+            deadline.tv_sec += s_poll_interval_ms / 1000;
+            deadline.tv_nsec += (long)(s_poll_interval_ms % 1000) * 1000000L;
+            if (deadline.tv_nsec >= 1000000000L) {
+                deadline.tv_sec++;
+                deadline.tv_nsec -= 1000000000L;
+            }
+            due = false;
+            pthread_mutex_lock(&s_poll_lock);
+        }
+
+        /* Toggles queued while idle, or during a poll that ended early */
+        if (s_toggle_count > 0) {
+            pthread_mutex_unlock(&s_poll_lock);
+            run_toggles();
+            pthread_mutex_lock(&s_poll_lock);
+            continue;
+        }
+
+        int rc = 0;
+        while (!atomic_load(&s_poll_stop) && !s_poll_now &&
+               s_toggle_count == 0 && rc == 0)
+            rc = pthread_cond_timedwait(&s_poll_cond, &s_poll_lock,
+                                        &deadline);
+        if (rc != 0)
+            due = true;
+    }
+    pthread_mutex_unlock(&s_poll_lock);
+
+    free(lights);
+    return NULL;
+}
+
+/* ------------------------------------------------------------------ */
+/*  Public API                                                        */
+/* ------------------------------------------------------------------ */
+
+int ha_client_init(const char *base_url, const char *token)
+{
+    char auth_header[600];
+
+    if (!base_url || !token) {
+        fprintf(stderr, "ha_client: base_url and token must not be NULL\n");
+        return -1;
+    }
+
+    /* Store base URL (strip trailing slash if present) */
+    snprintf(s_base_url, sizeof(s_base_url), "%s", base_url);
+    size_t len = strlen(s_base_url);
+    if (len > 0 && s_base_url[len - 1] == '/')
+        s_base_url[len - 1] = '\0';
+
+    /* Build Authorization header (Req 6.5) */
+    snprintf(auth_header, sizeof(auth_header), "Authorization: Bearer %s", token);
+
+    /* Set headers: Authorization + Content-Type for POST requests */
+    s_headers = curl_slist_append(NULL, auth_header);
+    s_headers = curl_slist_append(s_headers, "Content-Type: application/json");
+
+    /* Create reusable CURL handle (Req 6.6) */
+    s_curl = open_handle();
+    if (!s_curl)
+        return -1;
+
+    return 0;
+}
+
+light_state_t ha_get_state(const char *entity_id)
+{
+    if (!s_curl || !entity_id)
+        return LIGHT_STATE_UNKNOWN;
+
+    return fetch_state(s_curl, entity_id);
+}
+
+int ha_toggle_light(const char *entity_id)
+{
+    int ret = -1;
+
+    if (!entity_id)
+        return -1;
+
+    pthread_mutex_lock(&s_poll_lock);
+    if (!s_poll_running) {
+        fprintf(stderr, "ha_client: not running, toggle of %s dropped\n",
+                entity_id);
+    } else if (s_toggle_count == HA_TOGGLE_QUEUE_LEN) {
+        /* Req 11.3: the optimistic state reverts on the next poll */
+        fprintf(stderr, "ha_client: toggle queue full, %s dropped\n",
+                entity_id);
+    } else {
+        int tail = (s_toggle_head + s_toggle_count) % HA_TOGGLE_QUEUE_LEN;
+        snprintf(s_toggle_q[tail], sizeof(s_toggle_q[tail]), "%s",
+                 entity_id);
+        s_toggle_count++;
+        pthread_cond_signal(&s_poll_cond);
+        ret = 0;
+    }
+    pthread_mutex_unlock(&s_poll_lock);
+    return ret;
+}
+
+void ha_poll_set_lights(const light_config_t *lights, int count)
+{
+    light_config_t *copy = NULL;
+
+    if (count < 0 || !lights) count = 0;
+    if (count > 0) {
+        copy = malloc((size_t)count * sizeof(*copy));
+        if (!copy) {
+            fprintf(stderr, "ha_client: out of memory, keeping the old "
+                    "poll list\n");
+            return;
+        }
+        memcpy(copy, lights, (size_t)count * sizeof(*copy));
+    }
+
+    pthread_mutex_lock(&s_poll_lock);
+    free(s_poll_lights);
+    s_poll_lights = copy;
+    s_poll_count = count;
+    s_poll_now = true;
+    if (s_poll_running)
+        pthread_cond_signal(&s_poll_cond);
+    pthread_mutex_unlock(&s_poll_lock);
+}
+
+int ha_poll_start(const light_config_t *lights, int count,
+                  unsigned interval_ms)
+{
+    pthread_condattr_t attr;
+
+    if (!s_curl || s_poll_running)
+        return -1;
+
+    s_poll_curl = open_handle();
+    if (!s_poll_curl)
+        return -1;
+
+    ha_poll_set_lights(lights, count);
+    s_poll_interval_ms = interval_ms;
+    atomic_store(&s_poll_stop, false);
+
+    /* Deadlines on the monotonic clock: immune to NTP steps at boot */
+    pthread_condattr_init(&attr);
+    pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+    pthread_cond_init(&s_poll_cond, &attr);
+    pthread_condattr_destroy(&attr);
+
+    if (pthread_create(&s_poll_thread, NULL, poll_thread_fn, NULL) != 0) {
+        fprintf(stderr, "ha_client: failed to create poll thread\n");
+        pthread_cond_destroy(&s_poll_cond);
+        curl_easy_cleanup(s_poll_curl);
+        s_poll_curl = NULL;
+        return -1;
+    }
+
+    pthread_mutex_lock(&s_poll_lock);
+    s_poll_running = true;
+    pthread_mutex_unlock(&s_poll_lock);
+    return 0;
 }
 
 void ha_client_cleanup(void)
 {
+    /* Stop the poll thread first: it uses the shared headers */
+    pthread_mutex_lock(&s_poll_lock);
+    bool running = s_poll_running;
+    s_poll_running = false;
+    atomic_store(&s_poll_stop, true);
+    if (running)
+        pthread_cond_signal(&s_poll_cond);
+    pthread_mutex_unlock(&s_poll_lock);
+
+    if (running) {
+        pthread_join(s_poll_thread, NULL);
+        pthread_cond_destroy(&s_poll_cond);
+    }
+
+    if (s_poll_curl) {
+        curl_easy_cleanup(s_poll_curl);
+        s_poll_curl = NULL;
+    }
+
+    pthread_mutex_lock(&s_poll_lock);
+    free(s_poll_lights);
+    s_poll_lights = NULL;
+    s_poll_count = 0;
+    s_toggle_head = 0;
+    s_toggle_count = 0;   /* Unsent toggles die with the client */
+    pthread_mutex_unlock(&s_poll_lock);
+
     if (s_headers) {
         curl_slist_free_all(s_headers);
         s_headers = NULL;
@@ -0,0 +1,562 @@
+/**
+ * ili9486.c — Direct ILI9486 panel protocol over a pluggable transport
+ *
+ * Protocol: a command is one byte with DC low, its parameters follow
+ * with DC high. Pixels are written as CASET (0x2A) / RASET (0x2B) to
+ * set the address window, then RAMWR (0x2C) and the window's pixels as
+ * big-endian RGB565. The controller keeps auto-incrementing through the
+ * window across chip-select toggles, so the pixel data can be split
+ * into as many transfers as the transport needs.
+ *
+ * spidev transport: the SPI node carries the bytes; DC, RST and BL are
+ * driven through /dev/gpiochip0 line handles. Transfers are capped at
+ * spidev's bufsiz module parameter (4096 unless raised with
+ * spidev.bufsiz=N on the kernel command line).
+ */
+
+#include "ili9486.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <sys/ioctl.h>
+#include <linux/gpio.h>
+#include <linux/spi/spidev.h>
+
+/* ------------------------------------------------------------------ */
+/*  Configuration                                                     */
+/* ------------------------------------------------------------------ */
+
+#define GPIO_CHIP        "/dev/gpiochip0"
+#define GPIO_DC          25
+#define GPIO_RST         27
+#define GPIO_BL          18
+
+#define SPI_DEFAULT_HZ   24000000u
+#define SPI_BUFSIZ_PATH  "/sys/module/spidev/parameters/bufsiz"
+#define SPI_BUFSIZ_DEF   4096
+
+#define MEM_SINK_CAP     (4u * 1024 * 1024)   /* Recorded bytes kept  */
+
+/* ILI9486 commands */
+#define CMD_SLPIN   0x10
+#define CMD_SLPOUT  0x11
+#define CMD_DISPOFF 0x28
+#define CMD_DISPON  0x29
+#define CMD_CASET   0x2A
+#define CMD_RASET   0x2B
+#define CMD_RAMWR   0x2C
+#define CMD_MADCTL  0x36
+#define CMD_COLMOD  0x3A
+
+/* MADCTL bits */
+#define MADCTL_MY   0x80
+#define MADCTL_MX   0x40
+#define MADCTL_MV   0x20
+#define MADCTL_BGR  0x08
+
+/* ------------------------------------------------------------------ */
+/*  Window cache                                                      */
+/* ------------------------------------------------------------------ */
+
+/** Forget t's address window, so the next write resends it. */
+static void win_reset(ili9486_transport_t *t)
+{
+    t->win_x1 = t->win_y1 = t->win_x2 = t->win_y2 = -1;
+}
+
+/* ------------------------------------------------------------------ */
+/*  spidev transport                                                  */
+/* ------------------------------------------------------------------ */
+
+typedef struct {
+    ili9486_transport_t base;
+    int spi_fd;
+    int dc_fd, rst_fd, bl_fd;   /* GPIO line handles, -1 if absent */
+    int dc_level;               /* Current DC level, -1 = unknown  */
+    bool write_logged;          /* Failure reported this spell     */
+} spidev_transport_t;
+
+/** Request one GPIO line as an output. Returns the handle fd or -1. */
+static int gpio_request_output(int chip_fd, unsigned int line, int value)
+{
+    struct gpiohandle_request req;
+    memset(&req, 0, sizeof(req));
+    req.lineoffsets[0] = line;
+    req.lines = 1;
+    req.flags = GPIOHANDLE_REQUEST_OUTPUT;
+    req.default_values[0] = (uint8_t)value;
+    snprintf(req.consumer_label, sizeof(req.consumer_label), "ha_lights");
+
+    if (ioctl(chip_fd, GPIO_GET_LINEHANDLE_IOCTL, &req) < 0) {
+        fprintf(stderr, "ili9486: cannot claim GPIO %u: %s\n", line,
+                strerror(errno));
+        return -1;
+    }
+    return req.fd;
+}
+
+static void gpio_set(int fd, int value)
+{
+    if (fd < 0) return;
+
+    struct gpiohandle_data data;
+    memset(&data, 0, sizeof(data));
+    data.values[0] = (uint8_t)value;
+    ioctl(fd, GPIOHANDLE_SET_LINE_VALUES_IOCTL, &data);
+}
+
+/** Read spidev's per-transfer buffer limit. */
+static size_t spidev_bufsiz(void)
+{
+    FILE *f = fopen(SPI_BUFSIZ_PATH, "r");
+    unsigned long v = 0;
+
+    if (f) {
+        if (fscanf(f, "%lu", &v) != 1)
+            v = 0;
+        fclose(f);
+    }
+    return v ? (size_t)v : SPI_BUFSIZ_DEF;
+}
+
+static int spidev_write(ili9486_transport_t *t, bool data,
+                        const uint8_t *buf, size_t len)
+{
+    spidev_transport_t *s = (spidev_transport_t *)t;
+
+    if (s->dc_level != (int)data) {
+        gpio_set(s->dc_fd, data);
+        s->dc_level = data;
+    }
+
+    ssize_t n = write(s->spi_fd, buf, len);
+    if (n != (ssize_t)len) {
+        /* Once per spell: a dead bus fails every transfer of every area */
+        if (!s->write_logged)
+            fprintf(stderr, "ili9486: spi write failed: %s\n",
+                    n < 0 ? strerror(errno) : "short write");
+        s->write_logged = true;
+        return -1;
+    }
+    s->write_logged = false;
+    return 0;
+}
+
+static void spidev_reset(ili9486_transport_t *t)
+{
+    spidev_transport_t *s = (spidev_transport_t *)t;
+    if (s->rst_fd < 0) return;
+
+    gpio_set(s->rst_fd, 0);
+    usleep(20000);
+    gpio_set(s->rst_fd, 1);
+    usleep(120000);
+}
+
+static void spidev_backlight(ili9486_transport_t *t, bool on)
+{
+    gpio_set(((spidev_transport_t *)t)->bl_fd, on);
+}
+
+static void spidev_close(ili9486_transport_t *t)
+{
+    spidev_transport_t *s = (spidev_transport_t *)t;
+
+    if (s->spi_fd >= 0) close(s->spi_fd);
+    if (s->dc_fd >= 0)  close(s->dc_fd);
+    if (s->rst_fd >= 0) close(s->rst_fd);
+    if (s->bl_fd >= 0)  close(s->bl_fd);
+    free(s);
+}
+
+static ili9486_transport_t *spidev_open(const char *dev, uint32_t speed_hz)
+{
+    spidev_transport_t *s = (spidev_transport_t *)calloc(1, sizeof(*s));
+    if (!s) return NULL;
+
+    s->base.write = spidev_write;
+    s->base.reset = spidev_reset;
+    s->base.backlight = spidev_backlight;
+    s->base.close = spidev_close;
+    s->base.max_xfer = spidev_bufsiz();
+    win_reset(&s->base);
+    s->dc_fd = s->rst_fd = s->bl_fd = -1;
+    s->dc_level = -1;
+
+    s->spi_fd = open(dev, O_RDWR);
+    if (s->spi_fd < 0) {
+        fprintf(stderr, "ili9486: cannot open %s: %s\n", dev, strerror(errno));
+        spidev_close(&s->base);
+        return NULL;
+    }
+
+    uint8_t mode = SPI_MODE_0, bits = 8;
+    if (ioctl(s->spi_fd, SPI_IOC_WR_MODE, &mode) < 0 ||
+        ioctl(s->spi_fd, SPI_IOC_WR_BITS_PER_WORD, &bits) < 0 ||
+        ioctl(s->spi_fd, SPI_IOC_WR_MAX_SPEED_HZ, &speed_hz) < 0) {
+        fprintf(stderr, "ili9486: cannot configure %s: %s\n", dev,
+                strerror(errno));
+        spidev_close(&s->base);
+        return NULL;
+    }
+
+    int chip_fd = open(GPIO_CHIP, O_RDWR);
+    if (chip_fd < 0) {
+        fprintf(stderr, "ili9486: cannot open %s: %s\n", GPIO_CHIP,
+                strerror(errno));
+        spidev_close(&s->base);
+        return NULL;
+    }
+    s->dc_fd  = gpio_request_output(chip_fd, GPIO_DC, 0);
+    s->rst_fd = gpio_request_output(chip_fd, GPIO_RST, 1);
+    s->bl_fd  = gpio_request_output(chip_fd, GPIO_BL, 0);
+    close(chip_fd);
+
+    /* Without DC every byte would be misread as a command */
+    if (s->dc_fd < 0) {
+        spidev_close(&s->base);
+        return NULL;
+    }
+
+    fprintf(stderr, "ili9486: %s at %u Hz, %zu-byte transfers\n", dev,
+            speed_hz, s->base.max_xfer);
+    return &s->base;
+}
+
+/* ------------------------------------------------------------------ */
+/*  File and memory sinks                                             */
+/* ------------------------------------------------------------------ */
+
+typedef struct {
+    ili9486_transport_t base;
+    FILE *file;          /* File sink, NULL for the memory sink     */
+    uint8_t *buf;        /* Memory sink recording                   */
+    size_t len;
+    size_t cap;
+    bool full;           /* A record was dropped: record no more     */
+    bool write_logged;   /* File sink failure reported this spell    */
+} sink_transport_t;
+
+/** Encode the 5-byte record header: DC, then LE uint32 length. */
+static void sink_header(uint8_t hdr[5], bool data, size_t len)
+{
+    hdr[0] = data ? 1 : 0;
+    hdr[1] = (uint8_t)len;
+    hdr[2] = (uint8_t)(len >> 8);
+    hdr[3] = (uint8_t)(len >> 16);
+    hdr[4] = (uint8_t)(len >> 24);
+}
+
+static int file_sink_write(ili9486_transport_t *t, bool data,
+                           const uint8_t *buf, size_t len)
+{
+    sink_transport_t *s = (sink_transport_t *)t;
+    uint8_t hdr[5];
+
+    sink_header(hdr, data, len);
+    if (fwrite(hdr, 1, sizeof(hdr), s->file) != sizeof(hdr) ||
+        fwrite(buf, 1, len, s->file) != len) {
+        if (!s->write_logged)
+            fprintf(stderr, "ili9486: file sink write failed\n");
+        s->write_logged = true;
+        return -1;
+    }
+    s->write_logged = false;
+    return 0;
+}
+
+static int mem_sink_write(ili9486_transport_t *t, bool data,
+                          const uint8_t *buf, size_t len)
+{
+    sink_transport_t *s = (sink_transport_t *)t;
+    size_t need = s->len + 5 + len;
+
+    if (s->full)
+        return 0;       /* Full: keep counting, stop recording */
+    if (need > s->cap) {
+        if (need > MEM_SINK_CAP) {
+            s->full = true;   /* No gaps: later records are dropped too */
+            return 0;
+        }
+
+        size_t cap = s->cap ? s->cap : 64 * 1024;
+        while (cap < need) cap *= 2;
+        if (cap > MEM_SINK_CAP) cap = MEM_SINK_CAP;
+
+        uint8_t *nb = (uint8_t *)realloc(s->buf, cap);
+        if (!nb) return -1;
+        s->buf = nb;
+        s->cap = cap;
+    }
+
+    sink_header(s->buf + s->len, data, len);
+    memcpy(s->buf + s->len + 5, buf, len);
+    s->len = need;
+    return 0;
+}
+
+static void sink_close(ili9486_transport_t *t)
+{
+    sink_transport_t *s = (sink_transport_t *)t;
+
+    if (s->file) fclose(s->file);
+    free(s->buf);
+    free(s);
+}
+
+static ili9486_transport_t *sink_open(const char *path)
+{
+    sink_transport_t *s = (sink_transport_t *)calloc(1, sizeof(*s));
+    if (!s) return NULL;
+
+    s->base.write = path ? file_sink_write : mem_sink_write;
+    s->base.close = sink_close;
+    /* Same chunking as the device would use */
+    s->base.max_xfer = spidev_bufsiz();
+    win_reset(&s->base);
+
+    if (path) {
+        s->file = fopen(path, "wb");
+        if (!s->file) {
+            fprintf(stderr, "ili9486: cannot open sink %s: %s\n", path,
+                    strerror(errno));
+            free(s);
+            return NULL;
+        }
+    }
+
+    fprintf(stderr, "ili9486: %s sink, %zu-byte transfers\n",
+            path ? path : "memory", s->base.max_xfer);
+    return &s->base;
+}
+
+/* ------------------------------------------------------------------ */
+/*  Transport helpers                                                 */
+/* ------------------------------------------------------------------ */
+
+/** Send one transfer and update the counters. */
+static int xfer(ili9486_transport_t *t, bool data, const uint8_t *buf,
+                size_t len)
+{
+    t->xfer_count++;
+    t->byte_count += len;
+    return t->write(t, data, buf, len);
+}
+
+/**
+ * Send a command followed by its parameters (if any). With reg16 each
+ * byte goes out as a big-endian 16-bit word with a zero high byte.
+ */
+static int send_cmd(ili9486_transport_t *t, uint8_t cmd,
+                    const uint8_t *args, size_t nargs)
+{
+    uint8_t words[2 * ILI9486_MAX_ARGS];
+
+    if (nargs > ILI9486_MAX_ARGS)
+        return -1;
+
+    if (t->reg16) {
+        const uint8_t word[2] = { 0x00, cmd };
+        if (xfer(t, false, word, sizeof(word)) != 0)
+            return -1;
+        for (size_t i = 0; i < nargs; i++) {
+            words[2 * i] = 0x00;
+            words[2 * i + 1] = args[i];
+        }
+        args = words;
+        nargs *= 2;
+    } else if (xfer(t, false, &cmd, 1) != 0) {
+        return -1;
+    }
+
+    if (nargs && xfer(t, true, args, nargs) != 0)
+        return -1;
+    return 0;
+}
+
+/** Send CASET or RASET for the inclusive range [a, b]. */
+static int send_range(ili9486_transport_t *t, uint8_t cmd,
+                      int32_t a, int32_t b)
+{
+    uint8_t args[4] = {
+        (uint8_t)(a >> 8), (uint8_t)a, (uint8_t)(b >> 8), (uint8_t)b,
+    };
+    return send_cmd(t, cmd, args, sizeof(args));
+}
+
+/* ------------------------------------------------------------------ */
+/*  Public API                                                        */
+/* ------------------------------------------------------------------ */
+
+ili9486_transport_t *ili9486_transport_open(const char *spec,
+                                            uint32_t speed_hz)
+{
+    if (!spec || !spec[0])
+        spec = "/dev/spidev0.0";
+
+    if (strcmp(spec, "mem") == 0)
+        return sink_open(NULL);
+    if (strncmp(spec, "file:", 5) == 0)
+        return sink_open(spec + 5);
+    return spidev_open(spec, speed_hz ? speed_hz : SPI_DEFAULT_HZ);
+}
+
+const uint8_t *ili9486_mem_sink_data(ili9486_transport_t *t, size_t *len)
+{
+    if (!t || t->write != mem_sink_write)
+        return NULL;
+
+    sink_transport_t *s = (sink_transport_t *)t;
+    if (len) *len = s->len;
+    return s->buf;
+}
+
+void ili9486_mem_sink_clear(ili9486_transport_t *t)
+{
+    if (t && t->write == mem_sink_write) {
+        ((sink_transport_t *)t)->len = 0;
+        ((sink_transport_t *)t)->full = false;
+    }
+}
+
+uint8_t ili9486_madctl(int rotation, bool mirror_h, bool mirror_v)
+{
+    /* The controller's native scan is 320×480 portrait. fbtft's rotate
+     * is counter-clockwise, so our clockwise 0/90/180/270 use its
+     * rotate=90/0/270/180 values. MX/MY reverse the host column/row
+     * counters, so mirroring toggles them independently of MV. */
+    uint8_t m;
+
+    switch (rotation) {
+    case 90:  m = MADCTL_MY;                          break;
+    case 180: m = MADCTL_MV | MADCTL_MX | MADCTL_MY;  break;
+    case 270: m = MADCTL_MX;                          break;
+    default:  m = MADCTL_MV;                          break;
+    }
+
+    if (mirror_h) m ^= MADCTL_MX;
+    if (mirror_v) m ^= MADCTL_MY;
+    return m | MADCTL_BGR;
+}
+
+int ili9486_init(ili9486_transport_t *t, uint8_t madctl)
+{
+    /* Power and gamma settings as used by the fbtft ili9486 driver */
+    static const uint8_t pwr3[]  = { 0x44 };
+    static const uint8_t vcom[]  = { 0x00, 0x00, 0x00, 0x00 };
+    static const uint8_t pgam[]  = { 0x0F, 0x1F, 0x1C, 0x0C, 0x0F, 0x08,
+                                     0x48, 0x98, 0x37, 0x0A, 0x13, 0x04,
+                                     0x11, 0x0D, 0x00 };
+    static const uint8_t ngam[]  = { 0x0F, 0x32, 0x2E, 0x0B, 0x0D, 0x05,
+                                     0x47, 0x75, 0x37, 0x06, 0x10, 0x03,
+                                     0x24, 0x20, 0x00 };
+    static const uint8_t colmod[] = { 0x55 };   /* 16 bpp */
+
+    if (t->reset)
+        t->reset(t);
+
+    if (send_cmd(t, CMD_SLPOUT, NULL, 0) != 0)
+        return -1;
+    if (t->reset)
+        usleep(120000);
+
+    if (send_cmd(t, CMD_COLMOD, colmod, sizeof(colmod)) != 0 ||
+        send_cmd(t, 0xC2, pwr3, sizeof(pwr3)) != 0 ||
+        send_cmd(t, 0xC5, vcom, sizeof(vcom)) != 0 ||
+        send_cmd(t, 0xE0, pgam, sizeof(pgam)) != 0 ||
+        send_cmd(t, 0xE1, ngam, sizeof(ngam)) != 0 ||
+        send_cmd(t, CMD_MADCTL, &madctl, 1) != 0 ||
+        send_cmd(t, CMD_DISPON, NULL, 0) != 0)
+        return -1;
+
+    win_reset(t);
+
+    if (t->backlight)
+        t->backlight(t, true);
+    return 0;
+}
+
+int ili9486_write_area(ili9486_transport_t *t, int32_t x1, int32_t y1,
+                       int32_t x2, int32_t y2, uint8_t *px)
+{
+    /* Full-width strips (LVGL's usual partial flush) only move RASET */
+    if (x1 != t->win_x1 || x2 != t->win_x2) {
+        if (send_range(t, CMD_CASET, x1, x2) != 0)
+            goto fail;
+        t->win_x1 = x1;
+        t->win_x2 = x2;
+    }
+    if (y1 != t->win_y1 || y2 != t->win_y2) {
+        if (send_range(t, CMD_RASET, y1, y2) != 0)
+            goto fail;
+        t->win_y1 = y1;
+        t->win_y2 = y2;
+    }
+
+    size_t count = (size_t)(x2 - x1 + 1) * (size_t)(y2 - y1 + 1);
+    size_t len = count * 2;
+
+    /* Panel wants big-endian RGB565: swap the bytes of four pixels per
+     * 64-bit word, then bswap16 (REV16 on ARM) for the tail */
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        uint64_t v;
+        memcpy(&v, px + i * 2, sizeof(v));
+        v = ((v & 0x00FF00FF00FF00FFull) << 8) |
+            ((v >> 8) & 0x00FF00FF00FF00FFull);
+        memcpy(px + i * 2, &v, sizeof(v));
+    }
+    for (; i < count; i++) {
+        uint16_t w;
+        memcpy(&w, px + i * 2, sizeof(w));
+        w = __builtin_bswap16(w);
+        memcpy(px + i * 2, &w, sizeof(w));
+    }
+
+    if (send_cmd(t, CMD_RAMWR, NULL, 0) != 0)
+        goto fail;
+
+    for (size_t off = 0; off < len; off += t->max_xfer) {
+        size_t n = len - off < t->max_xfer ? len - off : t->max_xfer;
+        if (xfer(t, true, px + off, n) != 0)
+            goto fail;
+    }
+    return 0;
+
+fail:
+    /* Panel state is unknown — resend the window next time */
+    win_reset(t);
+    return -1;
+}
+
+int ili9486_sleep(ili9486_transport_t *t, bool sleep)
+{
+    if (sleep) {
+        if (t->backlight)
+            t->backlight(t, false);
+        if (send_cmd(t, CMD_DISPOFF, NULL, 0) != 0 ||
+            send_cmd(t, CMD_SLPIN, NULL, 0) != 0)
+            return -1;
+        return 0;
+    }
+
+    if (send_cmd(t, CMD_SLPOUT, NULL, 0) != 0)
+        return -1;
+    if (t->reset)
+        usleep(120000);   /* Required after SLPOUT on real hardware */
+    if (send_cmd(t, CMD_DISPON, NULL, 0) != 0)
+        return -1;
+    if (t->backlight)
+        t->backlight(t, true);
+    return 0;
+}
+
+void ili9486_close(ili9486_transport_t *t)
+{
+    if (t)
+        t->close(t);
+}
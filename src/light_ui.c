@@ -1,12 +1,35 @@
 /**
  * light_ui.c — Light tile grid UI for LVGL 9.x
  *
- * Renders a paginated 2×2 grid of light tiles on a 480×320 display.
- * Each tile is a ~220×130px rounded rectangle with label, icon, and
- * state-dependent colour scheme.
+ * Renders paginated pages of light tiles in the build's layout (2×2,
+ * 3×2 or 3×3 grid, or a compact list; LIGHT_UI_LAYOUT). Each tile is a
+ * rounded rectangle with label, icon, and state-dependent colour
+ * scheme. All geometry — tile rects, text boxes, spinner box, fonts and
+ * dot positions — is computed once per init into a static table from
+ * the logical screen size, so placing and painting a tile is a table
+ * lookup and no flex or grid layout ever runs.
  *
- * Horizontal swipe gestures on the screen navigate between pages by
- * animating the page container's x position. Page indicator dots are
+ * Each tile is one LVGL object with a draw callback: no child labels,
+ * no flex layout. The callback blits the tile's pre-rendered look and
+ * paints the UNKNOWN spinner or stale mark over it. Each look (icon,
+ * label, state) is painted once, by the same code on an off-screen
+ * stamp object, into a cached RGB565 buffer, so a state change is a
+ * single image blit.
+ *
+ * The grid is virtualised: only PAGE_POOL page objects with their tiles
+ * exist, bound to the current page and its neighbours and rebound as
+ * the pages move, so LVGL heap use does not grow with the number of
+ * lights. Light configuration and runtime state live in arrays sized
+ * for the configured light count.
+ *
+ * Pages sit side by side on a horizontal strip (the page container).
+ * A horizontal drag moves the strip 1:1 with the finger and settles on
+ * the nearest page when released; a swipe, recognised by the touch
+ * driver at the controller's sample rate, slides straight to the next
+ * page. Each page is cached as an RGB565 snapshot once it settles, and
+ * while the strip is moving only the two visible snapshots are drawn in
+ * place of the live widgets, so a slide costs two image blits per frame
+ * instead of re-rendering every tile. Page indicator dots are
  * updated via light_ui_update_page_dots() (weak stub until task 3.6).
  *
  * Uses ONLY LVGL 9.x APIs.
@@ -15,69 +38,119 @@
  */
 
 #include "light_ui.h"
-#include "display_driver.h"   /* DISP_HOR_RES, DISP_VER_RES */
+#include "display_driver.h"   /* DISP_HOR_RES, logical screen size */
+#include "event_loop.h"
+#include "perf_stats.h"
+#include "touch_driver.h"
+#include "ui_fonts.h"
 
+#include <stdatomic.h>
 #include <stdio.h>
 #include <stdbool.h>
 #include <stdint.h>
+#include <stdlib.h>
 #include <string.h>
 
 /* ------------------------------------------------------------------ */
 /*  Layout constants                                                  */
 /* ------------------------------------------------------------------ */
 
-#define TILE_WIDTH    220
-#define TILE_HEIGHT   130
 #define TILE_GAP       10   /* Gap between tiles                      */
 #define OUTER_PAD      10   /* Padding around the grid edges          */
+#define DOT_BAND       30   /* Below the grid, for the page dots      */
 #define TILE_RADIUS    12   /* Corner radius for rounded rectangles   */
-#define PAGE_WIDTH    DISP_HOR_RES   /* 480px per page                */
-
-/* Grid: 2 columns × 2 rows per page */
-#define GRID_COLS      2
-#define GRID_ROWS      2
+#define PAGE_WIDTH    scr_w /* One logical screen width per page      */
+#define SLIDE_MS      300   /* Page slide animation                   */
+#define DRAG_START_PX  10   /* Horizontal travel before a drag starts */
+#define STALE_MS    30000   /* UNKNOWN this long: spinner → stale mark */
+#define TILE_PAD       10   /* Inner padding of a tile                */
+#define TILE_ROW_GAP    8   /* Between icon and name                  */
+#define TILE_PAD_V      6   /* Vertical padding of a list row         */
+#define PENDING_SIZE   24   /* Spinner / stale mark box               */
+#define PENDING_BOTTOM  6   /* Its distance from the tile's bottom    */
+#define SPIN_MS      1000   /* One spinner revolution                 */
+#define SPIN_ARC      270   /* Spinner arc length (degrees)           */
+
+/* Grid per page, from the build's layout (light_ui.h) */
+#define GRID_COLS      LIGHT_UI_COLS
+#define GRID_ROWS      LIGHT_UI_ROWS
+#define LAYOUT_IS_LIST (LIGHT_UI_LAYOUT == LIGHT_UI_LAYOUT_LIST)
 
 /* ------------------------------------------------------------------ */
 /*  Colour definitions                                                */
 /* ------------------------------------------------------------------ */
 
-/* ON state: warm amber */
-#define COLOR_ON_BG        lv_color_hex(0xFFC864)
-#define COLOR_ON_TEXT      lv_color_hex(0x1A1A2E)
-#define COLOR_ON_ICON      lv_color_hex(0x1A1A2E)
+#define STATE_COUNT 3
 
-/* OFF state: dark grey */
-#define COLOR_OFF_BG       lv_color_hex(0x2A2A3E)
-#define COLOR_OFF_TEXT     lv_color_hex(0x888899)
-#define COLOR_OFF_ICON     lv_color_hex(0x555566)
+/** Tile colours, indexed by light_state_t. */
+static const struct {
+    uint32_t bg, text, icon;
+} tile_colours[STATE_COUNT] = {
+    [LIGHT_STATE_UNKNOWN] = { 0x3A3A5C, 0x7777AA, 0x6666AA }, /* blue-grey  */
+    [LIGHT_STATE_OFF]     = { 0x2A2A3E, 0x888899, 0x555566 }, /* dark grey  */
+    [LIGHT_STATE_ON]      = { 0xFFC864, 0x1A1A2E, 0x1A1A2E }, /* warm amber */
+};
 
-/* UNKNOWN state: muted blue-grey */
-#define COLOR_UNKNOWN_BG   lv_color_hex(0x3A3A5C)
-#define COLOR_UNKNOWN_TEXT lv_color_hex(0x7777AA)
-#define COLOR_UNKNOWN_ICON lv_color_hex(0x6666AA)
+/* Spinner track */
+#define COLOR_SPIN_TRACK   lv_color_hex(0x2A2A4E)
 
 /* Screen background */
 #define COLOR_SCREEN_BG    lv_color_hex(0x1A1A2E)
 
+/* Offline indicator text */
+#define COLOR_OFFLINE      lv_color_hex(0xFF6B6B)
+
 /* ------------------------------------------------------------------ */
 /*  Module-level state                                                */
 /* ------------------------------------------------------------------ */
 
-/** Per-tile LVGL objects */
+/** Pre-rendered RGB565 image of one tile look (icon, label, state). */
 typedef struct {
-    lv_obj_t *tile;       /* The tile container (rounded rect)        */
-    lv_obj_t *icon_label; /* Icon label at top of tile                */
-    lv_obj_t *name_label; /* Light name label below icon              */
-    lv_obj_t *spinner;    /* Spinner for UNKNOWN state (or NULL)      */
+    char          icon[8];
+    char          label[32];
+    int           state;     /* light_state_t, -1 = empty slot         */
+    int           refs;      /* Live tiles showing it: not evictable   */
+    uint32_t      used;      /* LRU stamp                              */
+    lv_draw_buf_t buf;
+    uint8_t      *data;      /* malloc'd, tile_bmp_size bytes          */
+} tile_bmp_t;
+
+/** What a tile shows over its look while its light is UNKNOWN. */
+enum { PENDING_NONE = 0, PENDING_SPIN, PENDING_STALE };
+
+/** A pooled tile widget, reused for whichever light the slot shows */
+typedef struct {
+    lv_obj_t *tile;       /* The tile: one object, drawn by tile_draw_cb */
+    tile_bmp_t *bmp;      /* Cache entry shown (referenced), or NULL  */
+    int       index;      /* Light shown, -1 = none (tile hidden)     */
+    int       styled;     /* State whose look is shown, or -1         */
+    uint8_t   pending;    /* PENDING_* indicator drawn over the look  */
+    bool      spinning;   /* Spinner animation running                */
+    int16_t   spin_angle; /* Spinner arc start (degrees)              */
 } tile_ui_t;
 
+/** A live page: one page object and its tiles, bound to any page. */
+typedef struct {
+    lv_obj_t *page;
+    int       page_index;   /* Page shown, -1 = unbound (hidden)       */
+    tile_ui_t tiles[LIGHT_PER_PAGE];
+} page_slot_t;
+
+#define PAGE_POOL 3         /* Current page and both neighbours        */
+
 static lv_obj_t       *light_screen = NULL;     /* Dedicated screen       */
 static lv_obj_t       *page_container = NULL;    /* Scrollable container   */
-static lv_obj_t       *pages[4] = {NULL};        /* Page objects (max 4)   */
+static page_slot_t     page_pool[PAGE_POOL];
 
-static tile_ui_t       tile_objs[LIGHT_MAX_COUNT];
-static light_runtime_t tile_runtime[LIGHT_MAX_COUNT];
-static light_config_t  tile_config[LIGHT_MAX_COUNT];
+/* One entry per configured light (light_count), heap-allocated */
+static light_runtime_t *tile_runtime = NULL;
+static light_config_t  *tile_config = NULL;
+
+/* Logical screen and tile size, set in light_ui_init */
+static int32_t         scr_w = DISP_HOR_RES;
+static int32_t         scr_h = DISP_VER_RES;
+static int32_t         tile_w = 0;
+static int32_t         tile_h = 0;
 
 static int             light_count = 0;
 static int             page_count = 0;
@@ -85,26 +158,437 @@ static int             current_page = 0;
 
 static light_toggle_cb_t toggle_cb = NULL;
 
-/** Page indicator dot objects (children of light_screen) */
-#define MAX_PAGES          4
+/** Page indicator dot objects (children of light_screen). Beyond
+ *  MAX_DOTS pages a "page / pages" label is shown instead */
+#define MAX_DOTS           8
 #define DOT_SIZE           8
 #define DOT_SPACING       16   /* Centre-to-centre distance between dots */
 #define DOT_Y_OFFSET      20   /* Distance from bottom of screen         */
 
-static lv_obj_t *dot_objs[MAX_PAGES] = {NULL};
+/** Precomputed geometry for the build's layout and the logical screen
+ *  (layout_init). Areas inside a tile are relative to its top-left. */
+static struct {
+    lv_point_t       tile_pos[LIGHT_PER_PAGE]; /* Tile on its page      */
+    lv_area_t        icon;           /* Icon line                      */
+    lv_area_t        name;           /* Name line                      */
+    lv_area_t        pending;        /* Spinner / stale mark box       */
+    lv_text_align_t  name_align;
+    const lv_font_t *icon_font;
+    const lv_font_t *name_font;
+    int32_t          dot_x[MAX_DOTS];/* For the current page_count     */
+    int32_t          dot_y;
+} layout;
+
+static lv_obj_t *dot_objs[MAX_DOTS] = {NULL};
+static lv_obj_t *page_label = NULL;
+
+/* Home Assistant unreachable (light_ui_set_offline): one indicator on
+ * the screen, and no tile spinners. Kept across destroy/init */
+static bool        ha_offline = false;
+static lv_obj_t   *offline_label = NULL;
+
+/* Fires when the next visible spinner goes stale; paused while none
+ * is visible, so an idle screen has no timer wakeups */
+static lv_timer_t *stale_timer = NULL;
+
+/** A public light_ui_* call, queued for the LVGL thread. */
+typedef enum {
+    CMD_UPDATE,           /* lights (malloc'd copy, freed when applied) */
+    CMD_SET_STATE,        /* entity_id, value = light_state_t           */
+    CMD_SET_PAGE,         /* value = page                               */
+    CMD_SET_OFFLINE,      /* value = bool                               */
+    CMD_SET_TOGGLE_CB,    /* toggle                                     */
+} ui_cmd_type_t;
+
+typedef struct {
+    ui_cmd_type_t     type;
+    int               index;
+    int               value;
+    char              entity_id[sizeof(((light_config_t *)0)->entity_id)];
+    light_config_t   *lights;
+    light_toggle_cb_t toggle;
+} ui_cmd_t;
+
+/* Bounded lock-free MPSC queue (Vyukov): any thread pushes, only
+ * light_ui_process pops. Each cell's sequence number says whose turn
+ * it is: equal to the position when free for a producer, position + 1
+ * once filled for the consumer. Sequences are stored minus the cell
+ * index so the zero-initialised array starts out valid */
+#define CMD_QUEUE_SIZE 1024   /* Power of two; a full poll of
+                                 CONFIG_MAX_LIGHTS fits with room     */
+
+typedef struct {
+    atomic_uint seq;
+    ui_cmd_t    cmd;
+} ui_cmd_cell_t;
+
+static ui_cmd_cell_t cmd_queue[CMD_QUEUE_SIZE];
+static atomic_uint   cmd_head = 0;   /* Next position to fill        */
+static unsigned      cmd_tail = 0;   /* Next position to drain (LVGL) */
+
+/* Shared styles. Every object of a kind references the same lv_style_t
+ * instead of carrying its own local properties. Initialised once, on
+ * the first light_ui_init */
+static lv_style_t style_tile;                 /* Size of a tile          */
+static lv_style_t style_page;
+static lv_style_t style_dot;
+static lv_style_t style_dot_inactive;
+static bool       styles_ready = false;
+
+/* Page strip position: x of page 0 relative to the screen */
+static int32_t    strip_x = 0;
+
+/* Finger-tracking drag of the strip */
+static bool       drag_pending = false;  /* Pressed, direction undecided */
+static bool       dragging = false;
+static bool       drag_moved = false;    /* This press dragged: no click */
+static lv_point_t drag_start;
+static int32_t    drag_base_x;           /* strip_x when the drag began  */
+
+/** Cached RGB565 image of one page. */
+typedef struct {
+    int           page;      /* Page shown, -1 = empty or stale        */
+    uint32_t      used;      /* LRU stamp                              */
+    uint32_t      gen;       /* Bumped on every re-render              */
+    lv_draw_buf_t buf;
+    uint8_t      *data;      /* malloc'd: too big for LVGL's heap      */
+} page_snap_t;
+
+#define SNAP_SLOTS 3         /* Current page and both neighbours       */
+
+static page_snap_t        snaps[SNAP_SLOTS];
+static uint32_t           snap_clock = 0;
+static bool               snap_mode = false;  /* Strip drawn from snaps */
+static lv_obj_t          *snap_img[2] = {NULL};
+static const page_snap_t *snap_shown[2] = {NULL};
+static uint32_t           snap_shown_gen[2];
+
+/* Tile image cache. Each look is rendered once from the off-screen
+ * stamp tile; a state change then only swaps the image source. The
+ * least recently used unreferenced entries go once the cache would
+ * grow past TILE_CACHE_BYTES. Slots scale with the layout: the live
+ * pages alone reference PAGE_POOL * LIGHT_PER_PAGE entries */
+#define TILE_CACHE_SLOTS (LIGHT_PER_PAGE * 10)
+#define TILE_CACHE_BYTES (2 * 1024 * 1024)
+
+static tile_bmp_t  tile_cache[TILE_CACHE_SLOTS];
+static uint32_t    tile_cache_clock = 0;
+static uint32_t    tile_cache_bytes = 0;   /* Allocated so far        */
+static uint32_t    tile_bmp_size = 0;      /* Bytes per entry         */
+
+/* Stamp: an off-screen object that paints the look being rendered
+ * over a screen-coloured background, so the RGB565 render (no alpha)
+ * has the right corners */
+static lv_obj_t             *stamp = NULL;
+static const light_config_t *stamp_cfg = NULL;
+static light_state_t         stamp_state = LIGHT_STATE_UNKNOWN;
 
 /* ------------------------------------------------------------------ */
 /*  Internal helpers                                                  */
 /* ------------------------------------------------------------------ */
 
-/* Forward declaration for gesture callback */
-static void gesture_event_cb(lv_event_t *e);
+static void tile_set_style(tile_ui_t *t, light_state_t state);
+static void tile_unref(tile_ui_t *t);
+static void tile_prefetch(void);
+static void tiles_update_pending(void);
+static void ui_set_page(int page);
+static void ui_teardown(void);
+
+/* A light_ui_set_state change is waiting for apply_pending_async */
+static bool apply_queued = false;
+
+/* ------------------------------------------------------------------ */
+/*  Page pool                                                         */
+/* ------------------------------------------------------------------ */
+
+/** Live slot bound to page, or NULL. */
+static page_slot_t *slot_find(int page)
+{
+    for (int i = 0; i < PAGE_POOL; i++) {
+        if (page_pool[i].page && page_pool[i].page_index == page)
+            return &page_pool[i];
+    }
+    return NULL;
+}
+
+/** Live tile showing light index, or NULL if its page is not bound. */
+static tile_ui_t *tile_find(int index)
+{
+    page_slot_t *slot = slot_find(index / LIGHT_PER_PAGE);
+    return slot ? &slot->tiles[index % LIGHT_PER_PAGE] : NULL;
+}
+
+/** Point a pooled tile at a light (or hide it, past the last light). */
+static void tile_bind(tile_ui_t *t, int index)
+{
+    tile_unref(t);
+    if (index >= light_count) {
+        t->index = -1;
+        lv_obj_add_flag(t->tile, LV_OBJ_FLAG_HIDDEN);
+        return;
+    }
+
+    t->index = index;
+    tile_set_style(t, tile_runtime[index].optimistic);
+    lv_obj_remove_flag(t->tile, LV_OBJ_FLAG_HIDDEN);
+}
+
+/**
+ * Make every page in [lo, hi] live, rebinding the slots whose pages lie
+ * furthest outside that window.
+ */
+static void pool_bind(int lo, int hi)
+{
+    if (lo < 0) lo = 0;
+    if (hi >= page_count) hi = page_count - 1;
+
+    for (int page = lo; page <= hi; page++) {
+        if (slot_find(page))
+            continue;
+
+        page_slot_t *slot = NULL;
+        int best = -1;
+        for (int i = 0; i < PAGE_POOL; i++) {
+            int pi = page_pool[i].page_index;
+            if (!page_pool[i].page || (pi >= lo && pi <= hi))
+                continue;
+            int dist = pi < 0 ? INT32_MAX : abs(pi - page);
+            if (dist > best) {
+                best = dist;
+                slot = &page_pool[i];
+            }
+        }
+        if (!slot)
+            break;
+
+        slot->page_index = page;
+        lv_obj_set_x(slot->page, page * PAGE_WIDTH);
+        for (int i = 0; i < LIGHT_PER_PAGE; i++)
+            tile_bind(&slot->tiles[i], page * LIGHT_PER_PAGE + i);
+        lv_obj_remove_flag(slot->page, LV_OBJ_FLAG_HIDDEN);
+    }
+
+    tiles_update_pending();
+}
+
+/* ------------------------------------------------------------------ */
+/*  Page snapshots                                                    */
+/* ------------------------------------------------------------------ */
+
+/** Slot holding an up-to-date snapshot of page, or NULL. */
+static page_snap_t *snap_find(int page)
+{
+    for (int i = 0; i < SNAP_SLOTS; i++) {
+        if (snaps[i].page == page)
+            return &snaps[i];
+    }
+    return NULL;
+}
+
+/** Drop a page's snapshot after one of its tiles changed. */
+static void snap_invalidate(int page)
+{
+    page_snap_t *s = snap_find(page);
+    if (s) s->page = -1;
+}
+
+/**
+ * Get a snapshot of page, rendering it into the least recently used
+ * slot if needed.
+ *
+ * @param keep  Page whose slot must not be reused (the other one on
+ *              screen), or -1
+ * @return Slot, or NULL if the buffer could not be allocated
+ */
+static page_snap_t *snap_get(int page, int keep)
+{
+    page_snap_t *s = snap_find(page);
+
+    if (!s) {
+        for (int i = 0; i < SNAP_SLOTS; i++) {
+            if (snaps[i].page == keep && keep >= 0)
+                continue;
+            if (!s || snaps[i].page < 0 || snaps[i].used < s->used)
+                s = &snaps[i];
+            if (s->page < 0)
+                break;
+        }
+
+        uint32_t stride = lv_draw_buf_width_to_stride((uint32_t)scr_w,
+                                                      LV_COLOR_FORMAT_RGB565);
+        uint32_t size = stride * (uint32_t)scr_h;
+        if (!s->data && !(s->data = malloc(size))) {
+            fprintf(stderr, "light_ui: no memory for page snapshot\n");
+            return NULL;
+        }
+
+        /* Render from a live page, binding one if needed */
+        int lo = keep >= 0 && keep < page ? keep : page;
+        int hi = keep > page ? keep : page;
+        pool_bind(lo, hi);
+        page_slot_t *slot = slot_find(page);
+        if (!slot)
+            return NULL;
+        lv_obj_update_layout(light_screen);
+
+        /* The image cache is keyed by descriptor, not by contents */
+        lv_image_cache_drop(&s->buf);
+        s->page = -1;
+        if (lv_draw_buf_init(&s->buf, (uint32_t)scr_w, (uint32_t)scr_h,
+                             LV_COLOR_FORMAT_RGB565, stride, s->data,
+                             size) != LV_RESULT_OK ||
+            lv_snapshot_take_to_draw_buf(slot->page, LV_COLOR_FORMAT_RGB565,
+                                         &s->buf) != LV_RESULT_OK)
+            return NULL;
+        s->page = page;
+        s->gen++;
+    }
+
+    s->used = ++snap_clock;
+    return s;
+}
+
+/** Release every snapshot buffer. */
+static void snap_free_all(void)
+{
+    for (int i = 0; i < SNAP_SLOTS; i++) {
+        if (snaps[i].data) lv_image_cache_drop(&snaps[i].buf);
+        free(snaps[i].data);
+    }
+    memset(snaps, 0, sizeof(snaps));
+    for (int i = 0; i < SNAP_SLOTS; i++)
+        snaps[i].page = -1;
+    snap_mode = false;
+}
+
+/**
+ * Place the snapshots of the (at most two) pages visible at strip_x.
+ *
+ * @return false if a snapshot could not be produced
+ */
+static bool snap_compose(void)
+{
+    int left = strip_x > 0 ? -1 : -strip_x / scr_w;
+
+    for (int k = 0; k < 2; k++) {
+        int page = left + k;
+        int32_t x = strip_x + page * scr_w;
+
+        if (page < 0 || page >= page_count || x >= scr_w) {
+            lv_obj_add_flag(snap_img[k], LV_OBJ_FLAG_HIDDEN);
+            continue;
+        }
+
+        const page_snap_t *s = snap_get(page, k ? left : left + 1);
+        if (!s) return false;
+
+        if (snap_shown[k] != s || snap_shown_gen[k] != s->gen) {
+            lv_image_set_src(snap_img[k], &s->buf);
+            snap_shown[k] = s;
+            snap_shown_gen[k] = s->gen;
+        }
+        lv_obj_set_x(snap_img[k], x);
+        lv_obj_remove_flag(snap_img[k], LV_OBJ_FLAG_HIDDEN);
+    }
+    return true;
+}
+
+/** Swap the live pages for their snapshots while the strip moves. */
+static void snap_begin(void)
+{
+    if (snap_mode || page_count < 2 || !snap_img[0]) return;
+
+    snap_mode = true;
+    if (!snap_compose()) {
+        /* Out of memory: keep animating the live widgets */
+        snap_mode = false;
+        lv_obj_add_flag(snap_img[0], LV_OBJ_FLAG_HIDDEN);
+        lv_obj_add_flag(snap_img[1], LV_OBJ_FLAG_HIDDEN);
+        return;
+    }
+    lv_obj_add_flag(page_container, LV_OBJ_FLAG_HIDDEN);
+}
+
+/** Bring the live pages back at the current strip position. */
+static void snap_end(void)
+{
+    if (!snap_mode) return;
+
+    snap_mode = false;
+    lv_obj_add_flag(snap_img[0], LV_OBJ_FLAG_HIDDEN);
+    lv_obj_add_flag(snap_img[1], LV_OBJ_FLAG_HIDDEN);
+    lv_obj_set_x(page_container, strip_x);
+    lv_obj_remove_flag(page_container, LV_OBJ_FLAG_HIDDEN);
+}
+
+/**
+ * Snapshot the settled page and its neighbours ahead of the next drag,
+ * and render the current page's other tile looks ahead of a tap.
+ */
+static void snap_prefetch(void)
+{
+    if (!page_container || snap_mode || dragging) return;
+
+    if (page_count > 1) {
+        pool_bind(current_page - 1, current_page + 1);
+        snap_get(current_page, -1);
+        if (current_page + 1 < page_count)
+            snap_get(current_page + 1, current_page);
+        if (current_page > 0)
+            snap_get(current_page - 1, current_page);
+    }
+    tile_prefetch();
+}
+
+static void snap_prefetch_async(void *arg)
+{
+    (void)arg;
+    snap_prefetch();
+}
+
+/* ------------------------------------------------------------------ */
+/*  Page strip movement                                               */
+/* ------------------------------------------------------------------ */
+
+/** Move the strip, drawing snapshots if a slide or drag is running. */
+static void strip_set_x(int32_t x)
+{
+    strip_x = x;
+    if (snap_mode && !snap_compose())
+        snap_end();
+    if (!snap_mode) {
+        int left = strip_x > 0 ? -1 : -strip_x / scr_w;
+        pool_bind(left, left + 1);
+        lv_obj_set_x(page_container, x);
+    }
+}
+
+static void strip_anim_cb(void *var, int32_t v)
+{
+    (void)var;
+    strip_set_x(v);
+}
+
+/** The strip has come to rest on current_page. */
+static void strip_settle(void)
+{
+    snap_end();
+    lv_obj_set_x(page_container, strip_x);
+    pool_bind(current_page - 1, current_page + 1);
+    snap_prefetch();
+}
+
+static void strip_anim_done(lv_anim_t *a)
+{
+    (void)a;
+    strip_settle();
+}
 
 /**
- * Animate the page container's x position to show the target page.
+ * Animate the page strip to show the target page.
  *
- * Slides the wide page_container left/right within the screen viewport
- * so that the target page is visible.
+ * Slides from wherever the strip is now (at rest, mid-drag or mid-slide)
+ * and draws page snapshots until it settles.
  *
  * @param page  Target page index (must be in [0, page_count-1])
  * @param anim  true for animated transition, false for instant
@@ -114,102 +598,719 @@ static void animate_to_page(int page, bool anim)
     if (!page_container) return;
 
     int32_t target_x = -(page * PAGE_WIDTH);
+    lv_anim_delete(page_container, strip_anim_cb);
 
-    if (!anim) {
-        lv_obj_set_pos(page_container, target_x, 0);
+    if (!anim || strip_x == target_x) {
+        strip_x = target_x;
+        strip_settle();
         return;
     }
 
-    /* Use LVGL animation to smoothly slide the container */
+    snap_begin();
+
     lv_anim_t a;
     lv_anim_init(&a);
     lv_anim_set_var(&a, page_container);
-    lv_anim_set_values(&a, lv_obj_get_x(page_container), target_x);
-    lv_anim_set_duration(&a, 300);
+    lv_anim_set_values(&a, strip_x, target_x);
+    lv_anim_set_duration(&a, SLIDE_MS);
     lv_anim_set_path_cb(&a, lv_anim_path_ease_out);
-    lv_anim_set_exec_cb(&a, (lv_anim_exec_xcb_t)lv_obj_set_x);
+    lv_anim_set_exec_cb(&a, strip_anim_cb);
+    lv_anim_set_completed_cb(&a, strip_anim_done);
     lv_anim_start(&a);
 }
 
+/** Strip position for a drag offset, with resistance past the ends. */
+static int32_t drag_clamp(int32_t x)
+{
+    int32_t min_x = -(page_count - 1) * PAGE_WIDTH;
+
+    if (x > 0) return x / 3;
+    if (x < min_x) return min_x + (x - min_x) / 3;
+    return x;
+}
+
 /**
- * Gesture event callback for horizontal swipe navigation.
+ * Press handler on the screen (tile presses bubble up to it).
  *
- * Attached to light_screen to detect left/right swipe gestures.
- * Increments or decrements current_page with clamping, then
- * animates the page container to the new position.
+ * A press that first travels DRAG_START_PX horizontally becomes a drag:
+ * the strip follows the finger 1:1 and settles on the nearest page when
+ * released. A swipe during the drag takes over via swipe_cb().
  */
-static void gesture_event_cb(lv_event_t *e)
+static void drag_event_cb(lv_event_t *e)
 {
-    (void)e;
-    lv_dir_t dir = lv_indev_get_gesture_dir(lv_indev_active());
+    lv_indev_t *indev = lv_indev_active();
+    if (!indev || page_count < 2) return;
+
+    lv_point_t p;
+    lv_indev_get_point(indev, &p);
+
+    switch (lv_event_get_code(e)) {
+    case LV_EVENT_PRESSED:
+        drag_pending = true;
+        dragging = false;
+        drag_moved = false;
+        drag_start = p;
+        break;
+
+    case LV_EVENT_PRESSING:
+        if (drag_pending) {
+            int32_t adx = abs(p.x - drag_start.x);
+            int32_t ady = abs(p.y - drag_start.y);
+            if (ady > DRAG_START_PX && ady >= adx) {
+                drag_pending = false;   /* Vertical: not a page drag */
+            } else if (adx > DRAG_START_PX) {
+                drag_pending = false;
+                dragging = true;
+                drag_moved = true;
+                drag_start = p;         /* Follow from here, no jump */
+                lv_anim_delete(page_container, strip_anim_cb);
+                drag_base_x = strip_x;
+                snap_begin();
+            }
+        }
+        if (dragging)
+            strip_set_x(drag_clamp(drag_base_x + p.x - drag_start.x));
+        break;
 
-    if (dir == LV_DIR_LEFT) {
-        /* Swipe left → go to next page */
-        if (current_page < page_count - 1) {
-            current_page++;
-            animate_to_page(current_page, true);
-            light_ui_update_page_dots();
+    case LV_EVENT_RELEASED:
+    case LV_EVENT_PRESS_LOST:
+        drag_pending = false;
+        if (dragging) {
+            dragging = false;
+            ui_set_page((-strip_x + PAGE_WIDTH / 2) / PAGE_WIDTH);
         }
-    } else if (dir == LV_DIR_RIGHT) {
-        /* Swipe right → go to previous page */
-        if (current_page > 0) {
-            current_page--;
-            animate_to_page(current_page, true);
-            light_ui_update_page_dots();
+        break;
+
+    default:
+        break;
+    }
+}
+
+/**
+ * Swipe callback for horizontal page navigation.
+ *
+ * Called by the touch driver as soon as a swipe is recognised, while
+ * the finger is still down. Slides to the neighbouring page from the
+ * current drag position, or back into place at either end.
+ */
+static void swipe_cb(lv_dir_t dir)
+{
+    if (dir != LV_DIR_LEFT && dir != LV_DIR_RIGHT) return;
+
+    drag_pending = false;
+    dragging = false;
+
+    /* Swipe left → next page, swipe right → previous page */
+    ui_set_page(dir == LV_DIR_LEFT ? current_page + 1
+                                   : current_page - 1);
+}
+
+/* ------------------------------------------------------------------ */
+/*  Layout                                                            */
+/* ------------------------------------------------------------------ */
+
+/** Tile fonts, largest first; the layout takes the largest that fits. */
+static const lv_font_t *const tile_fonts[] = {
+    UI_FONT_32, UI_FONT_24, UI_FONT_16,
+};
+#define TILE_FONTS ((int)(sizeof(tile_fonts) / sizeof(tile_fonts[0])))
+
+/** The name font that goes with tile_fonts[f] as the icon font. */
+static const lv_font_t *name_font_for(int f)
+{
+    return tile_fonts[f + 1 < TILE_FONTS ? f + 1 : f];
+}
+
+/**
+ * Fill in the layout table for the logical screen: the tile size and
+ * positions (the grid centred above the dot band), then the icon, name
+ * and spinner boxes inside a tile with the largest fonts that fit.
+ */
+static void layout_init(void)
+{
+    int32_t avail_w = scr_w - 2 * OUTER_PAD;
+    int32_t avail_h = scr_h - OUTER_PAD - DOT_BAND;
+
+    tile_w = (avail_w - (GRID_COLS - 1) * TILE_GAP) / GRID_COLS;
+    tile_h = (avail_h - (GRID_ROWS - 1) * TILE_GAP) / GRID_ROWS;
+
+    int32_t x0 = (scr_w - GRID_COLS * tile_w - (GRID_COLS - 1) * TILE_GAP) / 2;
+    for (int i = 0; i < LIGHT_PER_PAGE; i++) {
+        layout.tile_pos[i].x = x0 + (i % GRID_COLS) * (tile_w + TILE_GAP);
+        layout.tile_pos[i].y = OUTER_PAD +
+                               (i / GRID_COLS) * (tile_h + TILE_GAP);
+    }
+
+#if LAYOUT_IS_LIST
+    /* A row: icon, name, then the spinner at the right end */
+    int f = 0;
+    while (f < TILE_FONTS - 1 &&
+           lv_font_get_line_height(tile_fonts[f]) > tile_h - 2 * TILE_PAD_V)
+        f++;
+    layout.icon_font = tile_fonts[f];
+    layout.name_font = name_font_for(f);
+
+    int32_t ih = lv_font_get_line_height(layout.icon_font);
+    int32_t nh = lv_font_get_line_height(layout.name_font);
+    int32_t px = tile_w - TILE_PAD - PENDING_SIZE;
+
+    lv_area_set(&layout.icon, TILE_PAD, (tile_h - ih) / 2,
+                TILE_PAD + ih * 5 / 4 - 1, (tile_h - ih) / 2 + ih - 1);
+    lv_area_set(&layout.name, layout.icon.x2 + 1 + TILE_PAD, (tile_h - nh) / 2,
+                px - TILE_PAD - 1, (tile_h - nh) / 2 + nh - 1);
+    lv_area_set(&layout.pending, px, (tile_h - PENDING_SIZE) / 2,
+                px + PENDING_SIZE - 1,
+                (tile_h - PENDING_SIZE) / 2 + PENDING_SIZE - 1);
+    layout.name_align = LV_TEXT_ALIGN_LEFT;
+#else
+    /* A centred column: icon over name. The spinner sits in a band
+     * below it, or in the top-right corner when the tile is too short
+     * for the band with even the smallest fonts */
+    int32_t band = PENDING_SIZE + PENDING_BOTTOM;
+    bool below = true;
+    int f = TILE_FONTS;
+    for (int pass = 0; pass < 2 && f == TILE_FONTS; pass++) {
+        int32_t room = pass == 0 ? tile_h - 2 * band : tile_h - 2 * TILE_PAD_V;
+        for (f = 0; f < TILE_FONTS; f++) {
+            if (lv_font_get_line_height(tile_fonts[f]) + TILE_ROW_GAP +
+                lv_font_get_line_height(name_font_for(f)) <= room)
+                break;
         }
+        below = pass == 0;
+    }
+    if (f == TILE_FONTS) f = TILE_FONTS - 1;
+    layout.icon_font = tile_fonts[f];
+    layout.name_font = name_font_for(f);
+
+    int32_t ih = lv_font_get_line_height(layout.icon_font);
+    int32_t nh = lv_font_get_line_height(layout.name_font);
+    int32_t y = (tile_h - ih - TILE_ROW_GAP - nh) / 2;
+
+    lv_area_set(&layout.icon, TILE_PAD, y, tile_w - TILE_PAD - 1, y + ih - 1);
+    y += ih + TILE_ROW_GAP;
+    lv_area_set(&layout.name, TILE_PAD, y, tile_w - TILE_PAD - 1, y + nh - 1);
+    layout.name_align = LV_TEXT_ALIGN_CENTER;
+
+    int32_t px = below ? (tile_w - PENDING_SIZE) / 2
+                       : tile_w - PENDING_BOTTOM - PENDING_SIZE;
+    int32_t py = below ? tile_h - band : PENDING_BOTTOM;
+    lv_area_set(&layout.pending, px, py, px + PENDING_SIZE - 1,
+                py + PENDING_SIZE - 1);
+#endif
+}
+
+/** Centre the page_count dots (up to MAX_DOTS) in the dot band. */
+static void layout_dots(void)
+{
+    int n = page_count < MAX_DOTS ? page_count : MAX_DOTS;
+    int32_t total = n * DOT_SIZE + (n - 1) * (DOT_SPACING - DOT_SIZE);
+    int32_t x0 = (scr_w - total) / 2;
+
+    for (int i = 0; i < n; i++)
+        layout.dot_x[i] = x0 + i * DOT_SPACING;
+    layout.dot_y = scr_h - DOT_Y_OFFSET;
+}
+
+/* ------------------------------------------------------------------ */
+/*  Styles                                                            */
+/* ------------------------------------------------------------------ */
+
+/**
+ * Initialise the shared styles (once; objects keep pointing at them
+ * across light_ui_destroy / light_ui_init). Sizes come from the
+ * logical screen, which is fixed for the life of the process.
+ */
+static void styles_init(void)
+{
+    if (styles_ready) return;
+    styles_ready = true;
+
+    /* Tile: just its size — everything else is painted by tile_paint */
+    lv_style_init(&style_tile);
+    lv_style_set_width(&style_tile, tile_w);
+    lv_style_set_height(&style_tile, tile_h);
+
+    /* Opaque screen-coloured background, so the RGB565 snapshot (which
+     * has no alpha) looks the same as the live page */
+    lv_style_init(&style_page);
+    lv_style_set_width(&style_page, PAGE_WIDTH);
+    lv_style_set_height(&style_page, scr_h);
+    lv_style_set_bg_color(&style_page, COLOR_SCREEN_BG);
+    lv_style_set_bg_opa(&style_page, LV_OPA_COVER);
+
+    /* Circular white dots; the inactive ones at low opacity */
+    lv_style_init(&style_dot);
+    lv_style_set_width(&style_dot, DOT_SIZE);
+    lv_style_set_height(&style_dot, DOT_SIZE);
+    lv_style_set_radius(&style_dot, DOT_SIZE / 2);
+    lv_style_set_border_width(&style_dot, 0);
+    lv_style_set_pad_all(&style_dot, 0);
+    lv_style_set_bg_opa(&style_dot, LV_OPA_COVER);
+    lv_style_set_bg_color(&style_dot, lv_color_white());
+
+    lv_style_init(&style_dot_inactive);
+    lv_style_set_bg_opa(&style_dot_inactive, LV_OPA_30);
+}
+
+/* ------------------------------------------------------------------ */
+/*  Tile images                                                       */
+/* ------------------------------------------------------------------ */
+
+/** Copy text into buf (size > strlen + 3), cut with "..." to fit max_w. */
+static void fit_text(char *buf, size_t size, const char *text,
+                     const lv_font_t *font, int32_t max_w)
+{
+    snprintf(buf, size, "%s", text);
+    size_t len = strlen(buf);
+    if (lv_text_get_width(buf, (uint32_t)len, font, 0) <= max_w) return;
+
+    while (len > 0 && len + 4 <= size) {
+        /* Drop one whole UTF-8 character */
+        do {
+            len--;
+        } while (len > 0 && ((unsigned char)buf[len] & 0xC0) == 0x80);
+        memcpy(buf + len, "...", 4);
+        if (lv_text_get_width(buf, (uint32_t)len + 3, font, 0) <= max_w)
+            return;
+    }
+}
+
+/**
+ * Paint a tile look into area: rounded background, then icon and name
+ * in their layout boxes.
+ */
+static void tile_paint(lv_layer_t *layer, const lv_area_t *area,
+                       const light_config_t *cfg, light_state_t state)
+{
+    if ((unsigned)state >= STATE_COUNT)
+        state = LIGHT_STATE_UNKNOWN;
+
+    lv_draw_rect_dsc_t rect;
+    lv_draw_rect_dsc_init(&rect);
+    rect.radius = TILE_RADIUS;
+    rect.bg_color = lv_color_hex(tile_colours[state].bg);
+    rect.bg_opa = LV_OPA_COVER;
+    lv_draw_rect(layer, &rect, area);
+
+    lv_area_t line = layout.icon;
+    lv_area_move(&line, area->x1, area->y1);
+
+    lv_draw_label_dsc_t label;
+    lv_draw_label_dsc_init(&label);
+    label.align = LV_TEXT_ALIGN_CENTER;
+    label.font = layout.icon_font;
+    label.color = lv_color_hex(tile_colours[state].icon);
+    label.text = cfg->icon;
+    lv_draw_label(layer, &label, &line);
+
+    line = layout.name;
+    lv_area_move(&line, area->x1, area->y1);
+
+    char name[sizeof(cfg->label) + 4];
+    fit_text(name, sizeof(name), cfg->label, layout.name_font,
+             lv_area_get_width(&line));
+    label.align = layout.name_align;
+    label.font = layout.name_font;
+    label.color = lv_color_hex(tile_colours[state].text);
+    label.text = name;
+    label.text_local = 1;   /* Drawn after this returns: LVGL copies it */
+    lv_draw_label(layer, &label, &line);
+}
+
+/** Absolute area of a tile's spinner / stale mark. */
+static void pending_area(const tile_ui_t *t, lv_area_t *box)
+{
+    lv_area_t c;
+    lv_obj_get_coords(t->tile, &c);
+    *box = layout.pending;
+    lv_area_move(box, c.x1, c.y1);
+}
+
+/** Paint the spinner or stale mark over a tile's look. */
+static void pending_paint(lv_layer_t *layer, const tile_ui_t *t)
+{
+    lv_area_t box;
+    pending_area(t, &box);
+    lv_color_t colour = lv_color_hex(tile_colours[LIGHT_STATE_UNKNOWN].icon);
+
+    if (t->pending == PENDING_SPIN) {
+        lv_draw_arc_dsc_t arc;
+        lv_draw_arc_dsc_init(&arc);
+        arc.center.x = box.x1 + PENDING_SIZE / 2;
+        arc.center.y = box.y1 + PENDING_SIZE / 2;
+        arc.radius = PENDING_SIZE / 2;
+        arc.width = 4;
+        arc.rounded = true;
+
+        arc.color = COLOR_SPIN_TRACK;
+        arc.start_angle = 0;
+        arc.end_angle = 360;
+        lv_draw_arc(layer, &arc);
+
+        arc.color = colour;
+        arc.start_angle = t->spin_angle;
+        arc.end_angle = (t->spin_angle + SPIN_ARC) % 360;
+        lv_draw_arc(layer, &arc);
+    } else if (t->pending == PENDING_STALE) {
+        lv_draw_label_dsc_t label;
+        lv_draw_label_dsc_init(&label);
+        label.align = LV_TEXT_ALIGN_CENTER;
+        label.font = UI_FONT_16;
+        label.color = colour;
+        label.text = LV_SYMBOL_WARNING;
+        box.y1 += (PENDING_SIZE - lv_font_get_line_height(label.font)) / 2;
+        lv_draw_label(layer, &label, &box);
+    }
+}
+
+/**
+ * Draw a pooled tile: its cached look as one image blit (painted
+ * directly if the cache had no room), then the UNKNOWN indicator.
+ */
+static void tile_draw_cb(lv_event_t *e)
+{
+    const tile_ui_t *t = lv_event_get_user_data(e);
+    lv_layer_t *layer = lv_event_get_layer(e);
+    if (t->index < 0 || t->styled < 0) return;
+
+    lv_area_t area;
+    lv_obj_get_coords(t->tile, &area);
+    if (t->bmp) {
+        lv_draw_image_dsc_t img;
+        lv_draw_image_dsc_init(&img);
+        img.src = &t->bmp->buf;
+        lv_draw_image(layer, &img, &area);
+    } else {
+        tile_paint(layer, &area, &tile_config[t->index],
+                   (light_state_t)t->styled);
     }
+
+    if (t->pending != PENDING_NONE)
+        pending_paint(layer, t);
+}
+
+/** Draw the look being rendered on the screen-coloured stamp. */
+static void stamp_draw_cb(lv_event_t *e)
+{
+    lv_layer_t *layer = lv_event_get_layer(e);
+    if (!stamp_cfg) return;
+
+    lv_area_t area;
+    lv_obj_get_coords(stamp, &area);
+
+    lv_draw_rect_dsc_t rect;
+    lv_draw_rect_dsc_init(&rect);
+    rect.bg_color = COLOR_SCREEN_BG;
+    rect.bg_opa = LV_OPA_COVER;
+    lv_draw_rect(layer, &rect, &area);
+
+    tile_paint(layer, &area, stamp_cfg, stamp_state);
+}
+
+/** Create the off-screen stamp that every tile look is rendered from. */
+static void stamp_create(void)
+{
+    stamp = lv_obj_create(light_screen);
+    lv_obj_remove_style_all(stamp);
+    lv_obj_add_style(stamp, &style_tile, 0);
+    lv_obj_set_pos(stamp, -2 * tile_w, 0);
+    lv_obj_remove_flag(stamp, LV_OBJ_FLAG_SCROLLABLE);
+    lv_obj_remove_flag(stamp, LV_OBJ_FLAG_CLICKABLE);
+    lv_obj_add_event_cb(stamp, stamp_draw_cb, LV_EVENT_DRAW_MAIN, NULL);
+    stamp_cfg = NULL;
+}
+
+/** Render one tile look into a cache entry's buffer. */
+static bool stamp_render(tile_bmp_t *b, const light_config_t *cfg,
+                         light_state_t state)
+{
+    stamp_cfg = cfg;
+    stamp_state = state;
+
+    /* The image cache is keyed by descriptor, not by contents */
+    lv_image_cache_drop(&b->buf);
+    uint32_t stride = lv_draw_buf_width_to_stride((uint32_t)tile_w,
+                                                  LV_COLOR_FORMAT_RGB565);
+    bool ok = lv_draw_buf_init(&b->buf, (uint32_t)tile_w, (uint32_t)tile_h,
+                               LV_COLOR_FORMAT_RGB565, stride, b->data,
+                               tile_bmp_size) == LV_RESULT_OK &&
+              lv_snapshot_take_to_draw_buf(stamp, LV_COLOR_FORMAT_RGB565,
+                                           &b->buf) == LV_RESULT_OK;
+    stamp_cfg = NULL;
+    return ok;
 }
 
 /**
- * Apply the visual style for a given state to a tile.
+ * Get the image of a light in a state, rendering it on a miss into a
+ * free slot or the least recently used unreferenced one.
  *
- * Sets background colour, text colour, and icon colour based on
- * the light_state_t value. Shows/hides the spinner for UNKNOWN.
+ * @return Entry (not yet referenced), or NULL if it could not be
+ *         allocated or rendered
  */
-static void apply_tile_style(int index, light_state_t state)
+static tile_bmp_t *tile_bmp_get(const light_config_t *cfg,
+                                light_state_t state)
 {
-    if (index < 0 || index >= light_count) return;
+    static bool full_logged = false;
+    tile_bmp_t *b = NULL;
+
+    for (int i = 0; i < TILE_CACHE_SLOTS; i++) {
+        tile_bmp_t *e = &tile_cache[i];
+        if (e->data && e->state == (int)state &&
+            strcmp(e->icon, cfg->icon) == 0 &&
+            strcmp(e->label, cfg->label) == 0) {
+            e->used = ++tile_cache_clock;
+            return e;
+        }
+    }
 
-    tile_ui_t *t = &tile_objs[index];
-    lv_color_t bg, text_col, icon_col;
+    /* Allocate another buffer only while under the byte cap, else
+     * reuse the least recently used one. With every buffer in use and
+     * no room left, return NULL: the tile then paints itself directly */
+    tile_bmp_t *unused = NULL;
+    for (int i = 0; i < TILE_CACHE_SLOTS; i++) {
+        tile_bmp_t *e = &tile_cache[i];
+        if (e->refs > 0) continue;
+        if (!e->data) {
+            if (!unused) unused = e;
+            continue;
+        }
+        if (!b || e->state < 0 || (b->state >= 0 && e->used < b->used))
+            b = e;
+    }
+    if (unused && tile_cache_bytes + tile_bmp_size <= TILE_CACHE_BYTES)
+        b = unused;
+    if (!b) {
+        /* Once per spell: a full cache is asked again on every restyle */
+        if (!full_logged)
+            fprintf(stderr, "light_ui: tile image cache full, painting "
+                    "tiles directly\n");
+        full_logged = true;
+        return NULL;
+    }
+    full_logged = false;
 
-    switch (state) {
-    case LIGHT_STATE_ON:
-        bg       = COLOR_ON_BG;
-        text_col = COLOR_ON_TEXT;
-        icon_col = COLOR_ON_ICON;
-        break;
-    case LIGHT_STATE_OFF:
-        bg       = COLOR_OFF_BG;
-        text_col = COLOR_OFF_TEXT;
-        icon_col = COLOR_OFF_ICON;
-        break;
-    case LIGHT_STATE_UNKNOWN:
-    default:
-        bg       = COLOR_UNKNOWN_BG;
-        text_col = COLOR_UNKNOWN_TEXT;
-        icon_col = COLOR_UNKNOWN_ICON;
-        break;
+    if (!b->data) {
+        if (!(b->data = malloc(tile_bmp_size))) {
+            fprintf(stderr, "light_ui: no memory for tile image\n");
+            return NULL;
+        }
+        tile_cache_bytes += tile_bmp_size;
     }
 
-    /* Tile background */
-    lv_obj_set_style_bg_color(t->tile, bg, 0);
+    b->state = -1;
+    if (!stamp_render(b, cfg, state))
+        return NULL;
+
+    snprintf(b->icon, sizeof(b->icon), "%s", cfg->icon);
+    snprintf(b->label, sizeof(b->label), "%s", cfg->label);
+    b->state = (int)state;
+    b->used = ++tile_cache_clock;
+    return b;
+}
+
+/**
+ * Free the cache entries no live tile shows, e.g. the looks of removed
+ * or renamed lights after a config change.
+ *
+ * @param all  Free every entry (the tiles are gone)
+ */
+static void tile_cache_trim(bool all)
+{
+    for (int i = 0; i < TILE_CACHE_SLOTS; i++) {
+        tile_bmp_t *e = &tile_cache[i];
+        if (e->refs > 0 && !all) continue;
+        if (e->data) {
+            lv_image_cache_drop(&e->buf);
+            free(e->data);
+            tile_cache_bytes -= tile_bmp_size;
+        }
+        memset(e, 0, sizeof(*e));
+        e->state = -1;
+    }
+}
+
+/**
+ * Show a light's look for a given state on a tile, rendering the look
+ * first if it is not cached. Does nothing if the tile already shows
+ * that state.
+ */
+static void tile_set_style(tile_ui_t *t, light_state_t state)
+{
+    if ((unsigned)state >= STATE_COUNT)
+        state = LIGHT_STATE_UNKNOWN;
+
+    if (t->styled == (int)state && t->bmp) return;
+
+    tile_bmp_t *b = tile_bmp_get(&tile_config[t->index], state);
+    if (t->bmp) t->bmp->refs--;
+    t->bmp = b;
+    if (b) b->refs++;
+    t->styled = (int)state;
+    lv_obj_invalidate(t->tile);
+}
 
-    /* Icon colour */
-    lv_obj_set_style_text_color(t->icon_label, icon_col, 0);
+/** Release a tile's cache entry. */
+static void tile_unref(tile_ui_t *t)
+{
+    if (t->bmp) t->bmp->refs--;
+    t->bmp = NULL;
+    t->styled = -1;
+}
 
-    /* Label colour */
-    lv_obj_set_style_text_color(t->name_label, text_col, 0);
+/** Advance a tile's spinner, redrawing just the spinner's box. */
+static void spin_anim_cb(void *var, int32_t v)
+{
+    tile_ui_t *t = var;
+    lv_area_t box;
+
+    t->spin_angle = (int16_t)v;
+    pending_area(t, &box);
+    lv_obj_invalidate_area(t->tile, &box);
+}
+
+/** Render the other looks of the current page's lights ahead of taps. */
+static void tile_prefetch(void)
+{
+    int first = current_page * LIGHT_PER_PAGE;
+
+    for (int i = first; i < first + LIGHT_PER_PAGE && i < light_count; i++) {
+        for (int st = 0; st < STATE_COUNT; st++)
+            tile_bmp_get(&tile_config[i], (light_state_t)st);
+    }
+}
 
-    /* Show spinner only for UNKNOWN state */
-    if (t->spinner) {
-        if (state == LIGHT_STATE_UNKNOWN) {
-            lv_obj_remove_flag(t->spinner, LV_OBJ_FLAG_HIDDEN);
+/**
+ * Show a tile's UNKNOWN indicator: a spinner while waiting for the
+ * first answer, a static stale mark once that has taken STALE_MS or
+ * while Home Assistant is offline. The spinner only animates on the
+ * page on screen; elsewhere it stands still and costs nothing.
+ *
+ * @return true if the tile shows a spinner (animating or not)
+ */
+static bool tile_update_pending(tile_ui_t *t, bool on_screen)
+{
+    bool unknown = t->index >= 0 && t->styled == LIGHT_STATE_UNKNOWN;
+    bool stale = unknown && (ha_offline ||
+        lv_tick_elaps(tile_runtime[t->index].unknown_since_ms) >= STALE_MS);
+    bool spin = unknown && !stale;
+    bool anim = spin && on_screen;
+    uint8_t pending = stale ? PENDING_STALE
+                    : spin  ? PENDING_SPIN : PENDING_NONE;
+
+    if (pending != t->pending) {
+        lv_area_t box;
+        t->pending = pending;
+        pending_area(t, &box);
+        lv_obj_invalidate_area(t->tile, &box);
+        if (t->index >= 0)
+            snap_invalidate(t->index / LIGHT_PER_PAGE);
+    }
+
+    if (anim != t->spinning) {
+        if (anim) {
+            lv_anim_t a;
+            lv_anim_init(&a);
+            lv_anim_set_var(&a, t);
+            lv_anim_set_exec_cb(&a, spin_anim_cb);
+            lv_anim_set_values(&a, 0, 359);
+            lv_anim_set_duration(&a, SPIN_MS);
+            lv_anim_set_repeat_count(&a, LV_ANIM_REPEAT_INFINITE);
+            lv_anim_start(&a);
         } else {
-            lv_obj_add_flag(t->spinner, LV_OBJ_FLAG_HIDDEN);
+            lv_anim_delete(t, spin_anim_cb);
+        }
+        t->spinning = anim;
+    }
+    return spin;
+}
+
+/**
+ * Bring every live tile's UNKNOWN indicator up to date and arm the
+ * stale timer for the first spinner still due to go stale.
+ */
+static void tiles_update_pending(void)
+{
+    uint32_t next_ms = UINT32_MAX;
+
+    for (int p = 0; p < PAGE_POOL; p++) {
+        page_slot_t *slot = &page_pool[p];
+        if (!slot->page || slot->page_index < 0) continue;
+
+        bool on_screen = slot->page_index == current_page;
+        for (int k = 0; k < LIGHT_PER_PAGE; k++) {
+            tile_ui_t *t = &slot->tiles[k];
+            if (!tile_update_pending(t, on_screen)) continue;
+
+            uint32_t age =
+                lv_tick_elaps(tile_runtime[t->index].unknown_since_ms);
+            if (STALE_MS - age < next_ms)
+                next_ms = STALE_MS - age;
+        }
+    }
+
+    if (!stale_timer) return;
+    if (next_ms == UINT32_MAX) {
+        lv_timer_pause(stale_timer);
+    } else {
+        lv_timer_set_period(stale_timer, next_ms);
+        lv_timer_reset(stale_timer);
+        lv_timer_resume(stale_timer);
+    }
+}
+
+static void stale_timer_cb(lv_timer_t *timer)
+{
+    (void)timer;
+    tiles_update_pending();
+}
+
+/**
+ * Show a light's new state: restyle its tile if the page is live, and
+ * drop the page's snapshot either way.
+ */
+static void apply_tile_style(int index, light_state_t state)
+{
+    if (index < 0 || index >= light_count) return;
+
+    snap_invalidate(index / LIGHT_PER_PAGE);
+
+    tile_ui_t *t = tile_find(index);
+    if (t) {
+        tile_set_style(t, state);
+        tiles_update_pending();
+        perf_state_mark();
+    }
+}
+
+/**
+ * Restyle every live tile whose light's shown state changed since it
+ * was last styled. Runs once per LVGL timer pass, so all the updates
+ * from one poll land in the same frame.
+ */
+static void apply_pending_async(void *arg)
+{
+    (void)arg;
+    apply_queued = false;
+
+    bool changed = false;
+    for (int p = 0; p < PAGE_POOL; p++) {
+        for (int k = 0; k < LIGHT_PER_PAGE; k++) {
+            tile_ui_t *t = &page_pool[p].tiles[k];
+            if (!t->tile || t->index < 0 || t->index >= light_count)
+                continue;
+            light_state_t state = tile_runtime[t->index].optimistic;
+            if (t->styled != (int)state) {
+                tile_set_style(t, state);
+                changed = true;
+            }
         }
     }
+    if (changed) {
+        tiles_update_pending();
+        perf_state_mark();
+    }
 }
+
 /**
  * Click event callback for tile tap — optimistic toggle.
  *
@@ -222,9 +1323,13 @@ static void apply_tile_style(int index, light_state_t state)
  */
 static void tile_click_cb(lv_event_t *e)
 {
-    int index = (int)(intptr_t)lv_event_get_user_data(e);
+    const tile_ui_t *t = lv_event_get_user_data(e);
+    int index = t->index;
     if (index < 0 || index >= light_count) return;
 
+    /* Lifting the finger after dragging the pages is not a tap */
+    if (drag_moved) return;
+
     /* Get current displayed state */
     light_state_t current = tile_runtime[index].optimistic;
 
@@ -237,6 +1342,9 @@ static void tile_click_cb(lv_event_t *e)
     default:               next = LIGHT_STATE_ON;  break;
     }
 
+    /* Measure finger-down → toggled tile on the panel */
+    perf_input_mark(touch_driver_press_time_us());
+
     /* Optimistic update — immediate visual feedback */
     tile_runtime[index].optimistic = next;
     apply_tile_style(index, next);
@@ -247,130 +1355,92 @@ static void tile_click_cb(lv_event_t *e)
     }
 }
 
-
-
 /**
- * Create a single tile on a page at the given grid position.
+ * Create a pooled tile on a page slot at its slot's layout position. It
+ * stays hidden until tile_bind() gives it a light.
  *
  * @param parent   The page object to add the tile to
- * @param index    Global light index (0-based)
- * @param col      Column in the 2×2 grid (0 or 1)
- * @param row      Row in the 2×2 grid (0 or 1)
+ * @param t        Tile slot to fill in
+ * @param pos      Slot on the page (0 .. LIGHT_PER_PAGE - 1)
  */
-static void create_tile(lv_obj_t *parent, int index, int col, int row)
+static void create_tile(lv_obj_t *parent, tile_ui_t *t, int pos)
 {
-    tile_ui_t *t = &tile_objs[index];
-    const light_config_t *cfg = &tile_config[index];
-
-    /* Calculate tile position within the page */
-    int32_t x = OUTER_PAD + col * (TILE_WIDTH + TILE_GAP);
-    int32_t y = OUTER_PAD + row * (TILE_HEIGHT + TILE_GAP);
-
-    /* Create tile container — a styled rounded rectangle */
+    /* One bare object: no theme styles, no children, no layout —
+     * tile_draw_cb paints everything */
     t->tile = lv_obj_create(parent);
-    lv_obj_set_size(t->tile, TILE_WIDTH, TILE_HEIGHT);
-    lv_obj_set_pos(t->tile, x, y);
+    lv_obj_remove_style_all(t->tile);
+    lv_obj_add_style(t->tile, &style_tile, 0);
+    lv_obj_set_pos(t->tile, layout.tile_pos[pos].x, layout.tile_pos[pos].y);
     lv_obj_remove_flag(t->tile, LV_OBJ_FLAG_SCROLLABLE);
-
-    /* Style: rounded corners, no border */
-    lv_obj_set_style_radius(t->tile, TILE_RADIUS, 0);
-    lv_obj_set_style_bg_opa(t->tile, LV_OPA_COVER, 0);
-    lv_obj_set_style_border_width(t->tile, 0, 0);
-    lv_obj_set_style_pad_all(t->tile, 10, 0);
-
-    /* Use flex column layout for icon + label */
-    lv_obj_set_flex_flow(t->tile, LV_FLEX_FLOW_COLUMN);
-    lv_obj_set_flex_align(t->tile, LV_FLEX_ALIGN_CENTER,
-                          LV_FLEX_ALIGN_CENTER, LV_FLEX_ALIGN_CENTER);
-    lv_obj_set_style_pad_row(t->tile, 8, 0);
-
-    /* Icon label (larger font) */
-    t->icon_label = lv_label_create(t->tile);
-    lv_label_set_text(t->icon_label, cfg->icon);
-    lv_obj_set_style_text_font(t->icon_label, &lv_font_montserrat_32, 0);
-
-    /* Name label (smaller font) */
-    t->name_label = lv_label_create(t->tile);
-    lv_label_set_text(t->name_label, cfg->label);
-    lv_obj_set_style_text_font(t->name_label, &lv_font_montserrat_24, 0);
-    lv_label_set_long_mode(t->name_label, LV_LABEL_LONG_DOT);
-    lv_obj_set_width(t->name_label, TILE_WIDTH - 20);
-    lv_obj_set_style_text_align(t->name_label, LV_TEXT_ALIGN_CENTER, 0);
-
-    /* Spinner for UNKNOWN state — small, centred at bottom of tile */
-    t->spinner = lv_spinner_create(t->tile);
-    lv_obj_set_size(t->spinner, 24, 24);
-    lv_spinner_set_anim_params(t->spinner, 1000, 270);
-    lv_obj_set_style_arc_color(t->spinner, COLOR_UNKNOWN_ICON, 0);
-    lv_obj_set_style_arc_color(t->spinner, lv_color_hex(0x2A2A4E),
-                               LV_PART_MAIN);
-    /* Start hidden — apply_tile_style will show it for UNKNOWN */
-    lv_obj_add_flag(t->spinner, LV_OBJ_FLAG_HIDDEN);
-
-    /* Initialise runtime state */
-    tile_runtime[index].state = LIGHT_STATE_UNKNOWN;
-    tile_runtime[index].optimistic = LIGHT_STATE_UNKNOWN;
-    tile_runtime[index].last_updated_ms = 0;
-
-    /* Apply initial UNKNOWN style */
-    apply_tile_style(index, LIGHT_STATE_UNKNOWN);
-
-    /* Register click handler for optimistic toggle (Req 5.1, 5.2) */
+    /* Presses also reach the screen's page-drag handler */
+    lv_obj_add_flag(t->tile, LV_OBJ_FLAG_EVENT_BUBBLE);
+    lv_obj_add_event_cb(t->tile, tile_draw_cb, LV_EVENT_DRAW_MAIN, t);
+
+    t->bmp = NULL;
+    t->index = -1;
+    t->styled = -1;
+    t->pending = PENDING_NONE;
+    t->spinning = false;
+    t->spin_angle = 0;
+    lv_obj_add_flag(t->tile, LV_OBJ_FLAG_HIDDEN);
+
+    /* Register click handler for optimistic toggle (Req 5.1, 5.2).
+     * The slot, not the light, is bound: t->index says which light */
     lv_obj_add_flag(t->tile, LV_OBJ_FLAG_CLICKABLE);
-    lv_obj_add_event_cb(t->tile, tile_click_cb, LV_EVENT_CLICKED,
-                        (void *)(intptr_t)index);
+    lv_obj_add_event_cb(t->tile, tile_click_cb, LV_EVENT_CLICKED, t);
 }
 
 /**
- * Create a single page object inside the page container.
+ * Create a pooled page object inside the page container, with its
+ * LIGHT_PER_PAGE tiles.
  *
- * Each page is exactly DISP_HOR_RES wide and DISP_VER_RES tall,
- * positioned at page_index * PAGE_WIDTH horizontally.
+ * Each page is exactly one logical screen wide and tall. It stays
+ * hidden until pool_bind() positions it at page_index * PAGE_WIDTH.
  */
-static lv_obj_t *create_page(int page_index)
+static void create_page(page_slot_t *slot)
 {
+    /* No theme styles: the theme's card radius would leave corners
+     * that the RGB565 snapshot fills with black */
     lv_obj_t *page = lv_obj_create(page_container);
-    lv_obj_set_size(page, PAGE_WIDTH, DISP_VER_RES);
-    lv_obj_set_pos(page, page_index * PAGE_WIDTH, 0);
+    lv_obj_remove_style_all(page);
+    lv_obj_add_style(page, &style_page, 0);
+    lv_obj_set_pos(page, 0, 0);
+    lv_obj_add_flag(page, LV_OBJ_FLAG_HIDDEN);
     lv_obj_remove_flag(page, LV_OBJ_FLAG_SCROLLABLE);
     lv_obj_remove_flag(page, LV_OBJ_FLAG_CLICKABLE);
     lv_obj_add_flag(page, LV_OBJ_FLAG_EVENT_BUBBLE);
     lv_obj_add_flag(page, LV_OBJ_FLAG_GESTURE_BUBBLE);
 
-    /* Transparent background — screen bg shows through */
-    lv_obj_set_style_bg_opa(page, LV_OPA_TRANSP, 0);
-    lv_obj_set_style_border_width(page, 0, 0);
-    lv_obj_set_style_pad_all(page, 0, 0);
-
-    return page;
+    slot->page = page;
+    slot->page_index = -1;
+    for (int i = 0; i < LIGHT_PER_PAGE; i++)
+        create_tile(page, &slot->tiles[i], i);
 }
 
 /**
  * Create page indicator dots at the bottom of the screen.
  *
  * Dots are small circles centred horizontally. The filled/hollow
- * state is set by light_ui_update_page_dots().
+ * state is set by light_ui_update_page_dots(). With more than MAX_DOTS
+ * pages a "page / pages" label replaces them.
  */
 static void create_page_dots(void)
 {
-    /* Total width of all dots with spacing */
-    int total_width = page_count * DOT_SIZE + (page_count - 1) * (DOT_SPACING - DOT_SIZE);
-    int start_x = (DISP_HOR_RES - total_width) / 2;
-    int y = DISP_VER_RES - DOT_Y_OFFSET;
+    if (page_count > MAX_DOTS) {
+        page_label = lv_label_create(light_screen);
+        lv_obj_set_style_text_font(page_label, UI_FONT_16, 0);
+        lv_obj_set_style_text_color(page_label, lv_color_white(), 0);
+        lv_obj_align(page_label, LV_ALIGN_BOTTOM_MID, 0, -4);
+        return;
+    }
 
-    for (int i = 0; i < page_count && i < MAX_PAGES; i++) {
+    layout_dots();
+    for (int i = 0; i < page_count; i++) {
         dot_objs[i] = lv_obj_create(light_screen);
-        lv_obj_set_size(dot_objs[i], DOT_SIZE, DOT_SIZE);
-        lv_obj_set_pos(dot_objs[i], start_x + i * DOT_SPACING, y);
+        lv_obj_add_style(dot_objs[i], &style_dot, 0);
+        lv_obj_set_pos(dot_objs[i], layout.dot_x[i], layout.dot_y);
         lv_obj_remove_flag(dot_objs[i], LV_OBJ_FLAG_SCROLLABLE);
         lv_obj_remove_flag(dot_objs[i], LV_OBJ_FLAG_CLICKABLE);
-
-        /* Circular shape */
-        lv_obj_set_style_radius(dot_objs[i], DOT_SIZE / 2, 0);
-        lv_obj_set_style_border_width(dot_objs[i], 0, 0);
-        lv_obj_set_style_pad_all(dot_objs[i], 0, 0);
-        lv_obj_set_style_bg_opa(dot_objs[i], LV_OPA_COVER, 0);
-        lv_obj_set_style_bg_color(dot_objs[i], lv_color_white(), 0);
     }
 }
 
@@ -391,51 +1461,474 @@ static void show_setup_screen(void)
     lv_obj_set_style_bg_opa(light_screen, LV_OPA_COVER, 0);
     lv_obj_remove_flag(light_screen, LV_OBJ_FLAG_SCROLLABLE);
 
-    /* Centre container using flex */
-    lv_obj_set_flex_flow(light_screen, LV_FLEX_FLOW_COLUMN);
-    lv_obj_set_flex_align(light_screen, LV_FLEX_ALIGN_CENTER,
-                          LV_FLEX_ALIGN_CENTER, LV_FLEX_ALIGN_CENTER);
-    lv_obj_set_style_pad_row(light_screen, 16, 0);
+    /* A column around the title, placed from the font heights (no flex) */
+    const int32_t row_gap = 16;
+    int32_t icon_h = lv_font_get_line_height(UI_FONT_32);
+    int32_t title_h = lv_font_get_line_height(UI_FONT_24);
 
     /* Icon / emoji line */
     lv_obj_t *icon = lv_label_create(light_screen);
     lv_label_set_text(icon, LV_SYMBOL_SETTINGS);
-    lv_obj_set_style_text_font(icon, &lv_font_montserrat_32, 0);
+    lv_obj_set_style_text_font(icon, UI_FONT_32, 0);
     lv_obj_set_style_text_color(icon, lv_color_hex(0xFFC864), 0);
+    lv_obj_align(icon, LV_ALIGN_CENTER, 0,
+                 -(title_h / 2 + row_gap + icon_h / 2));
 
     /* Title */
     lv_obj_t *title = lv_label_create(light_screen);
     lv_label_set_text(title, "Setup Required");
-    lv_obj_set_style_text_font(title, &lv_font_montserrat_24, 0);
+    lv_obj_set_style_text_font(title, UI_FONT_24, 0);
     lv_obj_set_style_text_color(title, lv_color_white(), 0);
+    lv_obj_align(title, LV_ALIGN_CENTER, 0, 0);
 
     /* Instructions */
     lv_obj_t *msg = lv_label_create(light_screen);
     lv_label_set_text(msg, "Open the web config to continue:\nhttp://<this-pi>:8080");
-    lv_obj_set_style_text_font(msg, &lv_font_montserrat_16, 0);
+    lv_obj_set_style_text_font(msg, UI_FONT_16, 0);
     lv_obj_set_style_text_color(msg, lv_color_hex(0x888899), 0);
     lv_obj_set_style_text_align(msg, LV_TEXT_ALIGN_CENTER, 0);
-    lv_obj_set_width(msg, 400);
+    lv_obj_set_width(msg, scr_w - 80);
+    lv_obj_align(msg, LV_ALIGN_TOP_MID, 0, scr_h / 2 + title_h / 2 + row_gap);
 
     lv_scr_load(light_screen);
 
     fprintf(stderr, "light_ui: showing setup screen (no lights configured)\n");
 }
 
+/**
+ * Log LVGL heap usage, to compare the UI's footprint between builds.
+ * Only in LIGHT_UI_DEBUG builds (make DEBUG=1).
+ */
+static void log_heap(const char *who)
+{
+#ifdef LIGHT_UI_DEBUG
+    lv_mem_monitor_t mon;
+
+    lv_mem_monitor(&mon);
+    fprintf(stderr, "%s: LVGL heap %zu of %zu bytes used (%u%%, peak %zu, "
+            "%u%% fragmented)\n", who, mon.total_size - mon.free_size,
+            mon.total_size, mon.used_pct, mon.max_used, mon.frag_pct);
+#else
+    (void)who;
+#endif
+}
+
+/**
+ * Time a glyph lookup for every character of every tile's icon and name
+ * in its layout font, and count those only the fallback font has — to
+ * compare full, subset and compressed fonts (make fonts). Only in
+ * LIGHT_UI_DEBUG builds.
+ */
+static void log_glyph_cost(void)
+{
+#ifdef LIGHT_UI_DEBUG
+    uint64_t t0 = perf_now_us();
+    unsigned lookups = 0, fallback = 0;
+
+    for (int i = 0; i < light_count; i++) {
+        const char *text[2] = { tile_config[i].icon, tile_config[i].label };
+        const lv_font_t *font[2] = { layout.icon_font, layout.name_font };
+
+        for (int k = 0; k < 2; k++) {
+            uint32_t pos = 0, letter;
+            while ((letter = lv_text_encoded_next(text[k], &pos)) != 0) {
+                lv_font_glyph_dsc_t g;
+                if (!lv_font_get_glyph_dsc(font[k], &g, letter, 0) ||
+                    g.resolved_font != font[k])
+                    fallback++;
+                lookups++;
+            }
+        }
+    }
+
+    fprintf(stderr, "light_ui: %u glyph lookups in %llu us, %u not in "
+            "the UI fonts\n", lookups,
+            (unsigned long long)(perf_now_us() - t0), fallback);
+#endif
+}
+
+/* ------------------------------------------------------------------ */
+/*  Commands (applied on the LVGL thread)                             */
+/* ------------------------------------------------------------------ */
+
+/** Delete the screen and free everything light_ui_init set up. */
+static void ui_teardown(void)
+{
+    touch_driver_set_gesture_cb(NULL);
+
+    if (stale_timer) {
+        lv_timer_delete(stale_timer);
+        stale_timer = NULL;
+    }
+
+    /* Spinner animations point at the pooled tiles */
+    for (int p = 0; p < PAGE_POOL; p++) {
+        for (int k = 0; k < LIGHT_PER_PAGE; k++)
+            lv_anim_delete(&page_pool[p].tiles[k], spin_anim_cb);
+    }
+
+    if (light_screen) {
+        lv_obj_delete(light_screen);
+        light_screen = NULL;
+    }
+
+    page_container = NULL;
+    memset(snap_img, 0, sizeof(snap_img));
+    snap_free_all();
+    tile_cache_trim(true);
+    stamp = NULL;
+    strip_x = 0;
+    drag_pending = dragging = drag_moved = false;
+    memset(page_pool, 0, sizeof(page_pool));
+    memset(dot_objs, 0, sizeof(dot_objs));
+    page_label = NULL;
+    offline_label = NULL;
+    free(tile_runtime);
+    free(tile_config);
+    tile_runtime = NULL;
+    tile_config = NULL;
+
+    light_count = 0;
+    page_count = 0;
+    current_page = 0;
+    toggle_cb = NULL;
+}
+
+/** Whether light index looks different between two light lists. */
+static bool light_changed(int index,
+                          const light_config_t *old_cfg,
+                          const light_runtime_t *old_rt, int old_count,
+                          const light_config_t *new_cfg,
+                          const light_runtime_t *new_rt, int new_count)
+{
+    bool in_old = index < old_count, in_new = index < new_count;
+
+    if (in_old != in_new) return true;
+    if (!in_old) return false;
+    return strcmp(old_cfg[index].entity_id, new_cfg[index].entity_id) != 0 ||
+           strcmp(old_cfg[index].label, new_cfg[index].label) != 0 ||
+           strcmp(old_cfg[index].icon, new_cfg[index].icon) != 0 ||
+           old_rt[index].optimistic != new_rt[index].optimistic;
+}
+
+/**
+ * Apply a new light list (light_ui_update).
+ *
+ * Lights are matched by entity_id, so runtime state follows its entity
+ * and only the live tiles whose light changed are rebound.
+ */
+static void ui_update(const light_config_t *lights, int count)
+{
+    if (count < 0) count = 0;
+
+    /* Switching to or from the setup screen changes the whole screen */
+    if (!page_container || count == 0) {
+        light_toggle_cb_t cb = toggle_cb;
+        ui_teardown();
+        light_ui_init(lights, count);
+        toggle_cb = cb;
+        return;
+    }
+
+    light_config_t  *new_cfg = calloc((size_t)count, sizeof(*new_cfg));
+    light_runtime_t *new_rt  = calloc((size_t)count, sizeof(*new_rt));
+    if (!new_cfg || !new_rt) {
+        fprintf(stderr, "light_ui_update: out of memory, keeping old lights\n");
+        free(new_cfg);
+        free(new_rt);
+        return;
+    }
+    memcpy(new_cfg, lights, (size_t)count * sizeof(*new_cfg));
+
+    /* Carry runtime state over by entity, wherever it moved to; new
+     * lights start UNKNOWN from now */
+    int kept = 0;
+    for (int i = 0; i < count; i++) {
+        new_rt[i].unknown_since_ms = lv_tick_get();
+        for (int j = 0; j < light_count; j++) {
+            if (strcmp(new_cfg[i].entity_id, tile_config[j].entity_id) == 0) {
+                new_rt[i] = tile_runtime[j];
+                kept++;
+                break;
+            }
+        }
+    }
+
+    /* Pooled tiles and cached snapshots that now show something else */
+    bool rebind[PAGE_POOL][LIGHT_PER_PAGE] = {{false}};
+    for (int k = 0; k < PAGE_POOL; k++) {
+        int page = page_pool[k].page_index;
+        if (!page_pool[k].page || page < 0) continue;
+        for (int i = 0; i < LIGHT_PER_PAGE; i++)
+            rebind[k][i] = light_changed(page * LIGHT_PER_PAGE + i,
+                                         tile_config, tile_runtime,
+                                         light_count, new_cfg, new_rt, count);
+    }
+    for (int k = 0; k < SNAP_SLOTS; k++) {
+        int page = snaps[k].page;
+        for (int i = 0; page >= 0 && i < LIGHT_PER_PAGE; i++) {
+            if (light_changed(page * LIGHT_PER_PAGE + i, tile_config,
+                              tile_runtime, light_count, new_cfg, new_rt,
+                              count)) {
+                snaps[k].page = -1;
+                break;
+            }
+        }
+    }
+
+    int old_count = light_count, old_pages = page_count;
+    free(tile_config);
+    free(tile_runtime);
+    tile_config = new_cfg;
+    tile_runtime = new_rt;
+    light_count = count;
+    page_count = (count + LIGHT_PER_PAGE - 1) / LIGHT_PER_PAGE;
+
+    /* Stop any drag or slide; stay on the same page if it still exists */
+    lv_anim_delete(page_container, strip_anim_cb);
+    snap_end();
+    drag_pending = dragging = false;
+    if (current_page >= page_count)
+        current_page = page_count - 1;
+    strip_x = -(current_page * PAGE_WIDTH);
+
+    /* Touch only the live tiles whose light changed */
+    for (int k = 0; k < PAGE_POOL; k++) {
+        page_slot_t *slot = &page_pool[k];
+        if (!slot->page || slot->page_index < 0) continue;
+
+        if (slot->page_index >= page_count) {
+            slot->page_index = -1;
+            lv_obj_add_flag(slot->page, LV_OBJ_FLAG_HIDDEN);
+            for (int i = 0; i < LIGHT_PER_PAGE; i++) {
+                tile_ui_t *t = &slot->tiles[i];
+                tile_unref(t);
+                t->index = -1;
+                tile_update_pending(t, false);
+            }
+            continue;
+        }
+        for (int i = 0; i < LIGHT_PER_PAGE; i++) {
+            if (rebind[k][i])
+                tile_bind(&slot->tiles[i],
+                          slot->page_index * LIGHT_PER_PAGE + i);
+        }
+    }
+
+    if (page_count != old_pages) {
+        for (int p = 0; p < PAGE_POOL && p < page_count; p++) {
+            if (!page_pool[p].page)
+                create_page(&page_pool[p]);
+        }
+        lv_obj_set_width(page_container, page_count * PAGE_WIDTH);
+
+        for (int i = 0; i < MAX_DOTS; i++) {
+            if (dot_objs[i]) lv_obj_delete(dot_objs[i]);
+            dot_objs[i] = NULL;
+        }
+        if (page_label) lv_obj_delete(page_label);
+        page_label = NULL;
+        create_page_dots();
+    }
+    light_ui_update_page_dots();
+    strip_settle();
+
+    /* Looks of lights that were removed or renamed */
+    tile_cache_trim(false);
+
+    fprintf(stderr, "light_ui_update: %d lights (%d kept, %d added, "
+            "%d removed), %d pages\n", count, kept, count - kept,
+            old_count - kept, page_count);
+    log_heap("light_ui_update");
+}
+
+/**
+ * Index of the light with this entity, or -1. A poll reports the lights
+ * in list order, so the search starts just after the last match.
+ */
+static int light_find(const char *entity_id)
+{
+    static int hint = 0;
+
+    for (int n = 0; n < light_count; n++) {
+        int i = (hint + n) % light_count;
+        if (strcmp(tile_config[i].entity_id, entity_id) == 0) {
+            hint = i + 1;
+            return i;
+        }
+    }
+    return -1;
+}
+
+/** Record a light's confirmed state and restyle its tile if it changed. */
+static void ui_set_state(int index, light_state_t state)
+{
+    if (index < 0 || index >= light_count) return;
+
+    light_state_t shown = tile_runtime[index].optimistic;
+    tile_runtime[index].state = state;
+    tile_runtime[index].optimistic = state;
+    tile_runtime[index].last_updated_ms = lv_tick_get();
+    if (state == LIGHT_STATE_UNKNOWN && shown != LIGHT_STATE_UNKNOWN)
+        tile_runtime[index].unknown_since_ms = lv_tick_get();
+
+    /* Steady-state polls end here without touching any object */
+    if (shown == state) return;
+
+    /* Restyling waits for one pass over all changes of this poll */
+    snap_invalidate(index / LIGHT_PER_PAGE);
+    if (!apply_queued)
+        apply_queued = lv_async_call(apply_pending_async, NULL) ==
+                       LV_RESULT_OK;
+}
+
+/** Show or hide the offline indicator (light_ui_set_offline). */
+static void ui_set_offline(bool offline)
+{
+    if (offline == ha_offline) return;
+    ha_offline = offline;
+
+    fprintf(stderr, "light_ui: Home Assistant %s\n",
+            offline ? "unreachable" : "reachable again");
+
+    if (offline_label) {
+        if (offline)
+            lv_obj_remove_flag(offline_label, LV_OBJ_FLAG_HIDDEN);
+        else
+            lv_obj_add_flag(offline_label, LV_OBJ_FLAG_HIDDEN);
+    }
+    tiles_update_pending();
+}
+
+/** Slide to a page, clamped to the valid range. */
+static void ui_set_page(int page)
+{
+    /* Clamp to valid range */
+    if (page < 0) page = 0;
+    if (page >= page_count) page = page_count - 1;
+
+    current_page = page;
+    animate_to_page(current_page, true);
+    light_ui_update_page_dots();
+}
+
+/* ------------------------------------------------------------------ */
+/*  Command queue                                                     */
+/* ------------------------------------------------------------------ */
+
+/**
+ * Queue a command for the LVGL thread and wake the main loop. Safe
+ * from any thread.
+ *
+ * @return false if the queue is full (the command is dropped)
+ */
+static bool cmd_push(const ui_cmd_t *cmd)
+{
+    unsigned pos = atomic_load_explicit(&cmd_head, memory_order_relaxed);
+    ui_cmd_cell_t *cell;
+
+    for (;;) {
+        unsigned i = pos & (CMD_QUEUE_SIZE - 1);
+        cell = &cmd_queue[i];
+        unsigned seq = atomic_load_explicit(&cell->seq,
+                                            memory_order_acquire) + i;
+        int diff = (int)(seq - pos);
+
+        if (diff == 0) {
+            /* Free cell: claim the position (pos is reloaded on failure) */
+            if (atomic_compare_exchange_weak_explicit(&cmd_head, &pos,
+                                                      pos + 1,
+                                                      memory_order_relaxed,
+                                                      memory_order_relaxed))
+                break;
+        } else if (diff < 0) {
+            /* Not yet drained since the last lap: full */
+            fprintf(stderr, "light_ui: command queue full, dropping\n");
+            return false;
+        } else {
+            /* Another producer took it first */
+            pos = atomic_load_explicit(&cmd_head, memory_order_relaxed);
+        }
+    }
+
+    cell->cmd = *cmd;
+    atomic_store_explicit(&cell->seq,
+                          pos + 1 - (pos & (CMD_QUEUE_SIZE - 1)),
+                          memory_order_release);
+    event_loop_wake();
+    return true;
+}
+
+/** Take the oldest command (LVGL thread only). */
+static bool cmd_pop(ui_cmd_t *out)
+{
+    unsigned i = cmd_tail & (CMD_QUEUE_SIZE - 1);
+    ui_cmd_cell_t *cell = &cmd_queue[i];
+    unsigned seq = atomic_load_explicit(&cell->seq,
+                                        memory_order_acquire) + i;
+
+    if (seq != cmd_tail + 1)
+        return false;
+
+    *out = cell->cmd;
+    /* Hand the cell to the producer one lap ahead */
+    atomic_store_explicit(&cell->seq, cmd_tail + CMD_QUEUE_SIZE - i,
+                          memory_order_release);
+    cmd_tail++;
+    return true;
+}
+
+/** Carry out one command. */
+static void cmd_apply(const ui_cmd_t *cmd)
+{
+    switch (cmd->type) {
+    case CMD_UPDATE:
+        ui_update(cmd->lights, cmd->index);
+        free(cmd->lights);
+        break;
+    case CMD_SET_STATE:
+        ui_set_state(light_find(cmd->entity_id), (light_state_t)cmd->value);
+        break;
+    case CMD_SET_PAGE:
+        if (page_container)
+            ui_set_page(cmd->value);
+        break;
+    case CMD_SET_OFFLINE:
+        ui_set_offline(cmd->value != 0);
+        break;
+    case CMD_SET_TOGGLE_CB:
+        toggle_cb = cmd->toggle;
+        break;
+    }
+}
+
 /* ------------------------------------------------------------------ */
 /*  Public API                                                        */
 /* ------------------------------------------------------------------ */
 
 void light_ui_init(const light_config_t *lights, int count)
 {
-    /* Clamp count to maximum */
-    if (count > LIGHT_MAX_COUNT) count = LIGHT_MAX_COUNT;
+    uint64_t t0 = perf_now_us();
+
     if (count < 0) count = 0;
 
+    /* Lay the build's layout out on the logical screen */
+    scr_w  = display_driver_get_hor_res();
+    scr_h  = display_driver_get_ver_res();
+    layout_init();
+    styles_init();
+    tile_cache_trim(true);
+    tile_bmp_size = lv_draw_buf_width_to_stride((uint32_t)tile_w,
+                                                LV_COLOR_FORMAT_RGB565) *
+                    (uint32_t)tile_h;
+
     light_count = count;
     page_count = (count + LIGHT_PER_PAGE - 1) / LIGHT_PER_PAGE;
     if (page_count == 0) page_count = 1;  /* At least one page */
     current_page = 0;
+    strip_x = 0;
+    drag_pending = dragging = drag_moved = false;
+    snap_free_all();
 
     /* If no lights configured, show the setup prompt instead */
     if (count == 0) {
@@ -443,15 +1936,28 @@ void light_ui_init(const light_config_t *lights, int count)
         return;
     }
 
-    /* Copy configuration */
-    memset(tile_config, 0, sizeof(tile_config));
-    if (lights && count > 0) {
-        memcpy(tile_config, lights, (size_t)count * sizeof(light_config_t));
+    /* Copy configuration; every light starts UNKNOWN (all zero) */
+    free(tile_config);
+    free(tile_runtime);
+    tile_config = calloc((size_t)count, sizeof(light_config_t));
+    tile_runtime = calloc((size_t)count, sizeof(light_runtime_t));
+    if (!tile_config || !tile_runtime) {
+        fprintf(stderr, "light_ui_init: out of memory for %d lights\n", count);
+        free(tile_config);
+        free(tile_runtime);
+        tile_config = NULL;
+        tile_runtime = NULL;
+        light_count = 0;
+        show_setup_screen();
+        return;
     }
+    if (lights)
+        memcpy(tile_config, lights, (size_t)count * sizeof(light_config_t));
+    for (int i = 0; i < count; i++)
+        tile_runtime[i].unknown_since_ms = lv_tick_get();
 
-    /* Reset tile objects */
-    memset(tile_objs, 0, sizeof(tile_objs));
-    memset(tile_runtime, 0, sizeof(tile_runtime));
+    /* Reset the page pool */
+    memset(page_pool, 0, sizeof(page_pool));
 
     /* Create a dedicated screen */
     light_screen = lv_obj_create(NULL);
@@ -462,7 +1968,7 @@ void light_ui_init(const light_config_t *lights, int count)
      * side by side. Scrolling is disabled by default; swipe navigation
      * (task 3.5) will control scroll position programmatically. */
     page_container = lv_obj_create(light_screen);
-    lv_obj_set_size(page_container, page_count * PAGE_WIDTH, DISP_VER_RES);
+    lv_obj_set_size(page_container, page_count * PAGE_WIDTH, scr_h);
     lv_obj_set_pos(page_container, 0, 0);
     lv_obj_remove_flag(page_container, LV_OBJ_FLAG_SCROLLABLE);
     lv_obj_remove_flag(page_container, LV_OBJ_FLAG_CLICKABLE);
@@ -474,74 +1980,132 @@ void light_ui_init(const light_config_t *lights, int count)
     lv_obj_set_style_border_width(page_container, 0, 0);
     lv_obj_set_style_pad_all(page_container, 0, 0);
 
-    /* Create pages and tiles */
-    for (int p = 0; p < page_count; p++) {
-        pages[p] = create_page(p);
+    /* Off-screen tile the tile images are rendered from */
+    stamp_create();
 
-        /* Create tiles for this page */
-        for (int slot = 0; slot < LIGHT_PER_PAGE; slot++) {
-            int index = p * LIGHT_PER_PAGE + slot;
-            if (index >= light_count) break;
+    /* Armed by tiles_update_pending while a spinner is visible */
+    if (!stale_timer) {
+        stale_timer = lv_timer_create(stale_timer_cb, STALE_MS, NULL);
+        lv_timer_pause(stale_timer);
+    }
 
-            int col = slot % GRID_COLS;
-            int row = slot / GRID_COLS;
-            create_tile(pages[p], index, col, row);
-        }
+    /* Create the pooled pages and tiles (no more than there are pages)
+     * and bind them to the first pages */
+    for (int p = 0; p < PAGE_POOL && p < page_count; p++)
+        create_page(&page_pool[p]);
+    pool_bind(0, 1);
+
+    /* Snapshot images that stand in for the pages while the strip
+     * moves — above the pages, below the dots */
+    for (int k = 0; k < 2; k++) {
+        snap_img[k] = lv_image_create(light_screen);
+        lv_obj_set_pos(snap_img[k], 0, 0);
+        lv_obj_add_flag(snap_img[k], LV_OBJ_FLAG_HIDDEN);
+        snap_shown[k] = NULL;
     }
 
     /* Load the light screen */
     lv_scr_load(light_screen);
 
-    /* Register gesture handler on the screen for swipe navigation.
-     * We attach to light_screen (the viewport) rather than page_container
-     * because the container is wider than the screen. */
-    lv_obj_add_event_cb(light_screen, gesture_event_cb,
-                        LV_EVENT_GESTURE, NULL);
-    /* Clear the gesture on the screen so LVGL doesn't also try to scroll */
+    /* Finger-tracking page drag; tile presses bubble up to the screen */
+    lv_obj_add_event_cb(light_screen, drag_event_cb, LV_EVENT_PRESSED, NULL);
+    lv_obj_add_event_cb(light_screen, drag_event_cb, LV_EVENT_PRESSING, NULL);
+    lv_obj_add_event_cb(light_screen, drag_event_cb, LV_EVENT_RELEASED, NULL);
+    lv_obj_add_event_cb(light_screen, drag_event_cb, LV_EVENT_PRESS_LOST,
+                        NULL);
+
+    /* Swipe navigation. The touch driver recognises swipes from every
+     * sample instead of LVGL's LV_EVENT_GESTURE, which only sees the
+     * positions read once per frame */
+    touch_driver_set_gesture_cb(swipe_cb);
+    /* Keep LVGL from also trying to scroll the screen */
     lv_obj_remove_flag(light_screen, LV_OBJ_FLAG_SCROLLABLE);
 
     /* Create page indicator dots and set initial state */
     create_page_dots();
     light_ui_update_page_dots();
 
-    fprintf(stderr, "light_ui_init: %d lights, %d pages\n",
-            light_count, page_count);
+    /* Offline indicator, bottom left below the grid */
+    offline_label = lv_label_create(light_screen);
+    lv_label_set_text(offline_label, LV_SYMBOL_WARNING " Offline");
+    lv_obj_set_style_text_font(offline_label, UI_FONT_16, 0);
+    lv_obj_set_style_text_color(offline_label, COLOR_OFFLINE, 0);
+    lv_obj_align(offline_label, LV_ALIGN_BOTTOM_LEFT, OUTER_PAD, -4);
+    if (!ha_offline)
+        lv_obj_add_flag(offline_label, LV_OBJ_FLAG_HIDDEN);
+
+    /* Cache the first pages once the screen is up */
+    lv_async_call(snap_prefetch_async, NULL);
+
+    fprintf(stderr, "light_ui_init: %d lights, %d pages in %llu us\n",
+            light_count, page_count,
+            (unsigned long long)(perf_now_us() - t0));
+    log_heap("light_ui_init");
+    log_glyph_cost();
 }
 
-void light_ui_set_state(int index, light_state_t state)
+void light_ui_update(const light_config_t *lights, int count)
 {
-    if (index < 0 || index >= light_count) return;
+    ui_cmd_t cmd = { .type = CMD_UPDATE, .index = count < 0 ? 0 : count };
+
+    if (cmd.index > 0) {
+        size_t size = (size_t)cmd.index * sizeof(light_config_t);
+        if (!lights || !(cmd.lights = malloc(size))) {
+            fprintf(stderr, "light_ui_update: out of memory, "
+                    "keeping old lights\n");
+            return;
+        }
+        memcpy(cmd.lights, lights, size);
+    }
+    if (!cmd_push(&cmd))
+        free(cmd.lights);
+}
 
-    tile_runtime[index].state = state;
-    tile_runtime[index].optimistic = state;
-    tile_runtime[index].last_updated_ms = lv_tick_get();
+void light_ui_set_state(const char *entity_id, light_state_t state)
+{
+    ui_cmd_t cmd = { .type = CMD_SET_STATE, .value = (int)state };
 
-    apply_tile_style(index, state);
+    if (!entity_id) return;
+    snprintf(cmd.entity_id, sizeof(cmd.entity_id), "%s", entity_id);
+    cmd_push(&cmd);
+}
+
+void light_ui_set_offline(bool offline)
+{
+    ui_cmd_t cmd = { .type = CMD_SET_OFFLINE, .value = offline };
+    cmd_push(&cmd);
 }
 
 void light_ui_set_toggle_cb(light_toggle_cb_t cb)
 {
-    toggle_cb = cb;
+    ui_cmd_t cmd = { .type = CMD_SET_TOGGLE_CB, .toggle = cb };
+    cmd_push(&cmd);
 }
 
-void light_ui_destroy(void)
+void light_ui_set_page(int page)
 {
-    if (light_screen) {
-        lv_obj_delete(light_screen);
-        light_screen = NULL;
-    }
+    ui_cmd_t cmd = { .type = CMD_SET_PAGE, .value = page };
+    cmd_push(&cmd);
+}
 
-    page_container = NULL;
-    memset(pages, 0, sizeof(pages));
-    memset(dot_objs, 0, sizeof(dot_objs));
-    memset(tile_objs, 0, sizeof(tile_objs));
-    memset(tile_runtime, 0, sizeof(tile_runtime));
-    memset(tile_config, 0, sizeof(tile_config));
+void light_ui_process(void)
+{
+    ui_cmd_t cmd;
 
-    light_count = 0;
-    page_count = 0;
-    current_page = 0;
-    toggle_cb = NULL;
+    while (cmd_pop(&cmd))
+        cmd_apply(&cmd);
+}
+
+void light_ui_destroy(void)
+{
+    ui_cmd_t cmd;
+
+    /* Nothing will apply what is still queued */
+    while (cmd_pop(&cmd)) {
+        if (cmd.type == CMD_UPDATE)
+            free(cmd.lights);
+    }
+    ui_teardown();
 }
 
 int light_ui_get_page_count(void)
@@ -563,7 +2127,9 @@ const light_runtime_t *light_ui_get_runtime(int index)
 lv_obj_t *light_ui_get_tile_obj(int index)
 {
     if (index < 0 || index >= light_count) return NULL;
-    return tile_objs[index].tile;
+
+    tile_ui_t *t = tile_find(index);
+    return t ? t->tile : NULL;
 }
 
 lv_obj_t *light_ui_get_container(void)
@@ -571,17 +2137,6 @@ lv_obj_t *light_ui_get_container(void)
     return page_container;
 }
 
-void light_ui_set_page(int page)
-{
-    /* Clamp to valid range */
-    if (page < 0) page = 0;
-    if (page >= page_count) page = page_count - 1;
-
-    current_page = page;
-    animate_to_page(current_page, true);
-    light_ui_update_page_dots();
-}
-
 /**
  * Update page indicator dots to reflect the current page.
  *
@@ -590,15 +2145,19 @@ void light_ui_set_page(int page)
  */
 void light_ui_update_page_dots(void)
 {
-    for (int i = 0; i < page_count && i < MAX_PAGES; i++) {
+    if (page_label) {
+        lv_label_set_text_fmt(page_label, "%d / %d", current_page + 1,
+                              page_count);
+        return;
+    }
+
+    for (int i = 0; i < page_count && i < MAX_DOTS; i++) {
         if (!dot_objs[i]) continue;
 
-        if (i == current_page) {
-            /* Filled dot — full opacity white */
-            lv_obj_set_style_bg_opa(dot_objs[i], LV_OPA_COVER, 0);
-        } else {
-            /* Hollow dot — low opacity */
-            lv_obj_set_style_bg_opa(dot_objs[i], LV_OPA_30, 0);
-        }
+        /* Filled dot for the current page, hollow (low opacity) for
+         * the others */
+        lv_obj_remove_style(dot_objs[i], &style_dot_inactive, 0);
+        if (i != current_page)
+            lv_obj_add_style(dot_objs[i], &style_dot_inactive, 0);
     }
 }
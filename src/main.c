@@ -2,10 +2,26 @@
  * main.c — Application entry point for HA Light Control
  *
  * Initialises LVGL, display/touch drivers, loads config, starts the
- * HA client and web config server, then runs the LVGL main loop at
- * ~30 fps with periodic HA state polling every 5 seconds.
+ * HA client and web config server, then runs the LVGL main loop with
+ * periodic HA state polling every 5 seconds.
  *
- * Handles SIGINT/SIGTERM for clean shutdown.
+ * The loop sleeps in event_loop_wait() until LVGL's next timer deadline
+ * or until woken by touch input, the config server or a signal. It runs
+ * at ~30 fps only while LVGL has something to render or animate, or
+ * while a finger is down.
+ *
+ * Handles SIGINT/SIGTERM for clean shutdown, and SIGUSR1 to dump the
+ * perf_stats counters to stderr.
+ *
+ * Usage: ha_lights [options] [config_path]
+ *   --record-touch FILE   also record the touchscreen's events to FILE
+ *   --replay-touch FILE   replay FILE instead of reading a touchscreen
+ *   --replay-speed N      replay N times faster (default 1)
+ *   --headless            render to the in-memory SPI sink, no panel
+ *   --calibrate           run the 3-point touch calibration and save it
+ *
+ * --headless with --replay-touch gives a repeatable UI workload for
+ * benchmarking on any machine; read the results with SIGUSR1.
  *
  * Requirements: 12.1, 12.2, 12.3, 6.1
  */
@@ -15,14 +31,17 @@
 #include <stdlib.h>
 #include <string.h>
 #include <time.h>
-#include <unistd.h>
 
 #include "lvgl.h"
 #include "config.h"
 #include "config_server.h"
 #include "display_driver.h"
+#include "event_loop.h"
 #include "ha_client.h"
 #include "light_ui.h"
+#include "perf_stats.h"
+#include "power_manager.h"
+#include "touch_calibrate.h"
 #include "touch_driver.h"
 
 /* ------------------------------------------------------------------ */
@@ -32,20 +51,22 @@
 #define DEFAULT_CONFIG_PATH  "/etc/ha_lights.conf"
 #define WEB_SERVER_PORT      8080
 #define POLL_INTERVAL_MS     5000   /* 5 seconds */
-#define FRAME_PERIOD_MS      33     /* ~30 fps   */
+#define FRAME_PERIOD_MS      33     /* ~30 fps, cap while touched */
 
 /* ------------------------------------------------------------------ */
 /*  Globals                                                           */
 /* ------------------------------------------------------------------ */
 
 static volatile sig_atomic_t g_shutdown = 0;
+static volatile sig_atomic_t g_perf_dump = 0;
 static config_t              g_config;
+static const char           *g_config_path;
 
 /* ------------------------------------------------------------------ */
 /*  Helpers                                                           */
 /* ------------------------------------------------------------------ */
 
-/** Monotonic millisecond clock for LVGL tick and frame pacing. */
+/** Monotonic millisecond clock for the LVGL tick. */
 static uint32_t get_tick_ms(void)
 {
     struct timespec ts;
@@ -58,20 +79,65 @@ static void signal_handler(int sig)
 {
     (void)sig;
     g_shutdown = 1;
+    event_loop_wake();
 }
 
-/** Toggle callback wired to Light_UI tile taps. */
-static void on_light_toggle(const char *entity_id, light_state_t current_state)
+/** SIGUSR1 handler — requests a perf_stats dump from the main loop. */
+static void perf_signal_handler(int sig)
 {
-    (void)current_state;
-    ha_toggle_light(entity_id);
+    (void)sig;
+    g_perf_dump = 1;
+    event_loop_wake();
+}
+
+/** Print command-line usage to stderr. */
+static void usage(const char *prog)
+{
+    fprintf(stderr, "usage: %s [--record-touch FILE] [--replay-touch FILE] "
+            "[--replay-speed N] [--headless] [--calibrate] [config_path]\n",
+            prog);
+}
+
+/** Calibration finished — persist the matrix in the config file. */
+static void on_calibrated(const int32_t calib[6], const char *device)
+{
+    memcpy(g_config.touch.calib, calib, sizeof(g_config.touch.calib));
+    g_config.touch.calibrated = true;
+    snprintf(g_config.touch.device, sizeof(g_config.touch.device), "%s",
+             device);
+
+    /* Patch the file as it is now: the web UI may have saved other
+     * settings since g_config was loaded. config_t is large
+     * (CONFIG_MAX_LIGHTS lights): keep it off the stack. Failing that,
+     * save g_config, which already holds the new matrix */
+    config_t *cfg = malloc(sizeof(*cfg));
+    const config_t *out = &g_config;
+
+    config_lock();
+    if (cfg && config_load(g_config_path, cfg) == 0) {
+        memcpy(cfg->touch.calib, calib, sizeof(cfg->touch.calib));
+        cfg->touch.calibrated = true;
+        memcpy(cfg->touch.device, g_config.touch.device,
+               sizeof(cfg->touch.device));
+        out = cfg;
+    }
+    int saved = config_save(g_config_path, out);
+    config_unlock();
+    free(cfg);
+
+    if (saved != 0)
+        fprintf(stderr, "main: failed to save touch calibration\n");
+    else
+        fprintf(stderr, "main: touch calibration saved to %s\n",
+                g_config_path);
 }
 
-/** lv_timer callback for periodic HA state polling. */
-static void poll_timer_cb(lv_timer_t *timer)
+/** Toggle callback wired to Light_UI tile taps. Only queues the
+ *  request: the HA client's thread sends it. */
+static void on_light_toggle(const char *entity_id, light_state_t current_state)
 {
-    (void)timer;
-    ha_poll_all(g_config.lights, g_config.light_count);
+    (void)current_state;
+    ha_toggle_light(entity_id);
 }
 
 /* ------------------------------------------------------------------ */
@@ -81,10 +147,35 @@ static void poll_timer_cb(lv_timer_t *timer)
 int main(int argc, char *argv[])
 {
     const char *config_path = DEFAULT_CONFIG_PATH;
+    touch_options_t touch_opts = { NULL, NULL, 1.0 };
+    bool headless = false;
+    bool calibrate = false;
 
-    /* Allow overriding config path via CLI argument */
-    if (argc > 1)
-        config_path = argv[1];
+    /* Options, then an optional config path */
+    for (int i = 1; i < argc; i++) {
+        bool has_val = i + 1 < argc;
+
+        if (strcmp(argv[i], "--record-touch") == 0 && has_val) {
+            touch_opts.record_path = argv[++i];
+        } else if (strcmp(argv[i], "--replay-touch") == 0 && has_val) {
+            touch_opts.replay_path = argv[++i];
+        } else if (strcmp(argv[i], "--replay-speed") == 0 && has_val) {
+            touch_opts.replay_speed = atof(argv[++i]);
+        } else if (strcmp(argv[i], "--headless") == 0) {
+            headless = true;
+        } else if (strcmp(argv[i], "--calibrate") == 0) {
+            calibrate = true;
+        } else if (argv[i][0] == '-') {
+            usage(argv[0]);
+            return EXIT_FAILURE;
+        } else {
+            config_path = argv[i];
+        }
+    }
+
+    /* --- Main loop wakeups (before signals and the touch thread) -- */
+    if (event_loop_init() != 0)
+        return EXIT_FAILURE;
 
     /* --- Signal handling ------------------------------------------ */
     struct sigaction sa;
@@ -93,6 +184,17 @@ int main(int argc, char *argv[])
     sigemptyset(&sa.sa_mask);
     sigaction(SIGINT,  &sa, NULL);
     sigaction(SIGTERM, &sa, NULL);
+    sa.sa_handler = perf_signal_handler;
+    sigaction(SIGUSR1, &sa, NULL);
+
+    /* --- Configuration -------------------------------------------- */
+    /* Loaded first: the display driver needs the orientation settings */
+    if (config_load(config_path, &g_config) != 0) {
+        fprintf(stderr, "main: config_load failed for %s\n", config_path);
+        return EXIT_FAILURE;
+    }
+    config_set_path(config_path);
+    g_config_path = config_path;
 
     /* --- LVGL init ------------------------------------------------ */
     lv_init();
@@ -102,49 +204,48 @@ int main(int argc, char *argv[])
     lv_tick_set_cb(get_tick_ms);
 
     /* --- Hardware drivers ----------------------------------------- */
-    if (display_driver_init() != 0) {
+    /* Headless: same rendering path, pixels go to a memory sink. A copy,
+     * so a web UI save never writes the override into the config file */
+    display_config_t disp_cfg = g_config.display;
+    if (headless) {
+        disp_cfg.backend = DISPLAY_BACKEND_SPI;
+        snprintf(disp_cfg.spi_device, sizeof(disp_cfg.spi_device), "mem");
+        disp_cfg.hdmi_fb[0] = '\0';
+    }
+
+    if (display_driver_init(&disp_cfg) != 0) {
         fprintf(stderr, "main: display_driver_init failed\n");
         return EXIT_FAILURE;
     }
-    if (touch_driver_init() != 0) {
+    if (touch_driver_init(&touch_opts, &g_config.touch) != 0) {
         fprintf(stderr, "main: touch_driver_init failed\n");
         display_driver_deinit();
         return EXIT_FAILURE;
     }
 
-    /* --- Configuration -------------------------------------------- */
-    if (config_load(config_path, &g_config) != 0) {
-        fprintf(stderr, "main: config_load failed for %s\n", config_path);
-        touch_driver_deinit();
-        display_driver_deinit();
-        return EXIT_FAILURE;
-    }
-    config_set_path(config_path);
+    /* --- Idle blanking -------------------------------------------- */
+    power_manager_init((uint32_t)g_config.screen_timeout);
 
     /* --- Light UI ------------------------------------------------- */
     light_ui_init(g_config.lights, g_config.light_count);
     light_ui_set_toggle_cb(on_light_toggle);
 
+    /* Calibration overlay sits on the top layer, above the tiles */
+    if (calibrate)
+        touch_calibrate_start(on_calibrated);
+
     /* --- HA client ------------------------------------------------ */
-    int ha_ok = 0;
     if (g_config.ha.base_url[0] != '\0' && g_config.ha.token[0] != '\0') {
-        if (ha_client_init(g_config.ha.base_url, g_config.ha.token) == 0) {
-            ha_ok = 1;
-            /* Initial state fetch */
-            ha_poll_all(g_config.lights, g_config.light_count);
-        } else {
-            fprintf(stderr, "main: ha_client_init failed (non-fatal)\n");
-        }
+        /* Polls on its own thread: first at once, then every 5 s */
+        if (ha_client_init(g_config.ha.base_url, g_config.ha.token) != 0 ||
+            ha_poll_start(g_config.lights, g_config.light_count,
+                          POLL_INTERVAL_MS) != 0)
+            fprintf(stderr, "main: HA client failed to start (non-fatal)\n");
     } else {
         fprintf(stderr, "main: HA credentials not configured — "
                 "UI will show, use web config at :8080 to set up\n");
     }
 
-    /* Periodic polling timer (every 5 s) — only if HA client is up */
-    if (ha_ok) {
-        lv_timer_create(poll_timer_cb, POLL_INTERVAL_MS, NULL);
-    }
-
     /* --- Web config server ---------------------------------------- */
     config_server_set_path(config_path);
     if (config_server_start(WEB_SERVER_PORT, &g_config) != 0) {
@@ -152,27 +253,39 @@ int main(int argc, char *argv[])
         /* Non-fatal — the display app still works without the web UI */
     }
 
-    /* --- Main loop (~30 fps) -------------------------------------- */
+    /* --- Main loop (event driven) --------------------------------- */
     fprintf(stdout, "ha-pi: running (config=%s)\n", config_path);
 
     while (!g_shutdown) {
-        uint32_t t0 = get_tick_ms();
-        lv_timer_handler();
-        uint32_t elapsed = get_tick_ms() - t0;
+        /* UI commands queued by other threads (e.g. a web config save) */
+        light_ui_process();
+
+        bool touching = touch_driver_process();
+        uint32_t next_ms = lv_timer_handler();
+
+        if (g_perf_dump) {
+            g_perf_dump = 0;
+            perf_report();
+        }
+
+        if (touching && next_ms > FRAME_PERIOD_MS)
+            next_ms = FRAME_PERIOD_MS;
 
-        if (elapsed < FRAME_PERIOD_MS)
-            usleep((FRAME_PERIOD_MS - elapsed) * 1000);
+        event_loop_wait(next_ms);
     }
 
     /* --- Clean shutdown ------------------------------------------- */
     fprintf(stdout, "ha-pi: shutting down\n");
+    perf_report();
 
     config_server_stop();
     ha_client_cleanup();
     light_ui_destroy();
+    power_manager_deinit();
     touch_driver_deinit();
     display_driver_deinit();
     lv_deinit();
+    event_loop_deinit();
 
     return EXIT_SUCCESS;
 }
@@ -0,0 +1,160 @@
+/**
+ * perf_stats.c — Lightweight on-device performance counters
+ *
+ * Each metric keeps a log2-bucketed histogram plus exact count, sum and
+ * max. Percentiles are reported as the upper bound of the bucket the
+ * rank falls into, which is accurate to within a factor of two — plenty
+ * for spotting regressions between builds.
+ */
+
+#include "perf_stats.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+/* ------------------------------------------------------------------ */
+/*  Internal state                                                    */
+/* ------------------------------------------------------------------ */
+
+#define PERF_BUCKETS 32   /* bucket i holds values in [2^(i-1), 2^i) */
+
+/* A mark with no flush within this time produced no visible change */
+#define PERF_INPUT_MAX_US 2000000u
+
+typedef struct {
+    uint32_t buckets[PERF_BUCKETS];
+    uint32_t count;
+    uint32_t max;
+    uint64_t sum;
+} perf_hist_t;
+
+static perf_hist_t s_hist[PERF_METRIC_COUNT];
+static uint64_t    s_input_us;   /* Pending input mark, 0 = none */
+static uint64_t    s_frame_us;   /* Start of the current refresh, 0 = none */
+static bool        s_state_mark; /* State changed since the last refresh start */
+static bool        s_state_frame;/* Current refresh shows a state change */
+
+/** Display names, indexed by perf_metric_t. */
+static const char *const s_names[PERF_METRIC_COUNT] = {
+    [PERF_FLUSH_US]       = "flush_us",
+    [PERF_FRAME_FLUSH_US] = "frame_flush_us",
+    [PERF_TOUCH_TO_FLUSH_US] = "touch_to_flush_us",
+    [PERF_RENDER_US]      = "render_us",
+    [PERF_STATE_RENDER_US] = "state_render_us",
+    [PERF_FRAME_PX]       = "frame_px",
+};
+
+/* ------------------------------------------------------------------ */
+/*  Helpers                                                           */
+/* ------------------------------------------------------------------ */
+
+/** Bucket index for a value: 0 for 0, otherwise floor(log2(v)) + 1. */
+static int bucket_of(uint32_t v)
+{
+    int b = 0;
+    while (v) {
+        b++;
+        v >>= 1;
+    }
+    return b < PERF_BUCKETS ? b : PERF_BUCKETS - 1;
+}
+
+/** Upper bound of the bucket holding the sample at the given rank. */
+static uint32_t percentile(const perf_hist_t *h, uint32_t pct)
+{
+    uint32_t rank = (uint32_t)(((uint64_t)h->count * pct + 99) / 100);
+    uint32_t seen = 0;
+
+    for (int b = 0; b < PERF_BUCKETS; b++) {
+        seen += h->buckets[b];
+        if (seen >= rank) {
+            uint32_t upper = b == 0 ? 0 : (uint32_t)((1ull << b) - 1);
+            return upper < h->max ? upper : h->max;
+        }
+    }
+    return h->max;
+}
+
+/* ------------------------------------------------------------------ */
+/*  Public API                                                        */
+/* ------------------------------------------------------------------ */
+
+uint64_t perf_now_us(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000u + (uint64_t)ts.tv_nsec / 1000u;
+}
+
+void perf_record(perf_metric_t metric, uint32_t value)
+{
+    if ((unsigned)metric >= PERF_METRIC_COUNT) return;
+
+    perf_hist_t *h = &s_hist[metric];
+    h->buckets[bucket_of(value)]++;
+    h->count++;
+    h->sum += value;
+    if (value > h->max) h->max = value;
+}
+
+void perf_input_mark(uint64_t input_us)
+{
+    s_input_us = input_us;
+}
+
+void perf_input_flushed(void)
+{
+    if (s_input_us == 0) return;
+
+    uint64_t now = perf_now_us();
+    if (now >= s_input_us && now - s_input_us < PERF_INPUT_MAX_US)
+        perf_record(PERF_TOUCH_TO_FLUSH_US, (uint32_t)(now - s_input_us));
+    s_input_us = 0;
+}
+
+void perf_state_mark(void)
+{
+    s_state_mark = true;
+}
+
+void perf_frame_start(void)
+{
+    s_frame_us = perf_now_us();
+    s_state_frame = s_state_mark;
+    s_state_mark = false;
+}
+
+void perf_frame_done(bool drawn)
+{
+    if (s_frame_us == 0) return;
+
+    uint32_t dt = (uint32_t)(perf_now_us() - s_frame_us);
+    s_frame_us = 0;
+    if (!drawn) {
+        /* Nothing was invalidated yet; wait for the cycle that draws it */
+        s_state_mark |= s_state_frame;
+        return;
+    }
+
+    perf_record(PERF_RENDER_US, dt);
+    if (s_state_frame)
+        perf_record(PERF_STATE_RENDER_US, dt);
+}
+
+void perf_report(void)
+{
+    for (int m = 0; m < PERF_METRIC_COUNT; m++) {
+        const perf_hist_t *h = &s_hist[m];
+        if (h->count == 0) continue;
+
+        fprintf(stderr, "perf: %-18s n=%-7u mean=%-8llu p50=%-8u p90=%-8u "
+                "p99=%-8u max=%u\n",
+                s_names[m], h->count,
+                (unsigned long long)(h->sum / h->count),
+                percentile(h, 50), percentile(h, 90), percentile(h, 99),
+                h->max);
+    }
+
+    memset(s_hist, 0, sizeof(s_hist));
+}
@@ -0,0 +1,158 @@
+/**
+ * power_manager.c — Idle blanking for the display
+ *
+ * An LVGL timer compares lv_display_get_inactive_time() (reset by every
+ * touch press) against the configured timeout. Its period tracks the
+ * time left until the deadline, so an awake panel costs at most one
+ * wakeup every few seconds.
+ *
+ * While blanked:
+ *   - the panel and backlight are off (display_driver_set_blank)
+ *   - invalidation and the display refresh timer are paused, so
+ *     animations and HA updates neither render nor flush anything
+ *   - the touch driver's wake filter swallows the first press and
+ *     calls power_manager_wake(), which redraws the whole screen
+ */
+
+#include "power_manager.h"
+#include "display_driver.h"
+#include "touch_driver.h"
+
+#include <stdatomic.h>
+#include <stdio.h>
+
+#include "lvgl.h"
+
+/* ------------------------------------------------------------------ */
+/*  Constants                                                         */
+/* ------------------------------------------------------------------ */
+
+#define IDLE_CHECK_MIN_MS   100    /* Shortest idle timer period       */
+#define IDLE_CHECK_MAX_MS  5000    /* Longest period (timeout changes) */
+
+/* ------------------------------------------------------------------ */
+/*  Module-level state                                                */
+/* ------------------------------------------------------------------ */
+
+static lv_timer_t        *idle_timer = NULL;
+static atomic_uint        timeout_ms = 0;   /* Set from any thread */
+static bool               blanked = false;
+
+/* ------------------------------------------------------------------ */
+/*  Internal helpers                                                  */
+/* ------------------------------------------------------------------ */
+
+/** Blank the panel and stop all LVGL rendering work. */
+static void enter_blank(void)
+{
+    lv_display_t *disp = lv_display_get_default();
+
+    display_driver_set_blank(true);
+
+    if (disp) {
+        lv_display_enable_invalidation(disp, false);
+        lv_timer_pause(lv_display_get_refr_timer(disp));
+    }
+    lv_timer_pause(idle_timer);
+
+    blanked = true;
+    fprintf(stderr, "power_manager: idle, display blanked\n");
+}
+
+/**
+ * Touch wake filter — runs on the LVGL thread from the indev read.
+ *
+ * Returns true to swallow the press that woke the panel.
+ */
+static bool wake_filter(void)
+{
+    if (!blanked) return false;
+
+    power_manager_wake();
+    return true;
+}
+
+/** Idle timer — blanks once the display has been inactive long enough. */
+static void idle_timer_cb(lv_timer_t *timer)
+{
+    uint32_t timeout = atomic_load_explicit(&timeout_ms,
+                                            memory_order_relaxed);
+
+    if (timeout == 0 || blanked) {
+        lv_timer_set_period(timer, IDLE_CHECK_MAX_MS);
+        return;
+    }
+
+    uint32_t inactive = lv_display_get_inactive_time(NULL);
+    if (inactive >= timeout) {
+        enter_blank();
+        return;
+    }
+
+    /* Sleep until the deadline, but re-check often enough to notice
+     * a changed timeout from a config reload */
+    uint32_t remaining = timeout - inactive;
+    if (remaining < IDLE_CHECK_MIN_MS) remaining = IDLE_CHECK_MIN_MS;
+    if (remaining > IDLE_CHECK_MAX_MS) remaining = IDLE_CHECK_MAX_MS;
+    lv_timer_set_period(timer, remaining);
+}
+
+/* ------------------------------------------------------------------ */
+/*  Public API                                                        */
+/* ------------------------------------------------------------------ */
+
+void power_manager_init(uint32_t timeout_s)
+{
+    power_manager_set_timeout(timeout_s);
+    blanked = false;
+
+    idle_timer = lv_timer_create(idle_timer_cb, IDLE_CHECK_MAX_MS, NULL);
+    touch_driver_set_wake_filter(wake_filter);
+
+    if (timeout_s > 0)
+        fprintf(stderr, "power_manager: blanking after %u s idle\n",
+                timeout_s);
+}
+
+void power_manager_set_timeout(uint32_t timeout_s)
+{
+    atomic_store_explicit(&timeout_ms, timeout_s * 1000u,
+                          memory_order_relaxed);
+}
+
+bool power_manager_is_blanked(void)
+{
+    return blanked;
+}
+
+void power_manager_wake(void)
+{
+    if (!blanked) return;
+
+    lv_display_t *disp = lv_display_get_default();
+
+    blanked = false;
+    if (disp) {
+        lv_display_enable_invalidation(disp, true);
+        lv_timer_resume(lv_display_get_refr_timer(disp));
+        lv_display_trigger_activity(disp);
+        /* Updates made while blanked were not recorded — redraw all */
+        lv_obj_invalidate(lv_display_get_screen_active(disp));
+    }
+    lv_timer_resume(idle_timer);
+    lv_timer_set_period(idle_timer, IDLE_CHECK_MIN_MS);
+
+    display_driver_set_blank(false);
+    fprintf(stderr, "power_manager: display woken\n");
+}
+
+void power_manager_deinit(void)
+{
+    power_manager_wake();
+    touch_driver_set_wake_filter(NULL);
+
+    if (idle_timer) {
+        lv_timer_delete(idle_timer);
+        idle_timer = NULL;
+    }
+}
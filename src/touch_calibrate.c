@@ -0,0 +1,236 @@
+/**
+ * touch_calibrate.c — On-screen 3-point touchscreen calibration
+ *
+ * The targets sit at 10 % / 90 % of the panel so the solved matrix is
+ * well conditioned. Each tap's raw coordinates come from the touch
+ * driver (already median-filtered if enabled); the matrix is solved
+ * once in floating point with Cramer's rule and stored as Q16, so the
+ * per-sample mapping stays integer-only.
+ *
+ * A result is only accepted if the taps spread over the digitizer about
+ * as far as the targets spread over the panel, and if the matrix keeps
+ * the digitizer's corners near the panel. Anything else (a stray double
+ * tap, taps along a line) would make the touchscreen unusable, so the
+ * routine starts over instead.
+ *
+ * Swipe delivery is switched off while the overlay is up: a tap that
+ * drifts past the swipe threshold would otherwise page the tiles behind
+ * it and lose its release, so the target would never register.
+ */
+
+#include "touch_calibrate.h"
+#include "touch_driver.h"
+#include "display_driver.h"
+
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "lvgl.h"
+
+/* ------------------------------------------------------------------ */
+/*  Constants                                                         */
+/* ------------------------------------------------------------------ */
+
+#define CROSS_SIZE   30
+#define CROSS_WIDTH  3
+
+/* Acceptance limits for a solved matrix */
+#define MIN_AREA_PCT   15   /* Tap triangle vs target triangle, per axis range */
+#define MAX_REACH_PCT  25   /* Digitizer corners may land this far off-panel   */
+
+/** Target positions in physical panel pixels (not collinear). */
+static const int32_t targets[3][2] = {
+    { DISP_HOR_RES / 10,     DISP_VER_RES / 10 },
+    { DISP_HOR_RES * 9 / 10, DISP_VER_RES / 2 },
+    { DISP_HOR_RES / 2,      DISP_VER_RES * 9 / 10 },
+};
+
+/* ------------------------------------------------------------------ */
+/*  Module-level state                                                */
+/* ------------------------------------------------------------------ */
+
+static lv_obj_t *overlay = NULL;
+static lv_obj_t *cross_h = NULL;
+static lv_obj_t *cross_v = NULL;
+static lv_obj_t *hint = NULL;
+static int       step = 0;
+static int32_t   raw_pts[3][2];
+static touch_device_info_t raw_src[3];
+static touch_calibrate_done_cb_t done = NULL;
+static touch_gesture_cb_t saved_gesture = NULL; /* Restored on close */
+
+/* ------------------------------------------------------------------ */
+/*  Internal helpers                                                  */
+/* ------------------------------------------------------------------ */
+
+/** Move the crosshair to the current target and update the hint. */
+static void show_target(const char *msg)
+{
+    int16_t x = (int16_t)targets[step][0];
+    int16_t y = (int16_t)targets[step][1];
+
+    /* Targets are panel pixels; the overlay is in logical coordinates */
+    display_driver_phys_to_logical(&x, &y);
+
+    lv_obj_set_pos(cross_h, x - CROSS_SIZE / 2, y - CROSS_WIDTH / 2);
+    lv_obj_set_pos(cross_v, x - CROSS_WIDTH / 2, y - CROSS_SIZE / 2);
+    lv_label_set_text_fmt(hint, "%s\nTap the cross (%d/3)", msg, step + 1);
+}
+
+/** Overlay release handler — record one point, finish after three. */
+static void overlay_event_cb(lv_event_t *e)
+{
+    (void)e;
+    touch_driver_get_raw(&raw_pts[step][0], &raw_pts[step][1]);
+
+    /* All three taps must come from the same controller */
+    if (!touch_driver_get_source(&raw_src[step]) ||
+        (step > 0 && memcmp(&raw_src[step], &raw_src[0],
+                            sizeof(raw_src[0])) != 0)) {
+        step = 0;
+        show_target("Touchscreen changed - try again");
+        return;
+    }
+
+    if (++step < 3) {
+        show_target("Touchscreen calibration");
+        return;
+    }
+
+    int32_t calib[6];
+    int rc = touch_calibrate_solve((const int32_t (*)[2])raw_pts, targets,
+                                   &raw_src[0], calib);
+    if (rc != 0) {
+        step = 0;
+        show_target(rc == -1 ? "Taps too close together - try again"
+                             : "Taps off target - try again");
+        return;
+    }
+
+    touch_driver_set_calibration(calib, raw_src[0].id);
+    fprintf(stderr, "touch_calibrate: matrix %d %d %d %d %d %d for '%s'\n",
+            calib[0], calib[1], calib[2], calib[3], calib[4], calib[5],
+            raw_src[0].id);
+
+    lv_obj_delete(overlay);
+    overlay = NULL;
+    if (done)
+        done(calib, raw_src[0].id);
+}
+
+/** Overlay deleted — hand swipes back to whoever had them. */
+static void overlay_delete_cb(lv_event_t *e)
+{
+    (void)e;
+    touch_driver_set_gesture_cb(saved_gesture);
+    saved_gesture = NULL;
+}
+
+/** Create one crosshair bar. */
+static lv_obj_t *create_bar(int32_t w, int32_t h)
+{
+    lv_obj_t *bar = lv_obj_create(overlay);
+    lv_obj_remove_style_all(bar);
+    lv_obj_set_size(bar, w, h);
+    lv_obj_set_style_bg_color(bar, lv_color_hex(0xFFFFFF), 0);
+    lv_obj_set_style_bg_opa(bar, LV_OPA_COVER, 0);
+    lv_obj_remove_flag(bar, LV_OBJ_FLAG_CLICKABLE);
+    return bar;
+}
+
+/* ------------------------------------------------------------------ */
+/*  Public API                                                        */
+/* ------------------------------------------------------------------ */
+
+int touch_calibrate_solve(const int32_t raw[3][2], const int32_t panel[3][2],
+                          const touch_device_info_t *dev, int32_t calib[6])
+{
+    double x0 = raw[0][0], y0 = raw[0][1];
+    double x1 = raw[1][0], y1 = raw[1][1];
+    double x2 = raw[2][0], y2 = raw[2][1];
+
+    /* det of [[x0 y0 1] [x1 y1 1] [x2 y2 1]]: twice the tap triangle's
+     * signed area */
+    double det = x0 * (y1 - y2) - y0 * (x1 - x2) + (x1 * y2 - x2 * y1);
+    double pdet = (double)(panel[1][0] - panel[0][0]) * (panel[2][1] - panel[0][1])
+                - (double)(panel[2][0] - panel[0][0]) * (panel[1][1] - panel[0][1]);
+
+    /* Both areas as a fraction of their whole surface: the taps must
+     * cover a fair share of what the targets cover */
+    double xspan = dev->abs_x_max > dev->abs_x_min
+                 ? (double)dev->abs_x_max - dev->abs_x_min : 1.0;
+    double yspan = dev->abs_y_max > dev->abs_y_min
+                 ? (double)dev->abs_y_max - dev->abs_y_min : 1.0;
+    double raw_frac = fabs(det) / (xspan * yspan);
+    double panel_frac = fabs(pdet) / ((double)DISP_HOR_RES * DISP_VER_RES);
+    if (det == 0.0 || raw_frac * 100.0 < panel_frac * MIN_AREA_PCT)
+        return -1;
+
+    double m[6];
+    for (int axis = 0; axis < 2; axis++) {
+        double p0 = panel[0][axis], p1 = panel[1][axis], p2 = panel[2][axis];
+
+        /* Cramer's rule for [a b c] in p = a*x + b*y + c */
+        double a = (p0 * (y1 - y2) - y0 * (p1 - p2) + (p1 * y2 - p2 * y1)) / det;
+        double b = (x0 * (p1 - p2) - p0 * (x1 - x2) + (x1 * p2 - x2 * p1)) / det;
+        double c = (x0 * (y1 * p2 - y2 * p1) - y0 * (x1 * p2 - x2 * p1)
+                    + p0 * (x1 * y2 - x2 * y1)) / det;
+
+        m[axis * 3 + 0] = a;
+        m[axis * 3 + 1] = b;
+        m[axis * 3 + 2] = c;
+    }
+
+    /* The digitizer's corners must land on or near the panel */
+    const double reach_x = DISP_HOR_RES * MAX_REACH_PCT / 100.0;
+    const double reach_y = DISP_VER_RES * MAX_REACH_PCT / 100.0;
+    for (int corner = 0; corner < 4; corner++) {
+        double rx = (corner & 1) ? dev->abs_x_max : dev->abs_x_min;
+        double ry = (corner & 2) ? dev->abs_y_max : dev->abs_y_min;
+        double px = m[0] * rx + m[1] * ry + m[2];
+        double py = m[3] * rx + m[4] * ry + m[5];
+
+        if (px < -reach_x || px > DISP_HOR_RES + reach_x ||
+            py < -reach_y || py > DISP_VER_RES + reach_y)
+            return -2;
+    }
+
+    for (int i = 0; i < 6; i++)
+        calib[i] = (int32_t)lround(m[i] * 65536.0);
+    return 0;
+}
+
+int touch_calibrate_start(touch_calibrate_done_cb_t done_cb)
+{
+    if (overlay) return 0;   /* Already running */
+
+    overlay = lv_obj_create(lv_layer_top());
+    if (!overlay) return -1;
+
+    lv_obj_remove_style_all(overlay);
+    lv_obj_set_size(overlay, display_driver_get_hor_res(),
+                    display_driver_get_ver_res());
+    lv_obj_set_style_bg_color(overlay, lv_color_hex(0x000000), 0);
+    lv_obj_set_style_bg_opa(overlay, LV_OPA_COVER, 0);
+    lv_obj_add_flag(overlay, LV_OBJ_FLAG_CLICKABLE);
+    lv_obj_add_event_cb(overlay, overlay_event_cb, LV_EVENT_RELEASED, NULL);
+    lv_obj_add_event_cb(overlay, overlay_delete_cb, LV_EVENT_DELETE, NULL);
+
+    cross_h = create_bar(CROSS_SIZE, CROSS_WIDTH);
+    cross_v = create_bar(CROSS_WIDTH, CROSS_SIZE);
+
+    hint = lv_label_create(overlay);
+    lv_obj_set_style_text_color(hint, lv_color_hex(0xFFFFFF), 0);
+    lv_obj_set_style_text_align(hint, LV_TEXT_ALIGN_CENTER, 0);
+    lv_obj_center(hint);
+
+    /* Every touch is a calibration tap until the overlay closes */
+    saved_gesture = touch_driver_get_gesture_cb();
+    touch_driver_set_gesture_cb(NULL);
+
+    step = 0;
+    done = done_cb;
+    show_target("Touchscreen calibration");
+    return 0;
+}
@@ -5,18 +5,55 @@
  * When the LCD-show kernel driver is installed, the XPT2046 appears as
  * a standard input device with ABS_X/ABS_Y events.
  *
- * Falls back to scanning all /dev/input/event* devices to find one
- * that reports ABS_X capability (i.e. a touchscreen).
+ * Every /dev/input/event* device that reports ABS_X capability (i.e. a
+ * touchscreen or similar absolute pointer) is opened, up to
+ * MAX_TOUCH_DEVS. /dev/input is watched with inotify, so a controller
+ * that is re-enumerated (fbtft reload, USB panel re-plugged) is picked
+ * up again without restarting the process, and one that disappears is
+ * simply closed. All devices feed the same LVGL pointer: the first to
+ * touch down owns it until release, so two panels never fight over the
+ * cursor.
  *
- * A background pthread reads events at native rate and stores the
- * latest touch state behind a mutex. LVGL's read callback picks up
- * the state on each input tick.
+ * A background pthread sleeps in poll() on the evdev fds, the inotify
+ * fd and an eventfd used to stop it, drains up to EVENT_BATCH queued
+ * events per read() and queues every report as a timestamped sample in
+ * a lock-free SPSC ring, then wakes the main loop through
+ * event_loop_wake(). It is the ring's only producer whatever the number
+ * of devices. No input means no wakeups. touch_read_cb takes one sample
+ * per LVGL read and touch_driver_process() reads until the ring is
+ * empty, so no press, release or swipe point is lost to frame-rate
+ * sampling.
+ *
+ * Swipes are recognised in the touch thread from every report and its
+ * kernel timestamp: the first sample of a press that has moved far
+ * enough, fast enough and mostly along one axis carries the direction
+ * through the ring, and touch_driver_process() hands it to the gesture
+ * callback right after LVGL has read that sample.
+ *
+ * Mapping: raw controller coordinates go through a 2×3 affine matrix in
+ * Q16 fixed point (the saved 3-point calibration on the controller it
+ * was taken on, else a default derived from the device's own axis
+ * ranges), then the display's rotation/mirroring. An optional
+ * median-of-3 filter on the raw axes removes jitter spikes.
+ *
+ * Record / replay: the raw evdev stream can be written to a compact
+ * binary file (axis ranges in the header, then 12-byte records of
+ * delay, type, code and value). A replay thread feeds such a file
+ * through the same decoder at original or scaled speed with no
+ * /dev/input device, giving repeatable UI workloads for benchmarks.
+ *
+ * The LVGL input device runs in event mode: it is read by
+ * touch_driver_process() right after such a wake instead of on a 30 Hz
+ * polling timer, so a touch reaches LVGL without waiting for the next
+ * tick.
  *
  * Requirements: 2.1, 2.2, 2.3, 2.4
  */
 
 #include "touch_driver.h"
-#include "display_driver.h"   /* DISP_HOR_RES, DISP_VER_RES */
+#include "display_driver.h"   /* DISP_HOR_RES, orientation mapping */
+#include "event_loop.h"
+#include "perf_stats.h"
 
 #include <stdio.h>
 #include <stdlib.h>
@@ -26,34 +63,195 @@
 #include <errno.h>
 #include <dirent.h>
 #include <pthread.h>
+#include <poll.h>
+#include <stdatomic.h>
+#include <time.h>
 #include <linux/input.h>
+#include <sys/eventfd.h>
+#include <sys/inotify.h>
 #include <sys/ioctl.h>
 
 /* ------------------------------------------------------------------ */
-/*  Shared touch state (protected by mutex)                           */
+/*  Touch sample ring (lock-free, single producer / single consumer)  */
 /* ------------------------------------------------------------------ */
 
+/* Power of two; ~1 s of reports at the XPT2046's ~200 Hz */
+#define TOUCH_RING_SIZE 256
+
 typedef struct {
-    int16_t  x;
+    uint64_t time_us;   /* Kernel timestamp of the SYN_REPORT */
+    int32_t  raw_x;     /* Filtered controller coordinates    */
+    int32_t  raw_y;
+    int16_t  x;         /* Logical screen coordinates         */
     int16_t  y;
     bool     pressed;
+    uint8_t  gesture;   /* lv_dir_t of a swipe recognised here */
+    int8_t   src;       /* devs[] slot, -1 = replay source     */
 } touch_state_t;
 
-static pthread_mutex_t touch_mutex = PTHREAD_MUTEX_INITIALIZER;
-static touch_state_t   touch_state = { .x = 0, .y = 0, .pressed = false };
+/* The touch thread only advances ring_head, touch_read_cb only
+ * ring_tail; the release/acquire pair publishes the slot contents */
+static touch_state_t ring[TOUCH_RING_SIZE];
+static atomic_uint   ring_head = 0;
+static atomic_uint   ring_tail = 0;
+
+/** Producer: append a sample. Returns false (sample dropped) if full. */
+static bool ring_push(const touch_state_t *st)
+{
+    unsigned head = atomic_load_explicit(&ring_head, memory_order_relaxed);
+    unsigned tail = atomic_load_explicit(&ring_tail, memory_order_acquire);
+
+    if (head - tail == TOUCH_RING_SIZE)
+        return false;
+
+    ring[head & (TOUCH_RING_SIZE - 1)] = *st;
+    atomic_store_explicit(&ring_head, head + 1, memory_order_release);
+    return true;
+}
+
+/** Consumer: take the oldest sample. Returns false if empty. */
+static bool ring_pop(touch_state_t *out)
+{
+    unsigned tail = atomic_load_explicit(&ring_tail, memory_order_relaxed);
+    unsigned head = atomic_load_explicit(&ring_head, memory_order_acquire);
+
+    if (head == tail)
+        return false;
+
+    *out = ring[tail & (TOUCH_RING_SIZE - 1)];
+    atomic_store_explicit(&ring_tail, tail + 1, memory_order_release);
+    return true;
+}
+
+/** Consumer: whether samples are waiting. */
+static bool ring_empty(void)
+{
+    return atomic_load_explicit(&ring_head, memory_order_acquire) ==
+           atomic_load_explicit(&ring_tail, memory_order_relaxed);
+}
 
 /* ------------------------------------------------------------------ */
 /*  Module-level state                                                */
 /* ------------------------------------------------------------------ */
 
-static int event_fd = -1;
+#define EVENT_BATCH    64   /* input_events fetched per read()   */
+#define MAX_TOUCH_DEVS 4    /* Pointer devices read at once      */
+
+/* Swipe recognition, in logical pixels and device-clock time */
+#define SWIPE_MIN_PX     40       /* Travel since touch-down           */
+#define SWIPE_MIN_SPEED  300      /* px/s over the last SWIPE_WINDOW   */
+#define SWIPE_WINDOW_US  80000
+#define SWIPE_HIST       16       /* Samples kept for the speed window */
+
+/** Recent positions of the current press, for swipe speed. */
+typedef struct {
+    int16_t  x0, y0;                 /* Touch-down position           */
+    int16_t  hx[SWIPE_HIST];
+    int16_t  hy[SWIPE_HIST];
+    uint64_t ht[SWIPE_HIST];
+    int      n;                      /* Samples since touch-down      */
+    bool     fired;                  /* One swipe per press           */
+} swipe_tracker_t;
+
+/** Per-device state while assembling evdev events into samples. */
+typedef struct {
+    int32_t raw_x;
+    int32_t raw_y;
+    bool pressed;
+    int32_t hist_x[3];      /* Jitter filter history (this press)    */
+    int32_t hist_y[3];
+    int hist_n;
+    touch_state_t st;
+    swipe_tracker_t swipe;
+    unsigned long dropped;
+} touch_decoder_t;
+
+/** One open input device (or the replay source). */
+typedef struct {
+    int fd;                 /* -1 = free slot                          */
+    char path[32];          /* /dev/input/eventN                       */
+    char id[TOUCH_DEVICE_ID_MAX];  /* "vvvv:pppp name", see dev_open  */
+    bool mono;              /* Timestamps are on CLOCK_MONOTONIC       */
+    int32_t abs_x_min, abs_x_max;
+    int32_t abs_y_min, abs_y_max;
+    int32_t def_calib[6];   /* Matrix used while uncalibrated          */
+    unsigned calib_gen;     /* calib_gen when calib_match was decided  */
+    bool calib_match;       /* The saved calibration is for this device */
+    touch_decoder_t dec;
+} touch_dev_t;
+
+/* Devices and the inotify watch belong to the touch thread once it has
+ * started; touch_driver_init() fills them in before that */
+static touch_dev_t devs[MAX_TOUCH_DEVS];
+static touch_dev_t replay_dev;
+static int inotify_fd = -1;
+static int pointer_owner = -1;       /* devs[] index holding the press  */
+
+/* Held by the touch thread while it opens or closes a slot, and by
+ * touch_driver_get_source() while it reads one */
+static pthread_mutex_t dev_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static int stop_fd = -1;             /* eventfd: tells the thread to exit */
 static lv_indev_t *indev = NULL;
 static pthread_t poll_thread;
-static volatile bool poll_running = false;
+static bool poll_running = false;    /* Thread started (LVGL thread only) */
+
+/* Last sample handed to LVGL, repeated while the ring is empty */
+static touch_state_t last_state = { 0 };
+
+/* Wake-on-touch: the filter may swallow a press until it is released */
+static touch_wake_filter_t wake_filter = NULL;
+static bool was_pressed = false;
+static uint64_t press_time_us = 0;   /* Finger-down time of this press */
+static bool swallowing = false;
+
+/* Swipe seen by touch_read_cb, delivered by touch_driver_process */
+static touch_gesture_cb_t gesture_cb = NULL;
+static lv_dir_t pending_gesture = LV_DIR_NONE;
+
+/** A saved calibration and the controller it was taken on. */
+typedef struct {
+    int32_t m[6];
+    char    device[TOUCH_DEVICE_ID_MAX];   /* "" = the first device found */
+} calib_t;
+
+/* Raw → panel affine matrix (Q16). The LVGL thread writes the spare
+ * slot and then publishes it by bumping calib_gen, so the reader never
+ * sees a torn matrix. Each device checks once per generation whether
+ * the matrix is its own; otherwise, or while calib_gen is 0, it uses
+ * its own default */
+static calib_t     calib_slot[2];
+static atomic_int  calib_active = 0;
+static atomic_uint calib_gen = 0;
+static char        first_dev_id[TOUCH_DEVICE_ID_MAX];  /* Touch thread */
+static bool        filter_enabled = false;  /* Median-of-3 on raw axes */
 
-/* ABS axis ranges from the kernel driver */
-static int32_t abs_x_min = 0, abs_x_max = 4095;
-static int32_t abs_y_min = 0, abs_y_max = 4095;
+/* Record / replay (see touch_driver_init) */
+#define REC_MAGIC   0x52544148u   /* "HATR" little-endian */
+#define REC_VERSION 1
+
+/** Recording header: the source device's axis ranges. */
+typedef struct {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t reserved;
+    int32_t  abs_x_min, abs_x_max;
+    int32_t  abs_y_min, abs_y_max;
+} rec_header_t;
+
+/** One recorded evdev event. */
+typedef struct {
+    uint32_t dt_us;     /* Time since the previous record */
+    uint16_t type;
+    uint16_t code;
+    int32_t  value;
+} rec_event_t;
+
+static FILE *rec_file = NULL;        /* Recording in progress, or NULL */
+static char rec_dev_path[32];        /* Device being recorded          */
+static uint64_t rec_last_us = 0;     /* Timestamp of the last record   */
+static FILE *replay_file = NULL;     /* Replay source, or NULL         */
+static double replay_speed = 1.0;
 
 /* ------------------------------------------------------------------ */
 /*  Input device discovery                                            */
@@ -76,129 +274,572 @@ static int has_abs_x(int fd)
             >> (ABS_X % (8 * sizeof(unsigned long)))) & 1;
 }
 
+static void calib_default(const touch_dev_t *dev, int32_t m[6]);
+
+/** devs[] slot holding path, or -1. */
+static int dev_find(const char *path)
+{
+    for (int i = 0; i < MAX_TOUCH_DEVS; i++) {
+        if (devs[i].fd >= 0 && strcmp(devs[i].path, path) == 0)
+            return i;
+    }
+    return -1;
+}
+
 /**
- * Find and open the first touchscreen input device.
- * Returns fd on success, -1 if none found.
+ * Open /dev/input/<name> if it is an absolute pointer we do not already
+ * read: fetch its axis ranges, switch it to monotonic timestamps and
+ * grab it. Returns the devs[] slot, or -1 if it was skipped.
  */
-static int find_touch_device(void)
+static int dev_open(const char *name)
+{
+    char path[sizeof(devs[0].path)];
+
+    if (strncmp(name, "event", 5) != 0)
+        return -1;
+    snprintf(path, sizeof(path), "/dev/input/%s", name);
+    if (dev_find(path) >= 0)
+        return -1;
+
+    int slot = -1;
+    for (int i = 0; i < MAX_TOUCH_DEVS && slot < 0; i++) {
+        if (devs[i].fd < 0)
+            slot = i;
+    }
+    if (slot < 0)
+        return -1;
+
+    /* Fails harmlessly while udev is still fixing permissions; the
+     * IN_ATTRIB that follows brings us back here */
+    int fd = open(path, O_RDONLY | O_NONBLOCK | O_CLOEXEC);
+    if (fd < 0)
+        return -1;
+    if (!has_abs_x(fd)) {
+        close(fd);
+        return -1;
+    }
+
+    /* Identity a calibration is tied to: bus ids plus name, since SPI
+     * controllers such as the ADS7846/XPT2046 report vendor 0 */
+    struct input_id in_id = { 0 };
+    char dev_name[64] = "Unknown";
+    ioctl(fd, EVIOCGID, &in_id);
+    ioctl(fd, EVIOCGNAME(sizeof(dev_name)), dev_name);
+    dev_name[sizeof(dev_name) - 1] = '\0';
+
+    touch_dev_t *dev = &devs[slot];
+    pthread_mutex_lock(&dev_lock);
+    memset(dev, 0, sizeof(*dev));
+    dev->fd = fd;
+    snprintf(dev->path, sizeof(dev->path), "%s", path);
+    snprintf(dev->id, sizeof(dev->id), "%04x:%04x %s",
+             in_id.vendor, in_id.product, dev_name);
+    if (first_dev_id[0] == '\0')
+        snprintf(first_dev_id, sizeof(first_dev_id), "%s", dev->id);
+    dev->abs_x_min = 0; dev->abs_x_max = 4095;
+    dev->abs_y_min = 0; dev->abs_y_max = 4095;
+
+    struct input_absinfo abs_info;
+    if (ioctl(fd, EVIOCGABS(ABS_X), &abs_info) == 0) {
+        dev->abs_x_min = abs_info.minimum;
+        dev->abs_x_max = abs_info.maximum;
+    }
+    if (ioctl(fd, EVIOCGABS(ABS_Y), &abs_info) == 0) {
+        dev->abs_y_min = abs_info.minimum;
+        dev->abs_y_max = abs_info.maximum;
+    }
+    calib_default(dev, dev->def_calib);
+    pthread_mutex_unlock(&dev_lock);
+
+    /* Timestamp events on CLOCK_MONOTONIC so they can be compared with
+     * perf_now_us() for end-to-end latency */
+    int clk = CLOCK_MONOTONIC;
+    dev->mono = ioctl(fd, EVIOCSCLOCKID, &clk) == 0;
+    if (!dev->mono)
+        fprintf(stderr, "touch_driver: EVIOCSCLOCKID failed on %s, touch "
+                "latency will not be measured\n", path);
+
+    /* Grab exclusive access so no other process consumes our events */
+    if (ioctl(fd, EVIOCGRAB, 1) < 0)
+        fprintf(stderr, "touch_driver: EVIOCGRAB failed on %s (non-fatal): "
+                "%s\n", path, strerror(errno));
+
+    fprintf(stderr, "touch_driver: found '%s' at %s (X: %d-%d, Y: %d-%d)\n",
+            dev->id, path, dev->abs_x_min, dev->abs_x_max,
+            dev->abs_y_min, dev->abs_y_max);
+    return slot;
+}
+
+/** Close a device slot. Returns true if it was holding the pointer. */
+static bool dev_close(int slot, const char *why)
+{
+    touch_dev_t *dev = &devs[slot];
+
+    if (dev->fd < 0)
+        return false;
+    if (why)
+        fprintf(stderr, "touch_driver: %s %s\n", dev->path, why);
+
+    ioctl(dev->fd, EVIOCGRAB, 0);
+    close(dev->fd);
+    pthread_mutex_lock(&dev_lock);
+    dev->fd = -1;
+    pthread_mutex_unlock(&dev_lock);
+
+    if (pointer_owner != slot)
+        return false;
+    pointer_owner = -1;
+    return true;
+}
+
+/** Open every touchscreen currently in /dev/input. Returns the count. */
+static int dev_scan(void)
 {
     DIR *dir = opendir("/dev/input");
-    if (!dir) return -1;
+    if (!dir) return 0;
 
     struct dirent *ent;
-    int fd = -1;
-
+    int found = 0;
     while ((ent = readdir(dir)) != NULL) {
-        if (strncmp(ent->d_name, "event", 5) != 0)
-            continue;
+        if (dev_open(ent->d_name) >= 0)
+            found++;
+    }
 
-        char path[64];
-        snprintf(path, sizeof(path), "/dev/input/%s", ent->d_name);
+    closedir(dir);
+    return found;
+}
 
-        int test_fd = open(path, O_RDONLY | O_NONBLOCK);
-        if (test_fd < 0) continue;
+/* ------------------------------------------------------------------ */
+/*  Coordinate mapping                                                */
+/* ------------------------------------------------------------------ */
 
-        if (has_abs_x(test_fd)) {
-            /* Read axis ranges */
-            struct input_absinfo abs_info;
-            if (ioctl(test_fd, EVIOCGABS(ABS_X), &abs_info) == 0) {
-                abs_x_min = abs_info.minimum;
-                abs_x_max = abs_info.maximum;
-            }
-            if (ioctl(test_fd, EVIOCGABS(ABS_Y), &abs_info) == 0) {
-                abs_y_min = abs_info.minimum;
-                abs_y_max = abs_info.maximum;
-            }
+/**
+ * Default matrix for an uncalibrated panel, from the device's axis
+ * ranges. The XPT2046 digitizer is rotated relative to the ILI9486 in
+ * landscape (480×320): touch ABS_Y runs along screen X, and ABS_X runs
+ * along screen Y, inverted.
+ */
+static void calib_default(const touch_dev_t *dev, int32_t m[6])
+{
+    int32_t abs_x_min = dev->abs_x_min, abs_x_max = dev->abs_x_max;
+    int32_t abs_y_min = dev->abs_y_min, abs_y_max = dev->abs_y_max;
+    int64_t yspan = abs_y_max > abs_y_min ? abs_y_max - abs_y_min : 1;
+    int64_t xspan = abs_x_max > abs_x_min ? abs_x_max - abs_x_min : 1;
+    int64_t kx = ((int64_t)DISP_HOR_RES << 16) / yspan;
+    int64_t ky = ((int64_t)DISP_VER_RES << 16) / xspan;
+
+    m[0] = 0;
+    m[1] = (int32_t)kx;
+    m[2] = (int32_t)(-abs_y_min * kx);
+    m[3] = (int32_t)-ky;
+    m[4] = 0;
+    m[5] = (int32_t)(((int64_t)(DISP_VER_RES - 1) << 16) + abs_x_min * ky);
+}
+
+/** Clamp to [0, max - 1]. */
+static int16_t clamp_axis(int64_t v, int32_t max)
+{
+    if (v < 0) return 0;
+    if (v >= max) return (int16_t)(max - 1);
+    return (int16_t)v;
+}
+
+/**
+ * Raw controller coordinates → physical panel pixel: two multiply-adds
+ * and a rounding shift per axis, no division. The saved matrix is only
+ * used on the device it was taken on; a calibration without a device
+ * (older config files) belongs to the first touchscreen found, and a
+ * replay stands in for the device it was recorded on.
+ */
+static void calib_apply(touch_dev_t *dev, int32_t rx, int32_t ry,
+                        int16_t *px, int16_t *py)
+{
+    unsigned gen = atomic_load_explicit(&calib_gen, memory_order_acquire);
+    const calib_t *c = &calib_slot[atomic_load_explicit(&calib_active,
+                                                        memory_order_acquire)];
+
+    if (gen != dev->calib_gen) {
+        const char *want = c->device[0] ? c->device : first_dev_id;
+        dev->calib_match = gen != 0 &&
+            (dev == &replay_dev || strcmp(want, dev->id) == 0);
+        dev->calib_gen = gen;
+    }
+    const int32_t *m = dev->calib_match ? c->m : dev->def_calib;
+
+    int64_t x = ((int64_t)m[0] * rx + (int64_t)m[1] * ry + m[2] + 0x8000) >> 16;
+    int64_t y = ((int64_t)m[3] * rx + (int64_t)m[4] * ry + m[5] + 0x8000) >> 16;
+
+    *px = clamp_axis(x, DISP_HOR_RES);
+    *py = clamp_axis(y, DISP_VER_RES);
+}
+
+/** Median of three. */
+static int32_t median3(int32_t a, int32_t b, int32_t c)
+{
+    if (a > b) { int32_t t = a; a = b; b = t; }
+    if (b > c) b = c;
+    return a > b ? a : b;
+}
 
-            char name[128] = "Unknown";
-            ioctl(test_fd, EVIOCGNAME(sizeof(name)), name);
-            fprintf(stderr, "touch_driver: found '%s' at %s "
-                    "(X: %d-%d, Y: %d-%d)\n",
-                    name, path, abs_x_min, abs_x_max,
-                    abs_y_min, abs_y_max);
+/* ------------------------------------------------------------------ */
+/*  Event decoding                                                    */
+/* ------------------------------------------------------------------ */
+
+/**
+ * Track one pressed sample and report a swipe the moment the press has
+ * travelled SWIPE_MIN_PX from touch-down, mostly along one axis, while
+ * still moving at SWIPE_MIN_SPEED or more in that direction. Speed is
+ * taken over the last SWIPE_WINDOW_US of samples, so a slow drag that
+ * ends in a flick still counts and a slow drag alone does not.
+ *
+ * @param first  First sample of the press
+ * @return Swipe direction, or LV_DIR_NONE
+ */
+static lv_dir_t swipe_update(swipe_tracker_t *sw, bool first,
+                             int16_t x, int16_t y, uint64_t t)
+{
+    if (first) {
+        memset(sw, 0, sizeof(*sw));
+        sw->x0 = x;
+        sw->y0 = y;
+    }
 
-            fd = test_fd;
+    int slot = sw->n++ % SWIPE_HIST;
+    sw->hx[slot] = x;
+    sw->hy[slot] = y;
+    sw->ht[slot] = t;
+    if (sw->fired)
+        return LV_DIR_NONE;
+
+    int32_t dx = x - sw->x0, dy = y - sw->y0;
+    int32_t adx = dx < 0 ? -dx : dx, ady = dy < 0 ? -dy : dy;
+    bool hor = adx >= SWIPE_MIN_PX && adx > 2 * ady;
+    bool ver = ady >= SWIPE_MIN_PX && ady > 2 * adx;
+    if (!hor && !ver)
+        return LV_DIR_NONE;
+
+    /* Oldest kept sample inside the speed window */
+    int kept = sw->n < SWIPE_HIST ? sw->n : SWIPE_HIST;
+    int old = slot;
+    for (int k = 1; k < kept; k++) {
+        int i = (slot - k + SWIPE_HIST) % SWIPE_HIST;
+        if (t - sw->ht[i] > SWIPE_WINDOW_US)
             break;
+        old = i;
+    }
+    uint64_t dt = t - sw->ht[old];
+    if (dt == 0)
+        return LV_DIR_NONE;
+
+    /* Movement in the swipe's direction over the window, in px/s */
+    int64_t moved = hor ? (dx < 0 ? sw->hx[old] - x : x - sw->hx[old])
+                        : (dy < 0 ? sw->hy[old] - y : y - sw->hy[old]);
+    if (moved * 1000000 < (int64_t)SWIPE_MIN_SPEED * (int64_t)dt)
+        return LV_DIR_NONE;
+
+    sw->fired = true;
+    if (hor)
+        return dx < 0 ? LV_DIR_LEFT : LV_DIR_RIGHT;
+    return dy < 0 ? LV_DIR_TOP : LV_DIR_BOTTOM;
+}
+
+/**
+ * Feed one evdev event into a device's decoder. On SYN_REPORT the
+ * assembled sample is queued for LVGL, unless another device is holding
+ * the pointer.
+ *
+ * @param dev      Source device
+ * @param owner    devs[] index of dev, or -1 for the replay source
+ * @param time_us  Event timestamp on the device's clock
+ * @return true if a sample was queued
+ */
+static bool decode_event(touch_dev_t *dev, int owner, uint16_t type,
+                         uint16_t code, int32_t value, uint64_t time_us)
+{
+    touch_decoder_t *d = &dev->dec;
+
+    if (type == EV_ABS) {
+        if (code == ABS_X)
+            d->raw_x = value;
+        else if (code == ABS_Y)
+            d->raw_y = value;
+        else if (code == ABS_PRESSURE)
+            d->pressed = (value > 0);
+        return false;
+    }
+    if (type == EV_KEY && code == BTN_TOUCH) {
+        d->pressed = (value != 0);
+        return false;
+    }
+    if (type != EV_SYN || code != SYN_REPORT)
+        return false;
+
+    int32_t rx = d->raw_x, ry = d->raw_y;
+
+    /* Median-of-3 removes single-sample spikes. It restarts with each
+     * press and passes the first two samples through, so it adds no
+     * delay to the touch-down itself */
+    if (filter_enabled && d->pressed) {
+        if (!d->st.pressed)
+            d->hist_n = 0;
+        d->hist_x[d->hist_n % 3] = rx;
+        d->hist_y[d->hist_n % 3] = ry;
+        if (++d->hist_n >= 3) {
+            rx = median3(d->hist_x[0], d->hist_x[1], d->hist_x[2]);
+            ry = median3(d->hist_y[0], d->hist_y[1], d->hist_y[2]);
         }
-        close(test_fd);
     }
 
-    closedir(dir);
-    return fd;
+    int16_t sx, sy;
+    calib_apply(dev, rx, ry, &sx, &sy);
+
+    /* Physical panel → logical screen, matching the display's
+     * configured rotation / mirroring */
+    display_driver_phys_to_logical(&sx, &sy);
+
+    d->st.gesture = d->pressed
+        ? (uint8_t)swipe_update(&d->swipe, !d->st.pressed, sx, sy, time_us)
+        : LV_DIR_NONE;
+
+    /* A release keeps the last pressed position. Only monotonic
+     * stamps are passed on, for latency measurement */
+    d->st.time_us = dev->mono ? time_us : 0;
+    d->st.pressed = d->pressed;
+    d->st.src = (int8_t)owner;
+    if (d->pressed) {
+        d->st.x = sx;
+        d->st.y = sy;
+        d->st.raw_x = rx;
+        d->st.raw_y = ry;
+    }
+
+    /* First finger down owns the pointer until it lifts */
+    if (owner >= 0) {
+        if (pointer_owner >= 0 && pointer_owner != owner)
+            return false;
+        pointer_owner = d->pressed ? owner : -1;
+    }
+
+#ifdef TOUCH_DEBUG
+    fprintf(stderr, "touch: %s x=%d y=%d (raw %d,%d)\n",
+            d->pressed ? "DOWN" : "UP  ", sx, sy, rx, ry);
+#endif
+
+    if (ring_push(&d->st))
+        return true;
+    if (d->dropped++ == 0)
+        fprintf(stderr, "touch_driver: sample ring full, dropping samples\n");
+    return false;
 }
 
 /* ------------------------------------------------------------------ */
-/*  Coordinate mapping                                                */
+/*  Recording                                                         */
 /* ------------------------------------------------------------------ */
 
-static int16_t map_axis(int32_t raw, int32_t raw_min, int32_t raw_max,
-                         int16_t screen_max)
+/**
+ * Append one event to the recording. Only the event kinds the decoder
+ * uses are kept, each as a 12-byte record with the time since the
+ * previous one (half the size of struct input_event). Only the device
+ * the recording was started on is recorded, also after a replug.
+ */
+static void record_event(const touch_dev_t *dev, const struct input_event *ev)
 {
-    if (raw_max <= raw_min) return 0;
-    int32_t mapped = (raw - raw_min) * screen_max / (raw_max - raw_min);
-    if (mapped < 0) return 0;
-    if (mapped >= screen_max) return screen_max - 1;
-    return (int16_t)mapped;
+    if (!rec_file || strcmp(dev->path, rec_dev_path) != 0) return;
+    if (ev->type != EV_ABS && ev->type != EV_KEY && ev->type != EV_SYN)
+        return;
+
+    uint64_t t = (uint64_t)ev->input_event_sec * 1000000u
+                 + (uint64_t)ev->input_event_usec;
+    uint64_t dt = rec_last_us && t > rec_last_us ? t - rec_last_us : 0;
+    rec_last_us = t;
+
+    rec_event_t re = {
+        .dt_us = dt > UINT32_MAX ? UINT32_MAX : (uint32_t)dt,
+        .type = ev->type, .code = ev->code, .value = ev->value,
+    };
+    if (fwrite(&re, sizeof(re), 1, rec_file) != 1) {
+        fprintf(stderr, "touch_driver: recording write failed, stopping\n");
+        fclose(rec_file);
+        rec_file = NULL;
+    }
+}
+
+/**
+ * Create the recording file and write the header for dev's axis ranges.
+ * Returns 0 on success.
+ */
+static int record_open(const char *path, const touch_dev_t *dev)
+{
+    rec_file = fopen(path, "wb");
+    if (!rec_file) {
+        fprintf(stderr, "touch_driver: cannot create %s: %s\n", path,
+                strerror(errno));
+        return -1;
+    }
+
+    rec_header_t hdr = {
+        .magic = REC_MAGIC, .version = REC_VERSION,
+        .abs_x_min = dev->abs_x_min, .abs_x_max = dev->abs_x_max,
+        .abs_y_min = dev->abs_y_min, .abs_y_max = dev->abs_y_max,
+    };
+    if (fwrite(&hdr, sizeof(hdr), 1, rec_file) != 1) {
+        fclose(rec_file);
+        rec_file = NULL;
+        return -1;
+    }
+
+    rec_last_us = 0;
+    snprintf(rec_dev_path, sizeof(rec_dev_path), "%s", dev->path);
+    fprintf(stderr, "touch_driver: recording %s to %s\n", dev->path, path);
+    return 0;
 }
 
 /* ------------------------------------------------------------------ */
 /*  Background event reading thread                                   */
 /* ------------------------------------------------------------------ */
 
+/**
+ * Handle queued inotify events: (re)open event nodes that appeared or
+ * became readable. Removal is noticed on the device fd itself.
+ */
+static void handle_hotplug(void)
+{
+    /* Aligned as inotify requires */
+    char buf[4096] __attribute__((aligned(__alignof__(struct inotify_event))));
+    ssize_t n;
+
+    while ((n = read(inotify_fd, buf, sizeof(buf))) > 0) {
+        for (char *p = buf; p < buf + n; ) {
+            const struct inotify_event *ie = (const struct inotify_event *)p;
+            if (ie->mask & IN_Q_OVERFLOW)
+                dev_scan();
+            else if (ie->len > 0 && !(ie->mask & IN_ISDIR))
+                dev_open(ie->name);
+            p += sizeof(*ie) + ie->len;
+        }
+    }
+}
+
+/** Queue a release for a device that vanished mid-press. */
+static bool release_lost_press(touch_dev_t *dev)
+{
+    touch_state_t st = dev->dec.st;
+
+    st.pressed = false;
+    st.gesture = LV_DIR_NONE;
+    st.time_us = dev->mono ? perf_now_us() : 0;
+    return ring_push(&st);
+}
+
 static void *touch_poll_thread_fn(void *arg)
 {
     (void)arg;
-    struct input_event ev;
-    int32_t raw_x = 0, raw_y = 0;
-    bool pressed = false;
+    struct input_event evs[EVENT_BATCH];
+    struct pollfd pfds[2 + MAX_TOUCH_DEVS];
+    int slot_of[2 + MAX_TOUCH_DEVS];
 
-    /* Grab exclusive access so no other process consumes our events */
-    if (ioctl(event_fd, EVIOCGRAB, 1) < 0) {
-        fprintf(stderr, "touch_driver: EVIOCGRAB failed (non-fatal): %s\n",
-                strerror(errno));
-    }
+    for (;;) {
+        /* The device set changes with hotplug, so rebuild each round */
+        int nfds = 0;
+        pfds[nfds++] = (struct pollfd){ .fd = stop_fd, .events = POLLIN };
+        pfds[nfds++] = (struct pollfd){ .fd = inotify_fd, .events = POLLIN };
+        for (int i = 0; i < MAX_TOUCH_DEVS; i++) {
+            if (devs[i].fd < 0) continue;
+            slot_of[nfds] = i;
+            pfds[nfds++] = (struct pollfd){ .fd = devs[i].fd, .events = POLLIN };
+        }
 
-    while (poll_running) {
-        ssize_t n = read(event_fd, &ev, sizeof(ev));
-        if (n < (ssize_t)sizeof(ev)) {
-            usleep(5000);
-            continue;
+        if (poll(pfds, (nfds_t)nfds, -1) < 0) {
+            if (errno == EINTR) continue;
+            fprintf(stderr, "touch_driver: poll failed: %s\n", strerror(errno));
+            break;
         }
+        if (pfds[0].revents)
+            break;   /* touch_driver_deinit() */
+
+        bool reported = false;
+        for (int k = 2; k < nfds; k++) {
+            if (!pfds[k].revents) continue;
+
+            int slot = slot_of[k];
+            touch_dev_t *dev = &devs[slot];
+            ssize_t n = read(dev->fd, evs, sizeof(evs));
 
-        if (ev.type == EV_ABS) {
-            if (ev.code == ABS_X)
-                raw_x = ev.value;
-            else if (ev.code == ABS_Y)
-                raw_y = ev.value;
-            else if (ev.code == ABS_PRESSURE)
-                pressed = (ev.value > 0);
-        } else if (ev.type == EV_KEY && ev.code == BTN_TOUCH) {
-            pressed = (ev.value != 0);
-        } else if (ev.type == EV_SYN && ev.code == SYN_REPORT) {
-            /* XPT2046 touch digitizer axes are rotated relative to the
-             * ILI9486 LCD in landscape (480×320) mode:
-             *   - Touch ABS_X maps to screen Y (inverted)
-             *   - Touch ABS_Y maps to screen X
-             * Swap and invert to get correct screen coordinates. */
-            int16_t sx = map_axis(raw_y, abs_y_min, abs_y_max, DISP_HOR_RES);
-            int16_t sy = (DISP_VER_RES - 1) -
-                         map_axis(raw_x, abs_x_min, abs_x_max, DISP_VER_RES);
-
-            pthread_mutex_lock(&touch_mutex);
-            touch_state.pressed = pressed;
-            if (pressed) {
-                touch_state.x = sx;
-                touch_state.y = sy;
+            /* ENODEV (or POLLHUP) once the device is unplugged or its
+             * driver unbound; it comes back through inotify */
+            if (n < 0 && errno != EAGAIN && errno != EINTR) {
+                if (dev_close(slot, "went away") && release_lost_press(dev))
+                    reported = true;
+                continue;
             }
-            pthread_mutex_unlock(&touch_mutex);
+            if (n < (ssize_t)sizeof(evs[0]))
+                continue;   /* EAGAIN — spurious wakeup */
 
-            fprintf(stderr, "touch: %s x=%d y=%d (raw %d,%d)\n",
-                    pressed ? "DOWN" : "UP  ", sx, sy, raw_x, raw_y);
+            int count = (int)(n / (ssize_t)sizeof(evs[0]));
+            for (int e = 0; e < count; e++) {
+                const struct input_event *ev = &evs[e];
+                uint64_t t = (uint64_t)ev->input_event_sec * 1000000u
+                             + (uint64_t)ev->input_event_usec;
+
+                record_event(dev, ev);
+                if (decode_event(dev, slot, ev->type, ev->code, ev->value, t))
+                    reported = true;
+            }
         }
+        if (rec_file)
+            fflush(rec_file);
+
+        /* Devices go first so a replug's fresh node is not confused
+         * with the dead one still open under the same name */
+        if (pfds[1].revents)
+            handle_hotplug();
+
+        /* One main-loop wakeup per batch, however many reports it held */
+        if (reported)
+            event_loop_wake();
     }
 
-    /* Release grab on exit */
-    ioctl(event_fd, EVIOCGRAB, 0);
+    for (int i = 0; i < MAX_TOUCH_DEVS; i++)
+        dev_close(i, NULL);
+    return NULL;
+}
+
+/* ------------------------------------------------------------------ */
+/*  Replay thread                                                     */
+/* ------------------------------------------------------------------ */
+
+/**
+ * Play a recording back through the decoder, pacing each event by its
+ * recorded delay divided by replay_speed. Samples are stamped with the
+ * time they are actually injected, so latency metrics stay meaningful.
+ */
+static void *touch_replay_thread_fn(void *arg)
+{
+    (void)arg;
+    struct pollfd pfd = { .fd = stop_fd, .events = POLLIN };
+    uint64_t due = perf_now_us();
+    unsigned long events = 0;
+    rec_event_t re;
+
+    while (fread(&re, sizeof(re), 1, replay_file) == 1) {
+        due += (uint64_t)(re.dt_us / replay_speed);
+
+        /* Sleep until the absolute due time, so rounding up to whole
+         * milliseconds never accumulates drift */
+        uint64_t now = perf_now_us();
+        if (due > now) {
+            int wait_ms = (int)((due - now + 999) / 1000);
+            if (poll(&pfd, 1, wait_ms) > 0)
+                return NULL;   /* touch_driver_deinit() */
+        }
+
+        events++;
+        if (decode_event(&replay_dev, -1, re.type, re.code, re.value,
+                         perf_now_us()))
+            event_loop_wake();
+    }
+
+    fprintf(stderr, "touch_driver: replay finished (%lu events)\n", events);
     return NULL;
 }
 
@@ -210,35 +851,143 @@ static void touch_read_cb(lv_indev_t *indev_drv, lv_indev_data_t *data)
 {
     (void)indev_drv;
 
-    pthread_mutex_lock(&touch_mutex);
-    data->point.x = touch_state.x;
-    data->point.y = touch_state.y;
-    data->state   = touch_state.pressed ? LV_INDEV_STATE_PRESSED
-                                        : LV_INDEV_STATE_RELEASED;
-    pthread_mutex_unlock(&touch_mutex);
+    /* Deliver every queued sample in order; touch_driver_process reads
+     * until the ring is empty, so a tap whose DOWN and UP arrive
+     * between two wakes is still seen as a press and a release */
+    touch_state_t st = last_state;
+    bool fresh = ring_pop(&st);
+    if (fresh) {
+        last_state = st;
+        data->continue_reading = !ring_empty();
+    }
+
+    /* A new press may be claimed by the wake filter (screen blanked) */
+    if (st.pressed && !was_pressed) {
+        press_time_us = st.time_us;
+        if (wake_filter && wake_filter())
+            swallowing = true;
+    }
+    was_pressed = st.pressed;
+    if (!st.pressed)
+        swallowing = false;
+
+    /* A swipe counts once, from the sample that completed it */
+    if (fresh && st.gesture && st.pressed && !swallowing)
+        pending_gesture = (lv_dir_t)st.gesture;
+
+    data->point.x = st.x;
+    data->point.y = st.y;
+    data->state   = (st.pressed && !swallowing) ? LV_INDEV_STATE_PRESSED
+                                                : LV_INDEV_STATE_RELEASED;
 }
 
 /* ------------------------------------------------------------------ */
 /*  Public API                                                        */
 /* ------------------------------------------------------------------ */
 
-int touch_driver_init(void)
+/** Open a recording for replay and adopt its axis ranges. */
+static int replay_open(const char *path, double speed)
 {
-    /* Find a touchscreen input device */
-    event_fd = find_touch_device();
-    if (event_fd < 0) {
-        fprintf(stderr, "touch_driver_init: no touchscreen found in /dev/input/\n");
+    rec_header_t hdr;
+
+    replay_file = fopen(path, "rb");
+    if (!replay_file) {
+        fprintf(stderr, "touch_driver: cannot open %s: %s\n", path,
+                strerror(errno));
         return -1;
     }
+    if (fread(&hdr, sizeof(hdr), 1, replay_file) != 1 ||
+        hdr.magic != REC_MAGIC || hdr.version != REC_VERSION) {
+        fprintf(stderr, "touch_driver: %s is not a touch recording\n", path);
+        fclose(replay_file);
+        replay_file = NULL;
+        return -1;
+    }
+
+    memset(&replay_dev, 0, sizeof(replay_dev));
+    replay_dev.fd = -1;
+    replay_dev.abs_x_min = hdr.abs_x_min;
+    replay_dev.abs_x_max = hdr.abs_x_max;
+    replay_dev.abs_y_min = hdr.abs_y_min;
+    replay_dev.abs_y_max = hdr.abs_y_max;
+    calib_default(&replay_dev, replay_dev.def_calib);
+    replay_speed = speed > 0 ? speed : 1.0;
+
+    fprintf(stderr, "touch_driver: replaying %s at %.2gx\n", path,
+            replay_speed);
+    return 0;
+}
+
+int touch_driver_init(const touch_options_t *opts,
+                      const touch_config_t *cfg)
+{
+    void *(*thread_fn)(void *) = touch_poll_thread_fn;
+
+    for (int i = 0; i < MAX_TOUCH_DEVS; i++)
+        devs[i].fd = -1;
+    pointer_owner = -1;
+
+    if (opts && opts->replay_path) {
+        /* No input device at all — samples come from the file */
+        if (replay_open(opts->replay_path, opts->replay_speed) != 0)
+            return -1;
+        replay_dev.mono = true;   /* Replay stamps with perf_now_us() */
+        thread_fn = touch_replay_thread_fn;
+    } else {
+        /* Watch before scanning, so a device appearing in between is
+         * not missed */
+        inotify_fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+        if (inotify_fd < 0 ||
+            inotify_add_watch(inotify_fd, "/dev/input",
+                              IN_CREATE | IN_ATTRIB) < 0) {
+            fprintf(stderr, "touch_driver: cannot watch /dev/input (%s), "
+                    "hotplug disabled\n", strerror(errno));
+            if (inotify_fd >= 0) {
+                close(inotify_fd);
+                inotify_fd = -1;
+            }
+        }
+
+        if (dev_scan() == 0) {
+            if (inotify_fd < 0 || (opts && opts->record_path)) {
+                fprintf(stderr, "touch_driver_init: no touchscreen found in /dev/input/\n");
+                touch_driver_deinit();
+                return -1;
+            }
+            fprintf(stderr, "touch_driver_init: no touchscreen yet, "
+                    "waiting for one to appear\n");
+        }
+
+        if (opts && opts->record_path &&
+            record_open(opts->record_path, &devs[0]) != 0) {
+            touch_driver_deinit();
+            return -1;
+        }
+    }
+
+    /* Mapping: saved calibration on its own device, else each device's
+     * own default */
+    if (cfg && cfg->calibrated) {
+        memcpy(calib_slot[0].m, cfg->calib, sizeof(calib_slot[0].m));
+        snprintf(calib_slot[0].device, sizeof(calib_slot[0].device), "%s",
+                 cfg->device);
+        if (cfg->device[0] == '\0')
+            fprintf(stderr, "touch_driver: calibration names no device, "
+                    "using it for the first one found\n");
+    }
+    atomic_store(&calib_active, 0);
+    atomic_store(&calib_gen, cfg && cfg->calibrated ? 1u : 0u);
+    filter_enabled = cfg && cfg->filter;
 
     /* Start event reading thread */
-    poll_running = true;
-    if (pthread_create(&poll_thread, NULL, touch_poll_thread_fn, NULL) != 0) {
+    stop_fd = eventfd(0, EFD_CLOEXEC);
+    if (stop_fd < 0 ||
+        pthread_create(&poll_thread, NULL, thread_fn, NULL) != 0) {
         fprintf(stderr, "touch_driver_init: failed to create event thread\n");
-        close(event_fd);
-        event_fd = -1;
+        touch_driver_deinit();
         return -1;
     }
+    poll_running = true;
 
     /* Register with LVGL 9.x */
     indev = lv_indev_create();
@@ -250,21 +999,137 @@ int touch_driver_init(void)
 
     lv_indev_set_type(indev, LV_INDEV_TYPE_POINTER);
     lv_indev_set_read_cb(indev, touch_read_cb);
+    /* Read on demand from touch_driver_process(), not on a timer */
+    lv_indev_set_mode(indev, LV_INDEV_MODE_EVENT);
 
-    fprintf(stderr, "touch_driver_init: using Linux input subsystem\n");
+    fprintf(stderr, "touch_driver_init: using %s\n",
+            replay_file ? "recorded input" : "Linux input subsystem");
     return 0;
 }
 
+bool touch_driver_process(void)
+{
+    if (!indev) return false;
+
+    /* Keep reading while held so long-press and drag timing advance
+     * even when the finger is still and no new reports arrive */
+    if (ring_empty() && !was_pressed)
+        return false;
+
+    /* An event-mode read is not repeated for continue_reading, so drain
+     * the ring here, one read per sample. Bounded by the ring size so a
+     * busy producer cannot hold the loop */
+    for (int n = 0; n < TOUCH_RING_SIZE; n++) {
+        lv_indev_read(indev);
+
+        /* LVGL has now seen the swipe's samples. Hide the rest of the
+         * press from it, so lifting the finger is not also a click */
+        if (pending_gesture != LV_DIR_NONE) {
+            lv_dir_t dir = pending_gesture;
+            pending_gesture = LV_DIR_NONE;
+            if (gesture_cb) {
+                lv_indev_wait_release(indev);
+                gesture_cb(dir);
+            }
+        }
+
+        if (ring_empty())
+            break;
+    }
+
+    return was_pressed;
+}
+
+void touch_driver_get_raw(int32_t *raw_x, int32_t *raw_y)
+{
+    *raw_x = last_state.raw_x;
+    *raw_y = last_state.raw_y;
+}
+
+bool touch_driver_get_source(touch_device_info_t *info)
+{
+    int src = last_state.src;
+    const touch_dev_t *dev = src >= 0 ? &devs[src] : &replay_dev;
+    bool ok;
+
+    memset(info, 0, sizeof(*info));
+    pthread_mutex_lock(&dev_lock);
+    ok = src < 0 || dev->fd >= 0;
+    if (ok) {
+        snprintf(info->id, sizeof(info->id), "%s", dev->id);
+        info->abs_x_min = dev->abs_x_min;
+        info->abs_x_max = dev->abs_x_max;
+        info->abs_y_min = dev->abs_y_min;
+        info->abs_y_max = dev->abs_y_max;
+    }
+    pthread_mutex_unlock(&dev_lock);
+    return ok;
+}
+
+void touch_driver_set_calibration(const int32_t calib[6], const char *device)
+{
+    int spare = !atomic_load(&calib_active);
+
+    memcpy(calib_slot[spare].m, calib, sizeof(calib_slot[spare].m));
+    snprintf(calib_slot[spare].device, sizeof(calib_slot[spare].device),
+             "%s", device ? device : "");
+    atomic_store_explicit(&calib_active, spare, memory_order_release);
+    atomic_fetch_add_explicit(&calib_gen, 1, memory_order_release);
+}
+
+uint64_t touch_driver_press_time_us(void)
+{
+    return press_time_us;
+}
+
+void touch_driver_set_wake_filter(touch_wake_filter_t filter)
+{
+    wake_filter = filter;
+    swallowing = false;
+}
+
+void touch_driver_set_gesture_cb(touch_gesture_cb_t cb)
+{
+    gesture_cb = cb;
+    pending_gesture = LV_DIR_NONE;
+}
+
+touch_gesture_cb_t touch_driver_get_gesture_cb(void)
+{
+    return gesture_cb;
+}
+
 void touch_driver_deinit(void)
 {
     if (poll_running) {
-        poll_running = false;
+        uint64_t one = 1;
+        ssize_t r = write(stop_fd, &one, sizeof(one));
+        (void)r;
         pthread_join(poll_thread, NULL);
+        poll_running = false;
+    }
+
+    if (stop_fd >= 0) {
+        close(stop_fd);
+        stop_fd = -1;
     }
 
-    if (event_fd >= 0) {
-        close(event_fd);
-        event_fd = -1;
+    /* Normally closed by the thread; this covers a failed init */
+    for (int i = 0; i < MAX_TOUCH_DEVS; i++)
+        dev_close(i, NULL);
+
+    if (inotify_fd >= 0) {
+        close(inotify_fd);
+        inotify_fd = -1;
+    }
+
+    if (rec_file) {
+        fclose(rec_file);
+        rec_file = NULL;
+    }
+    if (replay_file) {
+        fclose(replay_file);
+        replay_file = NULL;
     }
 
     indev = NULL;
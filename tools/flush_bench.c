@@ -0,0 +1,327 @@
+/**
+ * flush_bench.c — Off-device benchmark of the framebuffer flush paths
+ *
+ * Builds without LVGL (make flush-bench). Times one full 480×320 frame
+ * flushed as DRAW_BUF_LINES-line strips into an XRGB8888 framebuffer,
+ * the HDMI fb0 fallback case, three ways:
+ *   - rgb565: the old per-pixel RGB565 -> XRGB8888 up-conversion
+ *   - native: rendering in the fb's own format, fb_blit_area()
+ *   - bgr:    the same plus fb_blit_swap_rb() for BGR-ordered fbs
+ *
+ * native and bgr link src/fb_blit.c, the code display_driver.c flushes
+ * with; only the rgb565 baseline, which no longer ships, is a copy.
+ *
+ * Then times every orientation (0°, 90°, 180°, 270°, left-right and
+ * top-bottom mirror) for RGB565 and XRGB8888 framebuffers, through the
+ * scalar blits and, when built with NEON, the NEON transpose, each
+ * against the unrotated memcpy. Before timing, each variant is checked
+ * pixel for pixel against an independent reference mapping, over full
+ * strips and over odd-sized areas that leave partial tiles; a mismatch
+ * fails the run.
+ *
+ * Reports the best-of-runs time per frame for each.
+ */
+
+#include "fb_blit.h"
+
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define HOR_RES        480
+#define VER_RES        320
+#define DRAW_BUF_LINES 10
+#define FRAMES         200
+#define RUNS           5
+
+static uint64_t now_us(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000u + (uint64_t)ts.tv_nsec / 1000u;
+}
+
+/* ------------------------------------------------------------------ */
+/*  Flush paths                                                       */
+/* ------------------------------------------------------------------ */
+
+/** Old path: RGB565 draw buffer up-converted pixel by pixel. */
+static void flush_rgb565(const uint8_t *px, uint32_t *fb, int y1, int y2)
+{
+    const uint16_t *src = (const uint16_t *)px;
+
+    for (int y = y1; y <= y2; y++) {
+        uint32_t *dst = fb + (size_t)y * HOR_RES;
+        for (int x = 0; x < HOR_RES; x++) {
+            uint16_t c = src[(y - y1) * HOR_RES + x];
+            uint8_t r = (uint8_t)(((c >> 11) & 0x1F) << 3);
+            uint8_t g = (uint8_t)(((c >> 5) & 0x3F) << 2);
+            uint8_t b = (uint8_t)((c & 0x1F) << 3);
+            dst[x] = 0xFF000000u | ((uint32_t)r << 16) | ((uint32_t)g << 8) | b;
+        }
+    }
+}
+
+/** New path: XRGB8888 draw buffer placed by the driver's blit. */
+static void flush_native(const fb_blit_t *b, const uint8_t *px, int y1,
+                         int y2)
+{
+    fb_blit_area(b, px, 0, y1, HOR_RES - 1, y2);
+}
+
+static void flush_bgr(const fb_blit_t *b, uint8_t *px, int y1, int y2)
+{
+    fb_blit_swap_rb(px, (uint32_t)HOR_RES * (uint32_t)(y2 - y1 + 1), 4);
+    flush_native(b, px, y1, y2);
+}
+
+/* ------------------------------------------------------------------ */
+/*  Timing                                                            */
+/* ------------------------------------------------------------------ */
+
+enum { PATH_RGB565, PATH_NATIVE, PATH_BGR };
+
+/** Best time of RUNS runs of FRAMES frames, in microseconds per frame. */
+static double bench(int path, uint8_t *px, uint32_t *fb)
+{
+    fb_blit_t b;
+    fb_blit_setup(&b, (uint8_t *)fb, HOR_RES * 4, 4, HOR_RES, VER_RES, 0,
+                  false, false);
+
+    uint64_t best = UINT64_MAX;
+
+    for (int run = 0; run < RUNS; run++) {
+        uint64_t t0 = now_us();
+        for (int f = 0; f < FRAMES; f++) {
+            for (int y = 0; y < VER_RES; y += DRAW_BUF_LINES) {
+                int y2 = y + DRAW_BUF_LINES - 1;
+                if (path == PATH_RGB565)
+                    flush_rgb565(px, fb, y, y2);
+                else if (path == PATH_NATIVE)
+                    flush_native(&b, px, y, y2);
+                else
+                    flush_bgr(&b, px, y, y2);
+            }
+        }
+        uint64_t us = now_us() - t0;
+        if (us < best)
+            best = us;
+    }
+    return (double)best / FRAMES;
+}
+
+/* ------------------------------------------------------------------ */
+/*  Rotation and mirroring                                            */
+/* ------------------------------------------------------------------ */
+
+typedef struct {
+    const char *name;
+    int  rotation;
+    bool mirror_h, mirror_v;
+} orient_t;
+
+static const orient_t orients[] = {
+    { "0",        0,   false, false },
+    { "90",       90,  false, false },
+    { "180",      180, false, false },
+    { "270",      270, false, false },
+    { "mirror-h", 0,   true,  false },
+    { "mirror-v", 0,   false, true  },
+};
+
+/** Test pattern value of logical pixel (x, y), unique per pixel. */
+static uint32_t pattern(int32_t x, int32_t y, uint32_t px_bytes)
+{
+    uint32_t v = (uint32_t)y * 2039u + (uint32_t)x * 7u + 1u;
+    return px_bytes == 2 ? (v & 0xFFFFu) ^ ((uint32_t)y >> 5) : v;
+}
+
+/** Fill a w×h area starting at logical (x1, y1) with the pattern. */
+static void fill_area(uint8_t *px, uint32_t px_bytes, int32_t x1, int32_t y1,
+                      int32_t w, int32_t h)
+{
+    for (int32_t j = 0; j < h; j++) {
+        for (int32_t i = 0; i < w; i++) {
+            uint32_t v = pattern(x1 + i, y1 + j, px_bytes);
+            uint8_t *p = px + ((size_t)j * w + i) * px_bytes;
+            if (px_bytes == 2)
+                *(uint16_t *)p = (uint16_t)v;
+            else
+                *(uint32_t *)p = v;
+        }
+    }
+}
+
+/**
+ * Check a w×h area at logical (x1, y1) in the framebuffer, mapping each
+ * logical pixel onto the panel from the orientation's definition (not
+ * from fb_blit_setup's offsets). Returns the number of wrong pixels.
+ */
+static long verify_area(const uint8_t *fb, uint32_t px_bytes,
+                        const orient_t *o, int32_t x1, int32_t y1,
+                        int32_t w, int32_t h)
+{
+    bool swap = (o->rotation == 90 || o->rotation == 270);
+    int32_t lw = swap ? VER_RES : HOR_RES, lh = swap ? HOR_RES : VER_RES;
+    long bad = 0;
+
+    for (int32_t ly = y1; ly < y1 + h; ly++) {
+        for (int32_t lx = x1; lx < x1 + w; lx++) {
+            int32_t mx = o->mirror_h ? lw - 1 - lx : lx;
+            int32_t my = o->mirror_v ? lh - 1 - ly : ly;
+            int32_t px, py;
+            switch (o->rotation) {
+            case 90:  px = HOR_RES - 1 - my; py = mx;               break;
+            case 180: px = HOR_RES - 1 - mx; py = VER_RES - 1 - my; break;
+            case 270: px = my;               py = VER_RES - 1 - mx; break;
+            default:  px = mx;               py = my;               break;
+            }
+
+            const uint8_t *p = fb + ((size_t)py * HOR_RES + px) * px_bytes;
+            uint32_t got = px_bytes == 2 ? *(const uint16_t *)p
+                                         : *(const uint32_t *)p;
+            if (got != pattern(lx, ly, px_bytes))
+                bad++;
+        }
+    }
+    return bad;
+}
+
+/**
+ * Flush a whole frame and a few odd-sized areas through b and check
+ * them. Returns the number of wrong pixels.
+ */
+static long verify(const fb_blit_t *b, const orient_t *o, uint8_t *px)
+{
+    /* Strips as LVGL sends them, then areas with partial 8×8 blocks and
+     * partial tiles on every edge */
+    static const int32_t odd[][4] = {
+        { 0, 0, 1, 1 }, { 3, 5, 97, 37 }, { 17, 9, 8, 8 },
+        { 1, 2, 31, 15 }, { 40, 60, 200, 10 },
+    };
+    long bad = 0;
+
+    memset(b->fb, 0, (size_t)HOR_RES * VER_RES * b->px_bytes);
+    for (int32_t y = 0; y < b->log_h; y += DRAW_BUF_LINES) {
+        fill_area(px, b->px_bytes, 0, y, b->log_w, DRAW_BUF_LINES);
+        fb_blit_area(b, px, 0, y, b->log_w - 1, y + DRAW_BUF_LINES - 1);
+    }
+    bad += verify_area(b->fb, b->px_bytes, o, 0, 0, b->log_w, b->log_h);
+
+    for (size_t k = 0; k < sizeof(odd) / sizeof(odd[0]); k++) {
+        int32_t x1 = odd[k][0], y1 = odd[k][1], w = odd[k][2], h = odd[k][3];
+        memset(b->fb, 0, (size_t)HOR_RES * VER_RES * b->px_bytes);
+        fill_area(px, b->px_bytes, x1, y1, w, h);
+        fb_blit_area(b, px, x1, y1, x1 + w - 1, y1 + h - 1);
+        bad += verify_area(b->fb, b->px_bytes, o, x1, y1, w, h);
+    }
+    return bad;
+}
+
+/** Best per-frame time of a full-frame strip flush through b. */
+static double bench_blit(const fb_blit_t *b, const uint8_t *px)
+{
+    uint64_t best = UINT64_MAX;
+
+    for (int run = 0; run < RUNS; run++) {
+        uint64_t t0 = now_us();
+        for (int f = 0; f < FRAMES; f++) {
+            for (int32_t y = 0; y < b->log_h; y += DRAW_BUF_LINES)
+                fb_blit_area(b, px, 0, y, b->log_w - 1,
+                             y + DRAW_BUF_LINES - 1);
+        }
+        uint64_t us = now_us() - t0;
+        if (us < best)
+            best = us;
+    }
+    return (double)best / FRAMES;
+}
+
+/**
+ * Time and check every orientation for one framebuffer depth.
+ * Returns the number of wrong pixels over all variants.
+ */
+static long bench_rotations(uint32_t px_bytes, uint8_t *fb, uint8_t *px)
+{
+    double base = 0;
+    long bad_total = 0;
+
+    printf("flush_bench: %s framebuffer, all orientations\n",
+           px_bytes == 2 ? "RGB565" : "XRGB8888");
+
+    for (size_t k = 0; k < sizeof(orients) / sizeof(orients[0]); k++) {
+        const orient_t *o = &orients[k];
+        bool transposed = (o->rotation == 90 || o->rotation == 270);
+
+        /* NEON only changes the 16 bpp transpose */
+        for (int neon = 0; neon <= 1; neon++) {
+            if (neon && !(fb_blit_have_neon() && transposed && px_bytes == 2))
+                continue;
+
+            fb_blit_t b;
+            fb_blit_setup(&b, fb, HOR_RES * px_bytes, px_bytes, HOR_RES,
+                          VER_RES, o->rotation, o->mirror_h, o->mirror_v);
+            b.neon = neon;
+
+            long bad = verify(&b, o, px);
+            bad_total += bad;
+
+            fill_area(px, px_bytes, 0, 0, b.log_w, DRAW_BUF_LINES);
+            double us = bench_blit(&b, px);
+            if (k == 0)
+                base = us;
+
+            const char *path = b.step_x == (ptrdiff_t)px_bytes ? "memcpy"
+                             : transposed ? (neon ? "tiled-neon" : "tiled")
+                             : "rows";
+            printf("flush_bench:   %-8s %-10s %8.1f us/frame  %+7.1f vs "
+                   "memcpy%s\n", o->name, path, us, us - base,
+                   bad ? "  MISMATCH" : "");
+        }
+    }
+    return bad_total;
+}
+
+int main(void)
+{
+    static const char *names[] = { "rgb565", "native", "bgr" };
+    size_t strip = (size_t)HOR_RES * DRAW_BUF_LINES * 4;
+    uint8_t *px = malloc(strip);
+    uint32_t *fb = malloc((size_t)HOR_RES * VER_RES * 4);
+
+    if (!px || !fb) {
+        fprintf(stderr, "flush_bench: out of memory\n");
+        return 1;
+    }
+    for (size_t i = 0; i < strip; i++)
+        px[i] = (uint8_t)(i * 7);
+
+    printf("flush_bench: %dx%d XRGB8888 frame, %d-line strips, best of %d\n",
+           HOR_RES, VER_RES, DRAW_BUF_LINES, RUNS);
+    for (int p = PATH_RGB565; p <= PATH_BGR; p++)
+        printf("flush_bench: %-6s %8.1f us/frame\n", names[p],
+               bench(p, px, fb));
+
+    /* Keep the stores observable */
+    uint32_t sum = 0;
+    for (size_t i = 0; i < (size_t)HOR_RES * VER_RES; i += 997)
+        sum += fb[i];
+    printf("flush_bench: checksum %08x\n", sum);
+
+    /* Rotated strips are at most VER_RES wide, so the strip and frame
+     * buffers above are big enough for every orientation */
+    printf("flush_bench: rotation paths: %s\n",
+           fb_blit_have_neon() ? "scalar and NEON" : "scalar (no NEON build)");
+    long bad = bench_rotations(2, (uint8_t *)fb, px) +
+               bench_rotations(4, (uint8_t *)fb, px);
+
+    free(px);
+    free(fb);
+    if (bad) {
+        fprintf(stderr, "flush_bench: %ld pixels placed wrongly\n", bad);
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,203 @@
+#!/usr/bin/env python3
+"""
+gen_fonts.py — Generate subset UI fonts with only the glyphs in use
+
+Collects every character the dashboard can draw in its own fonts:
+  - string literals in the UI sources (log lines excluded), with digits
+    for any printf-style number
+  - LV_SYMBOL_* names used there, resolved via LVGL's lv_symbol_def.h
+  - the label and icon of every light in the config file
+
+and runs lv_font_conv once per size to write src/fonts/ui_subset_<N>.c:
+Montserrat for text, FontAwesome for the symbols, exactly as LVGL's
+built-in fonts are made, but with only those glyphs. Each font falls
+back to LV_FONT_DEFAULT for anything else.
+
+Prints the glyph count and table size of each font it writes.
+
+Usage: gen_fonts.py [--config FILE] [--out DIR] [--compress]
+                    [--lvgl DIR] [--font-conv CMD]
+"""
+
+import argparse
+import json
+import os
+import re
+import shlex
+import subprocess
+import sys
+
+SIZES = (16, 24, 32)
+BPP = 4
+
+# Sources that draw text in the UI fonts (ui_fonts.h)
+UI_SOURCES = ("src/light_ui.c",)
+
+# Always available: page counter ("3 / 12") and "..." truncation
+ALWAYS = "0123456789 ./"
+
+STRING_RE = re.compile(r'"((?:[^"\\\n]|\\.)*)"')
+SYMBOL_RE = re.compile(r"\bLV_SYMBOL_([A-Z0-9_]+)\b")
+LOG_RE = re.compile(r"\b(?:fprintf|printf|perror|log_heap)\s*\(")
+
+
+def c_unescape(text):
+    """Decode a C string literal body (as UTF-8)."""
+    out = bytearray()
+    i = 0
+    while i < len(text):
+        c = text[i]
+        if c != "\\":
+            out += c.encode("utf-8")
+            i += 1
+            continue
+        nxt = text[i + 1]
+        if nxt == "x":
+            m = re.match(r"[0-9a-fA-F]{1,2}", text[i + 2:])
+            out.append(int(m.group(0), 16))
+            i += 2 + len(m.group(0))
+        else:
+            out += {"n": b"\n", "t": b"\t", "0": b"\0"}.get(
+                nxt, nxt.encode("utf-8"))
+            i += 2
+    return out.decode("utf-8", errors="replace")
+
+
+def load_symbols(lvgl_dir):
+    """Map LV_SYMBOL_* names to their code points."""
+    path = os.path.join(lvgl_dir, "src", "font", "lv_symbol_def.h")
+    symbols = {}
+    try:
+        with open(path, encoding="utf-8") as f:
+            for line in f:
+                m = re.match(r'\s*#define\s+LV_SYMBOL_(\w+)\s+"([^"]*)"', line)
+                if m:
+                    text = c_unescape(m.group(2))
+                    if len(text) == 1:
+                        symbols[m.group(1)] = ord(text)
+    except OSError as e:
+        sys.exit(f"gen_fonts: {path}: {e.strerror} (is the lvgl "
+                 f"submodule checked out?)")
+    return symbols
+
+
+def scan_sources(symbols):
+    """Characters and symbol code points drawn by the UI sources."""
+    chars = set(ALWAYS)
+    codes = set()
+    for path in UI_SOURCES:
+        in_log = False
+        with open(path, encoding="utf-8") as f:
+            for line in f:
+                # Skip log calls to the end of their statement, and includes
+                if in_log or LOG_RE.search(line):
+                    in_log = ";" not in line
+                    continue
+                if line.lstrip().startswith("#include"):
+                    continue
+                for name in SYMBOL_RE.findall(line):
+                    if name in symbols:
+                        codes.add(symbols[name])
+                for lit in STRING_RE.findall(line):
+                    text = c_unescape(lit)
+                    # Format directives draw their argument, not themselves
+                    text = re.sub(r"%[-+ #0-9.]*[a-z]", "", text)
+                    chars.update(c for c in text if c >= " ")
+    return chars, codes
+
+
+def scan_config(path):
+    """Characters in the configured lights' labels and icons."""
+    chars = set()
+    try:
+        with open(path, encoding="utf-8") as f:
+            cfg = json.load(f)
+    except OSError:
+        print(f"gen_fonts: no config at {path}, UI strings only",
+              file=sys.stderr)
+        return chars
+    except ValueError as e:
+        sys.exit(f"gen_fonts: {path}: {e}")
+    for light in cfg.get("lights", []):
+        chars.update(light.get("label", ""))
+        chars.update(light.get("icon", ""))
+    return chars
+
+
+def table_size(path):
+    """Glyph count and bitmap bytes of a generated font."""
+    with open(path, encoding="utf-8") as f:
+        src = f.read()
+    bitmap = re.search(r"glyph_bitmap\[\]\s*=\s*\{(.*?)\};", src, re.S)
+    glyphs = re.search(r"glyph_dsc\[\]\s*=\s*\{(.*?)\};", src, re.S)
+    nbytes = len(re.findall(r"0x[0-9a-fA-F]{2}", bitmap.group(1))) \
+        if bitmap else 0
+    nglyphs = glyphs.group(1).count("{") - 1 if glyphs else 0
+    return nglyphs, nbytes
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__.split("\n")[1])
+    ap.add_argument("--config", default="/etc/ha_lights.conf")
+    ap.add_argument("--out", default="src/fonts")
+    ap.add_argument("--lvgl", default="lvgl")
+    ap.add_argument("--compress", action="store_true",
+                    help="RLE-compress the bitmaps (needs "
+                         "LV_USE_FONT_COMPRESSED)")
+    ap.add_argument("--font-conv", default="lv_font_conv")
+    args = ap.parse_args()
+
+    symbols = load_symbols(args.lvgl)
+    chars, codes = scan_sources(symbols)
+    chars |= scan_config(args.config)
+
+    # Private-use code points are symbols, whatever their source
+    codes |= {ord(c) for c in chars if 0xE000 <= ord(c) <= 0xF8FF}
+    text = "".join(sorted(c for c in chars if not 0xE000 <= ord(c) <= 0xF8FF))
+
+    fonts_dir = os.path.join(args.lvgl, "scripts", "built_in_font")
+    os.makedirs(args.out, exist_ok=True)
+    print(f"gen_fonts: {len(text)} characters, {len(codes)} symbols")
+
+    for size in SIZES:
+        name = f"ui_subset_{size}"
+        out = os.path.join(args.out, name + ".c")
+        cmd = shlex.split(args.font_conv) + [
+            "--bpp", str(BPP), "--size", str(size), "--format", "lvgl",
+            "--lv-font-name", name, "-o", out,
+            "--font", os.path.join(fonts_dir, "Montserrat-Medium.ttf"),
+            "--symbols", text,
+        ]
+        if codes:
+            cmd += ["--font",
+                    os.path.join(fonts_dir,
+                                 "FontAwesome5-Solid+Brands+Regular.woff"),
+                    "--range", ",".join(f"0x{c:X}" for c in sorted(codes))]
+        if not args.compress:
+            cmd += ["--no-compress", "--no-prefilter"]
+        try:
+            subprocess.run(cmd, check=True)
+        except (OSError, subprocess.CalledProcessError) as e:
+            sys.exit(f"gen_fonts: {args.font_conv} failed: {e} "
+                     f"(npm install -g lv_font_conv)")
+
+        with open(out, encoding="utf-8") as f:
+            src = f.read()
+        if ".fallback = NULL" not in src:
+            sys.exit(f"gen_fonts: {out}: no fallback field to set")
+        src = src.replace(".fallback = NULL", ".fallback = LV_FONT_DEFAULT")
+        if args.compress:
+            # A compressed table needs LVGL's decompressor
+            src += ("\n#if !LV_USE_FONT_COMPRESSED\n#error \"" + name +
+                    ": generated compressed, build with FONT_COMPRESS=1\"\n"
+                    "#endif\n")
+        with open(out, "w", encoding="utf-8") as f:
+            f.write(src)
+
+        nglyphs, nbytes = table_size(out)
+        print(f"gen_fonts: {out}: {nglyphs} glyphs, {nbytes} bitmap bytes"
+              f"{' (compressed)' if args.compress else ''}")
+
+
+if __name__ == "__main__":
+    main()
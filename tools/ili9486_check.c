@@ -0,0 +1,340 @@
+/**
+ * ili9486_check.c — Off-device check and benchmark of the ILI9486 encoder
+ *
+ * Builds on any host with just src/ili9486.c (make check-ili9486). Drives
+ * ili9486_init() and ili9486_write_area() into the memory sink and
+ * checks the recorded stream:
+ *   - init sequence: SLPOUT first, COLMOD 16 bpp, MADCTL, DISPON last
+ *   - CASET / RASET / RAMWR order with big-endian range parameters
+ *   - pixels byte-swapped to big-endian RGB565
+ *   - pixel data split at max_xfer boundaries
+ *   - an unchanged window not resent; a full-width strip only resends
+ *     RASET
+ *   - each open transport caching its own window
+ *   - reg16: commands and parameters as 16-bit words, pixels unchanged
+ *   - recording stops for good once the sink is full
+ *
+ * Then times full-frame encodes into the sink.
+ *
+ * Exit status is 0 when every check passes.
+ */
+
+#include "ili9486.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+/* ------------------------------------------------------------------ */
+/*  Stream parsing                                                    */
+/* ------------------------------------------------------------------ */
+
+#define MAX_RECORDS 64
+
+/** One transfer as recorded by the sink. */
+typedef struct {
+    bool           data;
+    size_t         len;
+    const uint8_t *buf;
+} record_t;
+
+static record_t rec[MAX_RECORDS];
+static int      rec_count;
+static int      failures;
+static int      checks;
+
+/** Split the memory sink's recording into records (first MAX_RECORDS). */
+static void parse(ili9486_transport_t *t)
+{
+    size_t len = 0;
+    const uint8_t *p = ili9486_mem_sink_data(t, &len);
+    size_t off = 0;
+
+    rec_count = 0;
+    while (p && off + 5 <= len && rec_count < MAX_RECORDS) {
+        record_t *r = &rec[rec_count++];
+        r->data = p[off] != 0;
+        r->len = (size_t)p[off + 1] | (size_t)p[off + 2] << 8 |
+                 (size_t)p[off + 3] << 16 | (size_t)p[off + 4] << 24;
+        r->buf = p + off + 5;
+        off += 5 + r->len;
+    }
+}
+
+static void check(bool ok, const char *what)
+{
+    checks++;
+    if (!ok) {
+        failures++;
+        fprintf(stderr, "FAIL: %s\n", what);
+    }
+}
+
+/** Is record i the command byte cmd? */
+static bool is_cmd(int i, uint8_t cmd)
+{
+    return i < rec_count && !rec[i].data && rec[i].len == 1 &&
+           rec[i].buf[0] == cmd;
+}
+
+/** Is record i a data transfer equal to the n bytes at want? */
+static bool is_data(int i, const uint8_t *want, size_t n)
+{
+    return i < rec_count && rec[i].data && rec[i].len == n &&
+           memcmp(rec[i].buf, want, n) == 0;
+}
+
+/** Fill n little-endian RGB565 pixels with a known pattern. */
+static void fill(uint8_t *px, size_t n)
+{
+    for (size_t i = 0; i < n; i++) {
+        px[2 * i] = (uint8_t)i;              /* Low byte  */
+        px[2 * i + 1] = (uint8_t)(0x80 | i); /* High byte */
+    }
+}
+
+/* ------------------------------------------------------------------ */
+/*  Checks                                                            */
+/* ------------------------------------------------------------------ */
+
+static void check_init(ili9486_transport_t *t)
+{
+    uint8_t madctl = ili9486_madctl(0, false, false);
+    static const uint8_t colmod[] = { 0x55 };
+
+    check(ili9486_init(t, madctl) == 0, "init returns 0");
+    parse(t);
+
+    check(is_cmd(0, 0x11), "init starts with SLPOUT");
+    check(is_cmd(1, 0x3A) && is_data(2, colmod, 1), "COLMOD 16 bpp");
+
+    bool found = false;
+    for (int i = 0; i + 1 < rec_count; i++)
+        if (is_cmd(i, 0x36) && is_data(i + 1, &madctl, 1))
+            found = true;
+    check(found, "MADCTL sent with its value");
+    check(is_cmd(rec_count - 1, 0x29), "init ends with DISPON");
+}
+
+static void check_window(ili9486_transport_t *t)
+{
+    uint8_t px[2 * 180];
+    uint8_t want[2 * 180];
+
+    /* 180×1 at x 300..479, y 258: ranges above 255 show the byte order */
+    static const uint8_t caset[] = { 0x01, 0x2C, 0x01, 0xDF };
+    static const uint8_t raset[] = { 0x01, 0x02, 0x01, 0x02 };
+
+    fill(px, 180);
+    for (int i = 0; i < 180; i++) {
+        want[2 * i] = px[2 * i + 1];
+        want[2 * i + 1] = px[2 * i];
+    }
+
+    ili9486_mem_sink_clear(t);
+    check(ili9486_write_area(t, 300, 258, 479, 258, px) == 0,
+          "write_area returns 0");
+    parse(t);
+    check(rec_count == 6, "new window: CASET, RASET, RAMWR + data");
+    check(is_cmd(0, 0x2A) && is_data(1, caset, 4), "CASET big-endian");
+    check(is_cmd(2, 0x2B) && is_data(3, raset, 4), "RASET big-endian");
+    check(is_cmd(4, 0x2C), "RAMWR after the window");
+    check(is_data(5, want, sizeof(want)), "pixels swapped to big-endian");
+
+    /* Same window again: only RAMWR and the pixels */
+    fill(px, 180);
+    ili9486_mem_sink_clear(t);
+    ili9486_write_area(t, 300, 258, 479, 258, px);
+    parse(t);
+    check(rec_count == 2 && is_cmd(0, 0x2C), "unchanged window not resent");
+
+    /* Next strip of the same columns: only RASET moves */
+    fill(px, 180);
+    ili9486_mem_sink_clear(t);
+    ili9486_write_area(t, 300, 259, 479, 259, px);
+    parse(t);
+    check(rec_count == 4 && is_cmd(0, 0x2B) && is_cmd(2, 0x2C),
+          "strip resends RASET only");
+
+    /* 7 pixels: four swapped as one 64-bit word, three in the tail */
+    fill(px, 7);
+    for (int i = 0; i < 7; i++) {
+        want[2 * i] = px[2 * i + 1];
+        want[2 * i + 1] = px[2 * i];
+    }
+    ili9486_mem_sink_clear(t);
+    ili9486_write_area(t, 300, 260, 306, 260, px);
+    parse(t);
+    check(rec_count > 0 && is_data(rec_count - 1, want, 2 * 7),
+          "odd-length area swapped to big-endian");
+}
+
+static void check_two_transports(ili9486_transport_t *t)
+{
+    uint8_t px[2 * 4];
+
+    /* t has just sent this window; a second sink has sent none */
+    ili9486_transport_t *u = ili9486_transport_open("mem", 0);
+    if (!u) {
+        check(false, "second memory sink opens");
+        return;
+    }
+
+    fill(px, 4);
+    ili9486_write_area(t, 10, 20, 13, 20, px);
+    fill(px, 4);
+    ili9486_write_area(u, 10, 20, 13, 20, px);
+    parse(u);
+    check(rec_count == 6 && is_cmd(0, 0x2A) && is_cmd(2, 0x2B),
+          "second transport sends its own window");
+
+    /* Writing through u must not have changed what t believes */
+    fill(px, 4);
+    ili9486_mem_sink_clear(t);
+    ili9486_write_area(t, 10, 20, 13, 20, px);
+    parse(t);
+    check(rec_count == 2 && is_cmd(0, 0x2C),
+          "first transport keeps its window");
+    ili9486_close(u);
+}
+
+static void check_chunks(ili9486_transport_t *t)
+{
+    uint8_t px[2 * 100];
+    size_t saved = t->max_xfer;
+
+    /* 200 bytes at 64-byte transfers: 64 + 64 + 64 + 8 */
+    t->max_xfer = 64;
+    fill(px, 100);
+    ili9486_mem_sink_clear(t);
+    ili9486_write_area(t, 0, 0, 99, 0, px);
+    parse(t);
+    t->max_xfer = saved;
+
+    int first = 0;
+    while (first < rec_count && !is_cmd(first, 0x2C))
+        first++;
+    first++;
+    check(rec_count - first == 4, "200 bytes in 4 transfers");
+    check(first + 3 < rec_count &&
+          rec[first].len == 64 && rec[first + 1].len == 64 &&
+          rec[first + 2].len == 64 && rec[first + 3].len == 8,
+          "chunks split at max_xfer");
+}
+
+static void check_reg16(ili9486_transport_t *t)
+{
+    uint8_t px[2 * 2];
+    static const uint8_t caset[] = { 0x00, 0x01, 0x00, 0x2C,
+                                     0x00, 0x01, 0x00, 0x2D };
+    static const uint8_t cmd[] = { 0x00, 0x2A };
+
+    /* A new window, so CASET and RASET are both sent */
+    t->reg16 = true;
+    fill(px, 2);
+    ili9486_mem_sink_clear(t);
+    ili9486_write_area(t, 300, 10, 301, 10, px);
+    parse(t);
+    t->reg16 = false;
+
+    check(rec_count == 6 && !rec[0].data && rec[0].len == 2 &&
+          memcmp(rec[0].buf, cmd, 2) == 0, "reg16 command as a word");
+    check(is_data(1, caset, sizeof(caset)), "reg16 parameters as words");
+    check(rec_count == 6 && rec[5].data && rec[5].len == sizeof(px),
+          "reg16 pixels unchanged");
+}
+
+static void check_full(ili9486_transport_t *t)
+{
+    size_t frame = 480 * 320 * 2;
+    uint8_t *px = calloc(1, frame);
+    size_t small = 2 * 10;
+    size_t len = 0, before = 0;
+
+    if (!px) {
+        check(false, "frame buffer allocation");
+        return;
+    }
+
+    /* Full frames until one is dropped, then a small write */
+    ili9486_mem_sink_clear(t);
+    for (int i = 0; i < 64; i++) {
+        ili9486_mem_sink_data(t, &before);
+        ili9486_write_area(t, 0, 0, 479, 319, px);
+        ili9486_mem_sink_data(t, &len);
+        if (len - before < frame)
+            break;
+    }
+    ili9486_mem_sink_data(t, &before);
+    uint64_t xfers = t->xfer_count;
+    ili9486_write_area(t, 0, 0, 9, 0, px);
+    ili9486_mem_sink_data(t, &len);
+    check(len == before, "nothing recorded after the sink is full");
+    check(t->xfer_count > xfers, "counters keep running when full");
+
+    ili9486_mem_sink_clear(t);
+    ili9486_write_area(t, 0, 0, 9, 0, px);
+    ili9486_mem_sink_data(t, &len);
+    check(len >= small, "clear starts recording again");
+    free(px);
+}
+
+/* ------------------------------------------------------------------ */
+/*  Benchmark                                                         */
+/* ------------------------------------------------------------------ */
+
+static uint64_t now_us(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000u + (uint64_t)ts.tv_nsec / 1000u;
+}
+
+/** Encode full 480×320 frames as 32-line strips, like a partial flush. */
+static void bench(ili9486_transport_t *t)
+{
+    const int frames = 200, lines = 32;
+    size_t strip = (size_t)480 * lines * 2;
+    uint8_t *px = malloc(strip);
+    if (!px) return;
+
+    memset(px, 0x5A, strip);
+    uint64_t bytes = t->byte_count;
+    uint64_t t0 = now_us();
+    for (int f = 0; f < frames; f++) {
+        ili9486_mem_sink_clear(t);
+        for (int y = 0; y < 320; y += lines)
+            ili9486_write_area(t, 0, y, 479, y + lines - 1, px);
+    }
+    uint64_t us = now_us() - t0;
+    bytes = t->byte_count - bytes;
+
+    printf("ili9486_check: %d frames in %llu us (%.1f us/frame, "
+           "%.1f MB/s encoded, %zu-byte transfers)\n", frames,
+           (unsigned long long)us, (double)us / frames,
+           us ? (double)bytes / (double)us : 0.0, t->max_xfer);
+    free(px);
+}
+
+int main(void)
+{
+    ili9486_transport_t *t = ili9486_transport_open("mem", 0);
+    if (!t) {
+        fprintf(stderr, "ili9486_check: cannot open the memory sink\n");
+        return 1;
+    }
+
+    check_init(t);
+    check_window(t);
+    check_two_transports(t);
+    check_chunks(t);
+    check_reg16(t);
+    check_full(t);
+    bench(t);
+    ili9486_close(t);
+
+    printf("ili9486_check: %d of %d checks passed\n", checks - failures,
+           checks);
+    return failures ? 1 : 0;
+}